@@ -0,0 +1,175 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "Quaternion.h"
+#include "Parallel.h"
+
+///Keys of a uniformly sampled clip in SoA form, frame-major:
+///bone b at frame f is element f * bones + b of every array.
+///Rotations (rx, ry, rz, rs) must be unit quaternions.
+template <typename T>
+struct ClipT {
+    const T* rx; const T* ry; const T* rz; const T* rs;
+    const T* tx; const T* ty; const T* tz;
+    size_t bones;
+    size_t frames;
+    T frameRate;  // frames per second
+
+    [[nodiscard]] constexpr T Duration() const {
+        return frames > 1 ? T(frames - 1) / frameRate : T(0);
+    }
+};
+
+///Local rotations and translations in SoA form, one element per bone
+template <typename T>
+struct PoseStreamT {
+    T* rx; T* ry; T* rz; T* rs;
+    T* tx; T* ty; T* tz;
+};
+
+namespace animation {
+    // Bones per inner block, the block loops are written so that
+    // compilers vectorize them across bones
+    constexpr size_t lanes = 16;
+    // Smallest amount of bones worth a thread
+    constexpr size_t chunk = 4096;
+
+    namespace detail {
+        // Eberly, "A Fast and Accurate Algorithm for Computing SLERP" (2011):
+        //   sin(t θ) / sin(θ) = t (1 + b_1 (cos θ - 1)(1 + b_2 (cos θ - 1)(1 + ...))),
+        //   b_i = u_i t² - v_i, u_i = 1 / (i (2i + 1)), v_i = i / (2i + 1),
+        // evaluated from the innermost term out and truncated after b_8, which is
+        // scaled by mu to minimize the error. The weights are within 2e-5 of the
+        // exact ones for cos θ >= 0.
+        template <typename T>
+        struct SlerpCoefficients {
+            std::array<T, 8> from {}, to {};
+            T t {};
+        };
+
+        template <typename T>
+        [[nodiscard]] constexpr SlerpCoefficients<T> MakeSlerpCoefficients(T t) {
+            constexpr double mu = 1.85298109240830;
+            SlerpCoefficients<T> c;
+            c.t = t;
+            const T t0 = 1 - t;
+            for (int i = 1; i <= 8; i++) {
+                const double scale = i == 8 ? mu : 1.0;
+                const T u = T(scale / (i * (2.0 * i + 1)));
+                const T v = T(scale * i / (2.0 * i + 1));
+                c.from[i - 1] = u * t0 * t0 - v;
+                c.to[i - 1] = u * t * t - v;
+            }
+            return c;
+        }
+
+        // Weights of from and to, the sign of `to` is folded into w1.
+        // No branches, divisions or transcendental functions
+        template <typename T>
+        constexpr void SlerpWeights(const SlerpCoefficients<T>& c, T dot, T& w0, T& w1) {
+            const T x = dot < 0 ? -dot : dot;
+            const T xm1 = x - 1;
+            T f0 = 1, f1 = 1;
+            for (size_t i = 8; i-- > 0;) {
+                f0 = 1 + c.from[i] * xm1 * f0;
+                f1 = 1 + c.to[i] * xm1 * f1;
+            }
+            w0 = (1 - c.t) * f0;
+            w1 = dot < 0 ? -c.t * f1 : c.t * f1;
+        }
+    }
+
+    ///Approximate Slerp() for unit quaternions without acos, sin or division.
+    ///At most 2e-5 radians (0.001°) off the exact rotation, length within 3e-5 of 1
+    template <typename T>
+    [[nodiscard]] constexpr QuaternionT<T> SlerpFast(const QuaternionT<T>& from, const QuaternionT<T>& to, T t) {
+        T w0 {}, w1 {};
+        detail::SlerpWeights(detail::MakeSlerpCoefficients(t), QuaternionT<T>::Dot(from, to), w0, w1);
+        return QuaternionT<T> (from.s*w0 + to.s*w1, from.v*w0 + to.v*w1);
+    }
+
+    ///Blends keys `frame` and `frame + 1` at `t` for bones [begin, end)
+    template <typename T>
+    void SampleRange(const ClipT<T>& clip, size_t frame, T t, const PoseStreamT<T>& out, size_t begin, size_t end) {
+        const size_t next = std::min(frame + 1, clip.frames - 1);
+        const size_t k0 = frame * clip.bones, k1 = next * clip.bones;
+        // Components 0..3 are the rotation, 4..6 the translation
+        const std::array<const T*, 7> a {clip.rx + k0, clip.ry + k0, clip.rz + k0, clip.rs + k0, clip.tx + k0, clip.ty + k0, clip.tz + k0};
+        const std::array<const T*, 7> b {clip.rx + k1, clip.ry + k1, clip.rz + k1, clip.rs + k1, clip.tx + k1, clip.ty + k1, clip.tz + k1};
+        const std::array<T*, 7> dst {out.rx, out.ry, out.rz, out.rs, out.tx, out.ty, out.tz};
+        const detail::SlerpCoefficients<T> coefficients = detail::MakeSlerpCoefficients(t);
+        for (size_t base = begin; base < end; base += lanes) {
+            const size_t n = std::min(lanes, end - base);
+            // Only the last block is partial, constant trip counts vectorize better
+            std::array<std::array<T, lanes>, 7> p, q, r;
+            for (size_t c = 0; c < 7; c++) {
+                if (n == lanes) {
+                    std::copy(a[c] + base, a[c] + base + lanes, p[c].begin());
+                    std::copy(b[c] + base, b[c] + base + lanes, q[c].begin());
+                } else {
+                    // Padding lanes blend identity with identity
+                    p[c].fill(c == 3 ? T(1) : T(0));
+                    q[c].fill(c == 3 ? T(1) : T(0));
+                    std::copy(a[c] + base, a[c] + base + n, p[c].begin());
+                    std::copy(b[c] + base, b[c] + base + n, q[c].begin());
+                }
+            }
+            // SlerpWeights() with the lane loop innermost
+            std::array<T, lanes> xm1, negative, f0, f1;
+            for (size_t k = 0; k < lanes; k++) {
+                const T dot = p[0][k] * q[0][k] + p[1][k] * q[1][k] + p[2][k] * q[2][k] + p[3][k] * q[3][k];
+                negative[k] = dot < 0 ? T(-1) : T(1);
+                xm1[k] = dot * negative[k] - 1;
+                f0[k] = 1;
+                f1[k] = 1;
+            }
+            for (size_t i = 8; i-- > 0;) {
+                for (size_t k = 0; k < lanes; k++) {
+                    f0[k] = 1 + coefficients.from[i] * xm1[k] * f0[k];
+                    f1[k] = 1 + coefficients.to[i] * xm1[k] * f1[k];
+                }
+            }
+            for (size_t k = 0; k < lanes; k++) {
+                f0[k] *= 1 - t;
+                f1[k] *= t * negative[k];
+            }
+            for (size_t c = 0; c < 4; c++) {
+                for (size_t k = 0; k < lanes; k++) {
+                    r[c][k] = p[c][k] * f0[k] + q[c][k] * f1[k];
+                }
+            }
+            for (size_t c = 4; c < 7; c++) {
+                for (size_t k = 0; k < lanes; k++) {
+                    r[c][k] = p[c][k] + (q[c][k] - p[c][k]) * t;
+                }
+            }
+            for (size_t c = 0; c < 7; c++) {
+                std::copy(r[c].begin(), r[c].begin() + n, dst[c] + base);
+            }
+        }
+    }
+}
+
+///Local pose of every bone at `time` seconds, clamped to the clip.
+///NaN times and single frame clips sample the first frame.
+///Rotations use SlerpFast(), translations linear interpolation.
+///Runs on up to `threads` threads (0 = all cores).
+template <typename T>
+void SampleClip(const ClipT<T>& clip, T time, const PoseStreamT<T>& out, size_t threads = 0) {
+    if (clip.frames == 0) { return; }
+    using std::floor;
+    // Written so that NaN ends up at 0, std::clamp would pass it on
+    // to the frame index conversion, which is undefined for NaN
+    const T scaled = clip.frames > 1 ? time * clip.frameRate : T(0);
+    const T position = scaled > 0 ? std::min(scaled, T(clip.frames - 1)) : T(0);
+    const T whole = floor(position);
+    const size_t frame = size_t(whole);
+    const T t = position - whole;
+    ParallelFor(clip.bones, animation::chunk, [&](size_t begin, size_t end) {
+        animation::SampleRange(clip, frame, t, out, begin, end);
+    }, threads);
+}
+
+typedef ClipT<float> Clip;
+typedef PoseStreamT<float> PoseStream;
@@ -0,0 +1,199 @@
+#include "Animation.h"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    typedef QuaternionT<double> QuaternionD;
+
+    QuaternionD ToDouble(const Quaternion& q) {
+        return QuaternionD(q.s, {q.v.x, q.v.y, q.v.z});
+    }
+
+    double Length(const QuaternionD& q) {
+        return std::sqrt(QuaternionD::Dot(q, q));
+    }
+
+    QuaternionD Normalized(const QuaternionD& q) {
+        const double length = Length(q);
+        return QuaternionD(q.s / length, q.v / length);
+    }
+
+    // Angle of the rotation between two quaternions, accurate also
+    // for tiny angles, where acos of the dot product isn't
+    double Angle(QuaternionD a, QuaternionD b) {
+        a = Normalized(a);
+        b = Normalized(b);
+        const double sign = QuaternionD::Dot(a, b) < 0 ? -1 : 1;
+        const QuaternionD d (a.s - sign * b.s, a.v - b.v * sign);
+        return 4 * std::asin(Length(d) / 2);
+    }
+
+    // Shortest arc slerp in double, without the Nlerp() shortcut of Slerp()
+    QuaternionD ExactSlerp(const QuaternionD& from, QuaternionD to, double t) {
+        if (QuaternionD::Dot(from, to) < 0) { to = QuaternionD(-to.s, -to.v); }
+        const double cosTheta = QuaternionD::Dot(from, to);
+        // Part of `to` orthogonal to `from`, its length is sin θ
+        const QuaternionD p (to.s - cosTheta * from.s, to.v - from.v * cosTheta);
+        const double sinTheta = Length(p);
+        if (sinTheta == 0) { return from; }
+        const double theta = std::atan2(sinTheta, cosTheta);
+        const double c = std::cos(t * theta), s = std::sin(t * theta) / sinTheta;
+        return QuaternionD(from.s * c + p.s * s, from.v * c + p.v * s);
+    }
+
+    Quaternion RandomRotation(std::mt19937& rng) {
+        std::normal_distribution<float> g;
+        return Quaternion(g(rng), {g(rng), g(rng), g(rng)}).Normalized();
+    }
+
+    // Checks a SlerpFast() result against the exact rotation, with the
+    // bounds documented for it
+    void CheckFast(const Quaternion& result, const Quaternion& from, const Quaternion& to, float t) {
+        const QuaternionD q = ToDouble(result);
+        CHECK(std::abs(Length(q) - 1) <= 3e-5);
+        CHECK(Angle(q, ExactSlerp(ToDouble(from), ToDouble(to), double(t))) <= 2e-5);
+    }
+
+    // Keys, a pose to sample into and a clip over them
+    struct Keys {
+        size_t bones, frames;
+        std::vector<float> k[7], o[7];
+
+        Keys(size_t bones, size_t frames, std::mt19937& rng) : bones(bones), frames(frames) {
+            std::normal_distribution<float> g;
+            for (auto& c : k) { c.resize(bones * frames); }
+            for (auto& c : o) { c.assign(bones, -9); }
+            for (size_t i = 0; i < bones * frames; i++) {
+                Quaternion r = RandomRotation(rng);
+                // Some keys on the other hemisphere of the previous frame's
+                if (i >= bones && i % 3 == 0) {
+                    const Quaternion previous = Rotation(i - bones);
+                    r = Quaternion(-previous.s, -previous.v) * Quaternion::Rotation(0.3f, Vector3(1, 1, 0));
+                }
+                k[0][i] = r.v.x; k[1][i] = r.v.y; k[2][i] = r.v.z; k[3][i] = r.s;
+                k[4][i] = g(rng); k[5][i] = g(rng); k[6][i] = g(rng);
+            }
+        }
+
+        Clip clip(float frameRate) const {
+            return {k[0].data(), k[1].data(), k[2].data(), k[3].data(), k[4].data(), k[5].data(), k[6].data(),
+                    bones, frames, frameRate};
+        }
+        PoseStream pose() {
+            return {o[0].data(), o[1].data(), o[2].data(), o[3].data(), o[4].data(), o[5].data(), o[6].data()};
+        }
+
+        Quaternion Rotation(size_t key) const {
+            return Quaternion(k[3][key], {k[0][key], k[1][key], k[2][key]});
+        }
+        Quaternion Sampled(size_t bone) const {
+            return Quaternion(o[3][bone], {o[0][bone], o[1][bone], o[2][bone]});
+        }
+
+        // Sampled bones [begin, end) blend frames `frame` and `frame + 1` at t
+        void Check(size_t frame, float t, size_t begin, size_t end) const {
+            const size_t next = std::min(frame + 1, frames - 1);
+            for (size_t b = begin; b < end; b++) {
+                const size_t i0 = frame * bones + b, i1 = next * bones + b;
+                CheckFast(Sampled(b), Rotation(i0), Rotation(i1), t);
+                for (size_t c = 4; c < 7; c++) {
+                    CHECK(std::abs(o[c][b] - (k[c][i0] + (k[c][i1] - k[c][i0]) * t)) <= 1e-6f);
+                }
+            }
+        }
+    };
+}
+
+TEST_CASE("[Animation] SlerpFast matches the exact slerp") {
+    std::mt19937 rng {1};
+    std::uniform_real_distribution<float> u (0, 1);
+    std::normal_distribution<float> g;
+    for (int i = 0; i < 20000; i++) {
+        const Quaternion a = RandomRotation(rng);
+        Quaternion b = RandomRotation(rng);
+        // Close pairs, where Slerp() switches to Nlerp()
+        if (i % 4 == 0) { b = Quaternion(a.s + 0.01f * g(rng), a.v).Normalized(); }
+        // Same rotations with dot < 0, which take the shortest arc too
+        if (i % 2 == 0) { b = Quaternion(-b.s, -b.v); }
+        const float t = i % 100 == 0 ? float(i % 3) / 2 : u(rng);
+        CheckFast(animation::SlerpFast(a, b, t), a, b, t);
+        // Same rotation as Slerp()
+        CHECK(Angle(ToDouble(animation::SlerpFast(a, b, t)), ToDouble(Quaternion::Slerp(a, b, t))) <= 2.1e-5);
+    }
+    // Opposite rotations, dot = -1 exactly
+    const Quaternion a = Quaternion::Rotation(0.7f, Vector3(0, 0, 1));
+    CHECK(Angle(ToDouble(animation::SlerpFast(a, Quaternion(-a.s, -a.v), 0.4f)), ToDouble(a)) <= 1e-6);
+    // Ends are the keys
+    const Quaternion b = Quaternion::Rotation(2.5f, Vector3(1, 0, 0));
+    CHECK(Angle(ToDouble(animation::SlerpFast(a, b, 0.0f)), ToDouble(a)) <= 1e-6);
+    CHECK(Angle(ToDouble(animation::SlerpFast(a, b, 1.0f)), ToDouble(b)) <= 1e-6);
+}
+
+TEST_CASE("[Animation] SampleRange matches SlerpFast per bone") {
+    std::mt19937 rng {2};
+    // Not a multiple of the 16 lanes, so the last block is partial
+    Keys keys (37, 4, rng);
+    const Clip clip = keys.clip(30);
+    for (const float t : {0.0f, 0.3f, 0.999f}) {
+        animation::SampleRange(clip, 1, t, keys.pose(), 0, keys.bones);
+        keys.Check(1, t, 0, keys.bones);
+        for (size_t b = 0; b < keys.bones; b++) {
+            const Quaternion q = animation::SlerpFast(keys.Rotation(keys.bones + b), keys.Rotation(2 * keys.bones + b), t);
+            CHECK(Angle(ToDouble(keys.Sampled(b)), ToDouble(q)) <= 1e-6);
+        }
+    }
+    // A range starting and ending inside blocks leaves the other bones alone
+    for (auto& c : keys.o) { c.assign(keys.bones, -9); }
+    animation::SampleRange(clip, 2, 0.5f, keys.pose(), 5, 30);
+    keys.Check(2, 0.5f, 5, 30);
+    CHECK(keys.o[0][4] == -9);
+    CHECK(keys.o[6][30] == -9);
+    // The last frame blends with itself
+    animation::SampleRange(clip, 3, 0.5f, keys.pose(), 0, keys.bones);
+    keys.Check(3, 0, 0, keys.bones);
+}
+
+TEST_CASE("[Animation] SampleClip") {
+    std::mt19937 rng {3};
+    Keys keys (101, 5, rng);
+    const Clip clip = keys.clip(10);
+    CHECK(std::abs(clip.Duration() - 0.4f) <= 1e-6f);
+    for (const size_t threads : {size_t(0), size_t(1), size_t(3)}) {
+        SampleClip(clip, 0.23f, keys.pose(), threads);
+        keys.Check(2, 0.3f, 0, keys.bones);
+    }
+    // Clamped to the clip
+    SampleClip(clip, -1.0f, keys.pose());
+    keys.Check(0, 0, 0, keys.bones);
+    SampleClip(clip, 7.0f, keys.pose());
+    keys.Check(4, 0, 0, keys.bones);
+    SampleClip(clip, std::numeric_limits<float>::infinity(), keys.pose());
+    keys.Check(4, 0, 0, keys.bones);
+    SampleClip(clip, -std::numeric_limits<float>::infinity(), keys.pose());
+    keys.Check(0, 0, 0, keys.bones);
+    // NaN samples the first frame
+    SampleClip(clip, std::numeric_limits<float>::quiet_NaN(), keys.pose());
+    keys.Check(0, 0, 0, keys.bones);
+}
+
+TEST_CASE("[Animation] single frame and empty clips") {
+    std::mt19937 rng {4};
+    Keys keys (19, 1, rng);
+    CHECK(keys.clip(30).Duration() == 0);
+    // Any time, frame rate or NaN gives the only frame
+    for (const float frameRate : {30.0f, 0.0f}) {
+        for (const float time : {0.0f, 0.5f, -2.0f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN()}) {
+            for (auto& c : keys.o) { c.assign(keys.bones, -9); }
+            SampleClip(keys.clip(frameRate), time, keys.pose());
+            keys.Check(0, 0, 0, keys.bones);
+        }
+    }
+
+    Keys empty (19, 0, rng);
+    SampleClip(empty.clip(30), 0.5f, empty.pose());
+    CHECK(empty.o[3][0] == -9);
+}
@@ -0,0 +1,460 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "Quaternion.h"
+#include "Vector.h"
+
+// Batch kernels over arrays of vectors, quaternions and matrices, compiled for several
+// instruction sets in the same binary. The best one the CPU supports is
+// selected once, on first use. The MATRIX_ISA environment variable
+// (sse2, avx2 or avx512) lowers it for testing, SetIsa() changes it at runtime.
+//
+// Every ISA compiles the same plain loops. AVX2 is used without FMA, but
+// AVX-512F always includes it, and GCC fuses a * b + c by default
+// (-ffp-contract=fast). So the AVX-512 build may differ in the last bit,
+// with -ffp-contract=off all ISAs give identical results.
+//
+// Dispatch needs GCC or Clang on x86. Elsewhere everything runs the baseline
+// build, which is whatever the compiler targets.
+//
+// Only these kernels are dispatched. The array kernels of Skinning.h and
+// Geometry.h (skinning, frustum culling, box transforms, ray packets) don't
+// depend on this header and compile for the translation unit's target.
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_BATCH_DISPATCH
+#endif
+
+namespace batch {
+    // Elements per inner block, 16 floats fill an AVX-512 register
+    constexpr size_t lanes = 16;
+
+    enum class Isa : uint8_t {
+        SSE2,    // The baseline build: SSE2 on x86-64, no dispatch elsewhere
+        AVX2,
+        AVX512,  // AVX-512F
+    };
+
+    [[nodiscard]] inline const char* IsaName(Isa isa) {
+        switch (isa) {
+            case Isa::SSE2:   return "sse2";
+            case Isa::AVX2:   return "avx2";
+            case Isa::AVX512: return "avx512";
+        }
+        return "unknown";
+    }
+
+    ///Best ISA of this CPU
+    [[nodiscard]] inline Isa SupportedIsa() {
+#ifdef MATRIX_BATCH_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) { return Isa::AVX512; }
+        if (__builtin_cpu_supports("avx2")) { return Isa::AVX2; }
+#endif
+        return Isa::SSE2;
+    }
+
+    namespace detail {
+        [[nodiscard]] inline Isa Clamp(Isa isa) {
+            return std::min(isa, SupportedIsa());
+        }
+
+        [[nodiscard]] inline Isa FromEnvironment() {
+            const char* env = std::getenv("MATRIX_ISA");
+            if (env != nullptr) {
+                for (const Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+                    if (std::strcmp(env, IsaName(isa)) == 0) { return Clamp(isa); }
+                }
+            }
+            return SupportedIsa();
+        }
+
+        [[nodiscard]] inline std::atomic<Isa>& Active() {
+            static std::atomic<Isa> isa {FromEnvironment()};
+            return isa;
+        }
+    }
+
+    ///ISA the kernels currently run with
+    [[nodiscard]] inline Isa ActiveIsa() {
+        return detail::Active().load(std::memory_order_relaxed);
+    }
+
+    ///Runs the kernels with `isa`, or the best supported one below it.
+    ///Returns the ISA actually selected
+    inline Isa SetIsa(Isa isa) {
+        isa = detail::Clamp(isa);
+        detail::Active().store(isa, std::memory_order_relaxed);
+        return isa;
+    }
+
+    namespace detail {
+        // Each ISA gets its own instantiation of f. flatten inlines the whole
+        // kernel into it, so that the kernel is compiled for that target.
+        template <typename F>
+        MATRIX_FLATTEN void RunBaseline(const F& f) { f(); }
+#ifdef MATRIX_BATCH_DISPATCH
+        template <typename F>
+        __attribute__((target("avx2"), flatten)) void RunAVX2(const F& f) { f(); }
+        template <typename F>
+        __attribute__((target("avx512f,prefer-vector-width=512"), flatten)) void RunAVX512(const F& f) { f(); }
+#endif
+
+        template <typename F>
+        void Run(const F& f) {
+#ifdef MATRIX_BATCH_DISPATCH
+            switch (ActiveIsa()) {
+                case Isa::AVX512: RunAVX512(f); return;
+                case Isa::AVX2:   RunAVX2(f); return;
+                case Isa::SSE2:   break;
+            }
+#endif
+            RunBaseline(f);
+        }
+
+        // Vector kernels: full blocks go through lane-major local arrays with a
+        // constant trip count, which vectorizes without alias checks, the rest
+        // uses the same expressions one element at a time.
+
+        template <typename T>
+        void TransformPoints(const Matrix<4, 4, T>& matrix, const Vector3T<T>* in, size_t count, Vector3T<T>* out) {
+            std::array<T, 12> m {};
+            for (size_t i = 0; i < 12; i++) {
+                m[i] = matrix[i];
+            }
+            const auto transform = [&m](T x, T y, T z, T& ox, T& oy, T& oz) {
+                ox = m[0] * x + m[1] * y + m[2]  * z + m[3];
+                oy = m[4] * x + m[5] * y + m[6]  * z + m[7];
+                oz = m[8] * x + m[9] * y + m[10] * z + m[11];
+            };
+            const size_t full = count / lanes * lanes;
+            for (size_t base = 0; base < full; base += lanes) {
+                T x[lanes], y[lanes], z[lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    x[j] = in[base + j].x;
+                    y[j] = in[base + j].y;
+                    z[j] = in[base + j].z;
+                }
+                T ox[lanes], oy[lanes], oz[lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    transform(x[j], y[j], z[j], ox[j], oy[j], oz[j]);
+                }
+                for (size_t j = 0; j < lanes; j++) {
+                    out[base + j] = Vector3T<T>(ox[j], oy[j], oz[j]);
+                }
+            }
+            for (size_t i = full; i < count; i++) {
+                T ox, oy, oz;
+                transform(in[i].x, in[i].y, in[i].z, ox, oy, oz);
+                out[i] = Vector3T<T>(ox, oy, oz);
+            }
+        }
+
+        template <typename T>
+        void Normalize(Vector3T<T>* v, size_t count) {
+            using std::sqrt;
+            const size_t full = count / lanes * lanes;
+            for (size_t base = 0; base < full; base += lanes) {
+                T x[lanes], y[lanes], z[lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    x[j] = v[base + j].x;
+                    y[j] = v[base + j].y;
+                    z[j] = v[base + j].z;
+                }
+                T length[lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    length[j] = x[j] * x[j] + y[j] * y[j] + z[j] * z[j];
+                }
+                // Alone in its loop: sqrt may set errno, and the branch for
+                // that keeps any loop containing it from vectorizing
+                for (size_t j = 0; j < lanes; j++) {
+                    length[j] = sqrt(length[j]);
+                }
+                for (size_t j = 0; j < lanes; j++) {
+                    x[j] /= length[j];
+                    y[j] /= length[j];
+                    z[j] /= length[j];
+                }
+                for (size_t j = 0; j < lanes; j++) {
+                    v[base + j] = Vector3T<T>(x[j], y[j], z[j]);
+                }
+            }
+            for (size_t i = full; i < count; i++) {
+                v[i] /= sqrt(v[i].x * v[i].x + v[i].y * v[i].y + v[i].z * v[i].z);
+            }
+        }
+
+        // Matrix kernels stay one matrix at a time: a row of the result is a
+        // vector sum of rows of b, which fills a register without the transpose
+        // that lane-major blocks would need
+        template <typename T>
+        void Multiply(const Matrix<4, 4, T>* a, const Matrix<4, 4, T>* b, size_t count, Matrix<4, 4, T>* out) {
+            for (size_t i = 0; i < count; i++) {
+                const T* pa = a[i].data.data();
+                const T* pb = b[i].data.data();
+                T c[16];
+                for (size_t r = 0; r < 4; r++) {
+                    // Same order of additions as operator*
+                    T row[4] {};
+                    for (size_t k = 0; k < 4; k++) {
+                        for (size_t col = 0; col < 4; col++) {
+                            row[col] += pa[r * 4 + k] * pb[k * 4 + col];
+                        }
+                    }
+                    for (size_t col = 0; col < 4; col++) {
+                        c[r * 4 + col] = row[col];
+                    }
+                }
+                std::copy(c, c + 16, out[i].data.data());
+            }
+        }
+
+        // Inverse by cofactors from 2x2 sub-determinants of the top and bottom
+        // row pairs, about 120 flops and no branches
+        template <typename T>
+        void Inverse(const Matrix<4, 4, T>* in, size_t count, Matrix<4, 4, T>* out) {
+            for (size_t i = 0; i < count; i++) {
+                const auto& m = in[i].data;
+                const T s0 = m[0] * m[5]  - m[4]  * m[1];
+                const T s1 = m[0] * m[6]  - m[4]  * m[2];
+                const T s2 = m[0] * m[7]  - m[4]  * m[3];
+                const T s3 = m[1] * m[6]  - m[5]  * m[2];
+                const T s4 = m[1] * m[7]  - m[5]  * m[3];
+                const T s5 = m[2] * m[7]  - m[6]  * m[3];
+                const T c5 = m[10] * m[15] - m[14] * m[11];
+                const T c4 = m[9]  * m[15] - m[13] * m[11];
+                const T c3 = m[9]  * m[14] - m[13] * m[10];
+                const T c2 = m[8]  * m[15] - m[12] * m[11];
+                const T c1 = m[8]  * m[14] - m[12] * m[10];
+                const T c0 = m[8]  * m[13] - m[12] * m[9];
+                const T invDet = T(1) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+                const T inv[16] {
+                    ( m[5]  * c5 - m[6]  * c4 + m[7]  * c3) * invDet,
+                    (-m[1]  * c5 + m[2]  * c4 - m[3]  * c3) * invDet,
+                    ( m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet,
+                    (-m[9]  * s5 + m[10] * s4 - m[11] * s3) * invDet,
+                    (-m[4]  * c5 + m[6]  * c2 - m[7]  * c1) * invDet,
+                    ( m[0]  * c5 - m[2]  * c2 + m[3]  * c1) * invDet,
+                    (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet,
+                    ( m[8]  * s5 - m[10] * s2 + m[11] * s1) * invDet,
+                    ( m[4]  * c4 - m[5]  * c2 + m[7]  * c0) * invDet,
+                    (-m[0]  * c4 + m[1]  * c2 - m[3]  * c0) * invDet,
+                    ( m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet,
+                    (-m[8]  * s4 + m[9]  * s2 - m[11] * s0) * invDet,
+                    (-m[4]  * c3 + m[5]  * c1 - m[6]  * c0) * invDet,
+                    ( m[0]  * c3 - m[1]  * c1 + m[2]  * c0) * invDet,
+                    (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet,
+                    ( m[8]  * s3 - m[9]  * s1 + m[10] * s0) * invDet,
+                };
+                std::copy(inv, inv + 16, out[i].data.data());
+            }
+        }
+
+        // sin and cos with Cody-Waite reduction by π/2 in three parts and the
+        // minimax polynomials of Cephes sinf/cosf on [-π/4, π/4]. No branches,
+        // so lane loops vectorize. Float only, other types use std::sin and std::cos
+        template <typename T>
+        void SinCos(T x, T& sinX, T& cosX) {
+            if constexpr (std::is_same_v<T, float>) {
+                const int32_t quadrant = int32_t(x * 0.636619772f + (x < 0 ? -0.5f : 0.5f));
+                const float j = float(quadrant);
+                const float r = ((x - j * 1.5703125f) - j * 4.837512969970703125e-4f) - j * 7.54978995489188216e-8f;
+                const float r2 = r * r;
+                const float s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+                const float c = 1 - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+                // sin(x) = sin(r), cos(r), -sin(r), -cos(r) for quadrants 0..3.
+                // Selects as products with 0 and ±1, which are exact and
+                // vectorize on SSE2, unlike the equivalent ternaries
+                const float odd = float(quadrant & 1), even = 1 - odd;
+                sinX = (s * even + c * odd) * float(1 - (quadrant & 2));
+                cosX = (c * even + s * odd) * float(1 - ((quadrant + 1) & 2));
+            } else {
+                using std::sin, std::cos;
+                sinX = sin(x);
+                cosX = cos(x);
+            }
+        }
+
+        template <typename T>
+        void EulerToQuaternion(const Vector3T<T>* in, size_t count, QuaternionT<T>* out) {
+            // Same expressions as QuaternionT::Euler(), with the sines and cosines from SinCos()
+            const auto convert = [](T pitch, T yaw, T roll, T& qs, T& qx, T& qy, T& qz) {
+                T sx, cx, sy, cy, sz, cz;
+                SinCos(pitch / 2, sx, cx);
+                SinCos(yaw / 2, sy, cy);
+                SinCos(roll / 2, sz, cz);
+                qs = cx*cy*cz + sx*sy*sz;
+                qx = sx*cy*cz - cx*sy*sz;
+                qy = cx*sy*cz + sx*cy*sz;
+                qz = cx*cy*sz - sx*sy*cz;
+            };
+            const size_t full = count / lanes * lanes;
+            for (size_t base = 0; base < full; base += lanes) {
+                T x[lanes], y[lanes], z[lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    x[j] = in[base + j].x;
+                    y[j] = in[base + j].y;
+                    z[j] = in[base + j].z;
+                }
+                T qs[lanes], qx[lanes], qy[lanes], qz[lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    convert(x[j], y[j], z[j], qs[j], qx[j], qy[j], qz[j]);
+                }
+                for (size_t j = 0; j < lanes; j++) {
+                    out[base + j] = QuaternionT<T>(qs[j], {qx[j], qy[j], qz[j]});
+                }
+            }
+            for (size_t i = full; i < count; i++) {
+                T qs, qx, qy, qz;
+                convert(in[i].x, in[i].y, in[i].z, qs, qx, qy, qz);
+                out[i] = QuaternionT<T>(qs, {qx, qy, qz});
+            }
+        }
+
+        // Same expressions as QuaternionT::RotationMatrix(), written straight
+        // into the destination instead of through a temporary
+        template <size_t N, typename T>
+        void QuaternionToMatrix(const QuaternionT<T>* in, size_t count, Matrix<N, N, T>* out) {
+            for (size_t i = 0; i < count; i++) {
+                const T s = in[i].s, x = in[i].v.x, y = in[i].v.y, z = in[i].v.z;
+                T* m = out[i].data.data();
+                m[0]         = 1 - 2*y*y - 2*z*z;
+                m[1]         = 2*x*y - 2*z*s;
+                m[2]         = 2*x*z + 2*y*s;
+                m[N]         = 2*x*y + 2*z*s;
+                m[N + 1]     = 1 - 2*x*x - 2*z*z;
+                m[N + 2]     = 2*y*z - 2*x*s;
+                m[2 * N]     = 2*x*z - 2*y*s;
+                m[2 * N + 1] = 2*y*z + 2*x*s;
+                m[2 * N + 2] = 1 - 2*x*x - 2*y*y;
+                if constexpr (N == 4) {
+                    m[3] = m[7] = m[11] = m[12] = m[13] = m[14] = 0;
+                    m[15] = 1;
+                }
+            }
+        }
+
+        // Shepperd's method: the largest of |s|, |x|, |y|, |z| comes from a square
+        // root of the diagonal, the others from off-diagonal sums divided by it.
+        // Cases as in M. Day, "Converting a Rotation Matrix to a Quaternion" (2015)
+        template <size_t N, typename T>
+        void MatrixToQuaternion(const Matrix<N, N, T>* in, size_t count, QuaternionT<T>* out) {
+            using std::sqrt;
+            // Rows of m are `stride` elements apart. The quaternion is
+            // (qs, qx, qy, qz) / (2 sqrt(t)), the square root is left to the caller
+            const auto convert = [](const T* m, size_t stride, T& t, T& qs, T& qx, T& qy, T& qz) {
+                const T m00 = m[0],          m01 = m[1],              m02 = m[2];
+                const T m10 = m[stride],     m11 = m[stride + 1],     m12 = m[stride + 2];
+                const T m20 = m[2 * stride], m21 = m[2 * stride + 1], m22 = m[2 * stride + 2];
+                // Exactly one of the case weights is 1, the others 0,
+                // so the blends below are exact selects without branches
+                const T xy = T(m22 < 0), xOverY = T(m00 > m11), zOverS = T(m00 < -m11);
+                const T wx = xy * xOverY, wy = xy * (1 - xOverY);
+                const T wz = (1 - xy) * zOverS, ws = (1 - xy) * (1 - zOverS);
+                // t = 4 c² for the largest component c
+                t = wx * (1 + m00 - m11 - m22) + wy * (1 - m00 + m11 - m22)
+                  + wz * (1 - m00 - m11 + m22) + ws * (1 + m00 + m11 + m22);
+                const T ds = m21 - m12, dx = m02 - m20, dy = m10 - m01;
+                const T sxy = m01 + m10, sxz = m02 + m20, syz = m12 + m21;
+                qs = wx * ds  + wy * dx  + wz * dy  + ws * t;
+                qx = wx * t   + wy * sxy + wz * sxz + ws * ds;
+                qy = wx * sxy + wy * t   + wz * syz + ws * dx;
+                qz = wx * sxz + wy * syz + wz * t   + ws * dy;
+            };
+            const size_t full = count / lanes * lanes;
+            for (size_t base = 0; base < full; base += lanes) {
+                T m[9][lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    for (size_t r = 0; r < 3; r++) {
+                        for (size_t c = 0; c < 3; c++) {
+                            m[r * 3 + c][j] = in[base + j][r * N + c];
+                        }
+                    }
+                }
+                T t[lanes], qs[lanes], qx[lanes], qy[lanes], qz[lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    const T lane[9] = {m[0][j], m[1][j], m[2][j], m[3][j], m[4][j], m[5][j], m[6][j], m[7][j], m[8][j]};
+                    convert(lane, 3, t[j], qs[j], qx[j], qy[j], qz[j]);
+                }
+                // Separate loop for the same reason as in Normalize()
+                for (size_t j = 0; j < lanes; j++) {
+                    t[j] = sqrt(t[j]);
+                }
+                for (size_t j = 0; j < lanes; j++) {
+                    const T k = T(0.5) / t[j];
+                    out[base + j] = QuaternionT<T>(k * qs[j], {k * qx[j], k * qy[j], k * qz[j]});
+                }
+            }
+            for (size_t i = full; i < count; i++) {
+                T t, qs, qx, qy, qz;
+                convert(in[i].data.data(), N, t, qs, qx, qy, qz);
+                const T k = T(0.5) / sqrt(t);
+                out[i] = QuaternionT<T>(k * qs, {k * qx, k * qy, k * qz});
+            }
+        }
+    }
+
+    ///out[i] = matrix * (in[i], 1), w is dropped. `in` and `out` may be the same array
+    template <typename T>
+    void TransformPoints(const Matrix<4, 4, T>& matrix, const Vector3T<T>* in, size_t count, Vector3T<T>* out) {
+        detail::Run([&] { detail::TransformPoints(matrix, in, count, out); });
+    }
+
+    ///v[i].Normalize() within 2 ulp, it uses sqrt instead of hypot: zero vectors
+    ///become NaN, and squared lengths outside the float range give 0 or NaN
+    template <typename T>
+    void Normalize(Vector3T<T>* v, size_t count) {
+        detail::Run([&] { detail::Normalize(v, count); });
+    }
+
+    ///out[i] = a[i] * b[i], same results as operator*. `out` may be `a` or `b`
+    template <typename T>
+    void Multiply(const Matrix<4, 4, T>* a, const Matrix<4, 4, T>* b, size_t count, Matrix<4, 4, T>* out) {
+        detail::Run([&] { detail::Multiply(a, b, count, out); });
+    }
+
+    ///out[i] = in[i]⁻¹ by cofactors, without pivoting or branches.
+    ///Singular matrices give inf or NaN, unlike Matrix::Inverse(). `out` may be `in`
+    template <typename T>
+    void Inverse(const Matrix<4, 4, T>* in, size_t count, Matrix<4, 4, T>* out) {
+        detail::Run([&] { detail::Inverse(in, count, out); });
+    }
+
+    ///out[i] = QuaternionT::Euler(in[i]) with (pitch, yaw, roll) in radians.
+    ///For float, sines and cosines come from a polynomial approximation
+    ///accurate to 1e-7 for angles up to ±8192 radians
+    template <typename T>
+    void EulerToQuaternion(const Vector3T<T>* in, size_t count, QuaternionT<T>* out) {
+        detail::Run([&] { detail::EulerToQuaternion(in, count, out); });
+    }
+
+    // QuaternionToMatrix() is bound by the stores, and the wider vector builds
+    // only add shuffles: they measured 10-40% slower, so it is not dispatched
+
+    ///out[i] = in[i].RotationMatrix(), same results. Quaternions must be unit
+    template <typename T>
+    void QuaternionToMatrix(const QuaternionT<T>* in, size_t count, Matrix<4, 4, T>* out) {
+        detail::RunBaseline([&] { detail::QuaternionToMatrix(in, count, out); });
+    }
+    ///Rotation part of in[i].RotationMatrix(), same results. Quaternions must be unit
+    template <typename T>
+    void QuaternionToMatrix(const QuaternionT<T>* in, size_t count, Matrix<3, 3, T>* out) {
+        detail::RunBaseline([&] { detail::QuaternionToMatrix(in, count, out); });
+    }
+
+    ///Unit quaternion of a rotation matrix, either q or -q.
+    ///Only the upper left 3x3 part is read, it must be orthonormal
+    template <typename T>
+    void MatrixToQuaternion(const Matrix<4, 4, T>* in, size_t count, QuaternionT<T>* out) {
+        detail::Run([&] { detail::MatrixToQuaternion(in, count, out); });
+    }
+    template <typename T>
+    void MatrixToQuaternion(const Matrix<3, 3, T>* in, size_t count, QuaternionT<T>* out) {
+        detail::Run([&] { detail::MatrixToQuaternion(in, count, out); });
+    }
+}
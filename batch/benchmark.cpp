@@ -0,0 +1,119 @@
+// Throughput of every batch kernel with each ISA the CPU supports.
+// Also checks that all ISAs produce the same results as the baseline.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+#include "Batch.h"
+
+namespace {
+    constexpr size_t count = 4096;
+    constexpr batch::Isa isas[] = {batch::Isa::SSE2, batch::Isa::AVX2, batch::Isa::AVX512};
+
+    struct Data {
+        std::vector<Vector3> points, normals, angles;
+        std::vector<Matrix<4, 4>> a, b;
+        std::vector<Quaternion> rotations;
+        std::vector<Matrix<4, 4>> rotationMatrices;
+        Matrix<4, 4> transform;
+    };
+
+    Data MakeData() {
+        std::mt19937 rng {42};
+        std::uniform_real_distribution<float> dist {-1, 1};
+        Data d;
+        for (size_t i = 0; i < count; i++) {
+            d.points.emplace_back(dist(rng), dist(rng), dist(rng));
+            d.normals.emplace_back(dist(rng), dist(rng), dist(rng) + 2);
+            d.angles.push_back(d.points.back() * 3.0f);
+            d.rotations.push_back(Quaternion::Euler(d.angles.back()));
+            d.rotationMatrices.push_back(d.rotations.back().RotationMatrix());
+            Matrix<4, 4> a, b;
+            for (size_t e = 0; e < 16; e++) {
+                a[e] = dist(rng) + (e % 5 == 0 ? 4 : 0);
+                b[e] = dist(rng);
+            }
+            d.a.push_back(a);
+            d.b.push_back(b);
+        }
+        d.transform = d.a[0];
+        return d;
+    }
+
+    // Millions of items per second, best of a few runs
+    double Measure(const std::function<void()>& f) {
+        using Clock = std::chrono::steady_clock;
+        double best = 0;
+        for (int run = 0; run < 5; run++) {
+            constexpr int reps = 50;
+            const auto start = Clock::now();
+            for (int r = 0; r < reps; r++) {
+                f();
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            best = std::max(best, count * reps / seconds / 1e6);
+        }
+        return best;
+    }
+
+    struct Kernel {
+        const char* name;
+        std::function<void()> run;
+        // Output of the last run
+        const void* result;
+        size_t bytes;
+    };
+}
+
+int main() {
+    const batch::Isa startup = batch::ActiveIsa();
+    const Data d = MakeData();
+    std::vector<Vector3> vectors (count);
+    std::vector<Matrix<4, 4>> matrices (count);
+    std::vector<Matrix<3, 3>> matrices3 (count);
+    std::vector<Quaternion> quaternions (count, Quaternion::Identity());
+
+    const Kernel kernels[] = {
+        {"TransformPoints", [&] { batch::TransformPoints(d.transform, d.points.data(), count, vectors.data()); },
+         vectors.data(), count * sizeof(Vector3)},
+        {"Normalize", [&] { vectors = d.normals; batch::Normalize(vectors.data(), count); },
+         vectors.data(), count * sizeof(Vector3)},
+        {"Multiply", [&] { batch::Multiply(d.a.data(), d.b.data(), count, matrices.data()); },
+         matrices.data(), count * sizeof(Matrix<4, 4>)},
+        {"Inverse", [&] { batch::Inverse(d.a.data(), count, matrices.data()); },
+         matrices.data(), count * sizeof(Matrix<4, 4>)},
+        {"EulerToQuaternion", [&] { batch::EulerToQuaternion(d.angles.data(), count, quaternions.data()); },
+         quaternions.data(), count * sizeof(Quaternion)},
+        {"QuaternionToMatrix 4x4", [&] { batch::QuaternionToMatrix(d.rotations.data(), count, matrices.data()); },
+         matrices.data(), count * sizeof(Matrix<4, 4>)},
+        {"QuaternionToMatrix 3x3", [&] { batch::QuaternionToMatrix(d.rotations.data(), count, matrices3.data()); },
+         matrices3.data(), count * sizeof(Matrix<3, 3>)},
+        {"MatrixToQuaternion", [&] { batch::MatrixToQuaternion(d.rotationMatrices.data(), count, quaternions.data()); },
+         quaternions.data(), count * sizeof(Quaternion)},
+    };
+
+    std::printf("M items/s               ");
+    for (const batch::Isa isa : isas) {
+        std::printf("%10s", batch::IsaName(isa));
+    }
+    std::printf("  same results\n");
+    for (const Kernel& k : kernels) {
+        batch::SetIsa(batch::Isa::SSE2);
+        k.run();
+        const std::vector<char> reference (static_cast<const char*>(k.result), static_cast<const char*>(k.result) + k.bytes);
+        bool same = true;
+        std::printf("%-24s", k.name);
+        for (const batch::Isa isa : isas) {
+            if (batch::SetIsa(isa) != isa) {
+                std::printf("%10s", "-");
+                continue;
+            }
+            std::printf("%10.1f", Measure(k.run));
+            same = same && std::memcmp(reference.data(), k.result, k.bytes) == 0;
+        }
+        std::printf("  %s\n", same ? "yes" : "no");
+    }
+    std::printf("selected at startup: %s\n", batch::IsaName(startup));
+}
@@ -0,0 +1,280 @@
+#include "Batch.h"
+#include <cmath>
+#include <random>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    constexpr batch::Isa isas[] = {batch::Isa::SSE2, batch::Isa::AVX2, batch::Isa::AVX512};
+
+    // Below one block, exactly one, a tail after one and after several
+    constexpr size_t counts[] = {0, 1, 15, 16, 17, 37, 69};
+    constexpr size_t maxCount = 69;
+
+    // Runs f once for each ISA this CPU supports, and restores the active one
+    template <typename F>
+    void ForEachIsa(const F& f) {
+        const batch::Isa startup = batch::ActiveIsa();
+        for (const batch::Isa isa : isas) {
+            if (batch::SetIsa(isa) != isa) { continue; }
+            f();
+        }
+        batch::SetIsa(startup);
+    }
+
+    // AVX-512 fuses multiply-adds, so results may differ from the scalar code in the last bits
+    bool Near(float a, float b, float relative = 1e-6f) {
+        return std::abs(a - b) <= relative * std::max(1.0f, std::abs(b));
+    }
+
+    bool Near(const Vector3& a, const Vector3& b, float relative = 1e-6f) {
+        return Near(a.x, b.x, relative) && Near(a.y, b.y, relative) && Near(a.z, b.z, relative);
+    }
+
+    template <size_t N>
+    bool Near(const Matrix<N, N>& a, const Matrix<N, N>& b, float relative = 1e-6f) {
+        for (size_t i = 0; i < N * N; i++) {
+            if (!Near(a[i], b[i], relative)) { return false; }
+        }
+        return true;
+    }
+
+    std::vector<Vector3> RandomVectors(std::mt19937& rng, float scale) {
+        std::uniform_real_distribution<float> u (-scale, scale);
+        std::vector<Vector3> v (maxCount);
+        for (Vector3& e : v) {
+            e = Vector3(u(rng), u(rng), u(rng));
+        }
+        return v;
+    }
+
+    // Diagonally dominant, so every inverse exists and is well conditioned
+    std::vector<Matrix<4, 4>> RandomMatrices(std::mt19937& rng, float diagonal) {
+        std::uniform_real_distribution<float> u (-1, 1);
+        std::vector<Matrix<4, 4>> m (maxCount);
+        for (Matrix<4, 4>& e : m) {
+            for (size_t i = 0; i < 16; i++) {
+                e[i] = u(rng) + (i % 5 == 0 ? diagonal : 0);
+            }
+        }
+        return m;
+    }
+}
+
+TEST_CASE("[Batch] SetIsa") {
+    const batch::Isa startup = batch::ActiveIsa();
+    CHECK(startup <= batch::SupportedIsa());
+    CHECK(batch::SetIsa(batch::Isa::SSE2) == batch::Isa::SSE2);
+    CHECK(batch::ActiveIsa() == batch::Isa::SSE2);
+    // Never above what the CPU supports
+    CHECK(batch::SetIsa(batch::Isa::AVX512) == batch::SupportedIsa());
+    CHECK(batch::ActiveIsa() == batch::SupportedIsa());
+    batch::SetIsa(startup);
+}
+
+TEST_CASE("[Batch] TransformPoints matches the matrix product") {
+    std::mt19937 rng {1};
+    const Matrix<4, 4> m = RandomMatrices(rng, 2)[0];
+    const std::vector<Vector3> points = RandomVectors(rng, 100);
+    std::vector<Vector3> expected (maxCount);
+    for (size_t i = 0; i < maxCount; i++) {
+        const VectorS<4> p (m * points[i].Homogeneous(1));
+        expected[i] = Vector3(p[0], p[1], p[2]);
+    }
+    ForEachIsa([&] {
+        for (const size_t count : counts) {
+            std::vector<Vector3> out (maxCount, Vector3(-7));
+            batch::TransformPoints(m, points.data(), count, out.data());
+            for (size_t i = 0; i < maxCount; i++) {
+                CHECK(Near(out[i], i < count ? expected[i] : Vector3(-7), 1e-5f));
+            }
+            // In place
+            std::vector<Vector3> inPlace = points;
+            batch::TransformPoints(m, inPlace.data(), count, inPlace.data());
+            for (size_t i = 0; i < count; i++) {
+                CHECK(inPlace[i] == out[i]);
+            }
+        }
+    });
+}
+
+TEST_CASE("[Batch] Normalize matches Vector3::Normalize") {
+    std::mt19937 rng {2};
+    std::vector<Vector3> vectors = RandomVectors(rng, 10);
+    vectors[3] = Vector3(1e-15f, 2e-15f, 0);
+    vectors[20] = Vector3(0, -3e15f, 4e15f);
+    ForEachIsa([&] {
+        for (const size_t count : counts) {
+            std::vector<Vector3> v = vectors;
+            batch::Normalize(v.data(), count);
+            for (size_t i = 0; i < maxCount; i++) {
+                // 2 ulp, sqrt of the squared length rounds differently from hypot
+                CHECK(Near(v[i], i < count ? vectors[i].Normalized() : vectors[i], 2.5e-7f));
+                if (i < count) { CHECK(Near(v[i].Magnitude(), 1, 2.5e-7f)); }
+            }
+        }
+        // Zero vectors become NaN in full blocks and in the tail, like Normalize()
+        std::vector<Vector3> zeros (17, Vector3(0));
+        batch::Normalize(zeros.data(), zeros.size());
+        CHECK(std::isnan(zeros[0].x));
+        CHECK(std::isnan(zeros[16].x));
+    });
+}
+
+TEST_CASE("[Batch] Multiply matches operator*") {
+    std::mt19937 rng {3};
+    const std::vector<Matrix<4, 4>> a = RandomMatrices(rng, 0), b = RandomMatrices(rng, 0);
+    ForEachIsa([&] {
+        for (const size_t count : counts) {
+            std::vector<Matrix<4, 4>> out (maxCount, Matrix<4, 4>::Identity());
+            batch::Multiply(a.data(), b.data(), count, out.data());
+            for (size_t i = 0; i < maxCount; i++) {
+                CHECK(Near(out[i], i < count ? a[i] * b[i] : Matrix<4, 4>::Identity()));
+            }
+            // Into either operand
+            std::vector<Matrix<4, 4>> intoA = a, intoB = b;
+            batch::Multiply(intoA.data(), b.data(), count, intoA.data());
+            batch::Multiply(a.data(), intoB.data(), count, intoB.data());
+            for (size_t i = 0; i < count; i++) {
+                CHECK(intoA[i].data == out[i].data);
+                CHECK(intoB[i].data == out[i].data);
+            }
+        }
+    });
+}
+
+TEST_CASE("[Batch] Inverse matches Matrix::Inverse") {
+    std::mt19937 rng {4};
+    const std::vector<Matrix<4, 4>> matrices = RandomMatrices(rng, 4);
+    ForEachIsa([&] {
+        for (const size_t count : counts) {
+            std::vector<Matrix<4, 4>> out (maxCount, Matrix<4, 4>::Identity());
+            batch::Inverse(matrices.data(), count, out.data());
+            for (size_t i = 0; i < maxCount; i++) {
+                // Cofactors and Gauss-Jordan round differently
+                CHECK(Near(out[i], i < count ? matrices[i].Inverse() : Matrix<4, 4>::Identity(), 1e-5f));
+                if (i < count) { CHECK(Near(matrices[i] * out[i], Matrix<4, 4>::Identity(), 1e-5f)); }
+            }
+            std::vector<Matrix<4, 4>> inPlace = matrices;
+            batch::Inverse(inPlace.data(), count, inPlace.data());
+            for (size_t i = 0; i < count; i++) {
+                CHECK(inPlace[i].data == out[i].data);
+            }
+        }
+        // Singular gives inf or NaN instead of the zero matrix
+        const Matrix<4, 4> singular = Matrix<4, 4>::Zero();
+        Matrix<4, 4> inverse;
+        batch::Inverse(&singular, 1, &inverse);
+        CHECK(!std::isfinite(inverse[0]));
+    });
+}
+
+TEST_CASE("[Batch] SinCos matches std::sin and std::cos") {
+    const auto check = [](float x) {
+        float s = 0, c = 0;
+        batch::detail::SinCos(x, s, c);
+        CHECK(std::abs(double(s) - std::sin(double(x))) <= 1e-7);
+        CHECK(std::abs(double(c) - std::cos(double(x))) <= 1e-7);
+    };
+    std::mt19937 rng {5};
+    std::uniform_real_distribution<float> u (-8192, 8192), small (-4, 4);
+    for (int i = 0; i < 200000; i++) {
+        check(u(rng));
+        check(small(rng));
+    }
+    // Ends of the range, zero and near quadrant boundaries
+    for (const float x : {-8192.0f, 8192.0f, 0.0f, -0.0f, 1e-30f}) {
+        check(x);
+    }
+    for (int k = -5215; k <= 5215; k += 7) {
+        const float boundary = float(k * 0.78539816339744831);
+        check(boundary);
+        check(std::nextafter(boundary, 1e9f));
+        check(std::nextafter(boundary, -1e9f));
+    }
+}
+
+TEST_CASE("[Batch] EulerToQuaternion matches Quaternion::Euler") {
+    std::mt19937 rng {6};
+    std::uniform_real_distribution<float> u (-8192, 8192);
+    std::vector<Vector3> angles (maxCount);
+    for (Vector3& a : angles) {
+        a = Vector3(u(rng), u(rng), u(rng));
+    }
+    angles[0] = Vector3(0);
+    angles[1] = Vector3(1.5707964f, -3.1415927f, 0.5f);
+    ForEachIsa([&] {
+        for (const size_t count : counts) {
+            std::vector<Quaternion> out (maxCount, Quaternion::Identity());
+            batch::EulerToQuaternion(angles.data(), count, out.data());
+            for (size_t i = 0; i < maxCount; i++) {
+                const Quaternion expected = i < count ? Quaternion::Euler(angles[i]) : Quaternion::Identity();
+                CHECK(std::abs(out[i].s - expected.s) <= 3e-7f);
+                CHECK(Near(out[i].v, expected.v, 3e-7f));
+            }
+        }
+        // One axis at a time the components are single sines and cosines of
+        // half the angle, which covers SinCos() over ±8192 in every ISA build
+        std::uniform_real_distribution<float> wide (-16384, 16384);
+        std::vector<Vector3> pitch (maxCount);
+        for (Vector3& a : pitch) {
+            a = Vector3(wide(rng), 0, 0);
+        }
+        std::vector<Quaternion> out (maxCount, Quaternion::Identity());
+        batch::EulerToQuaternion(pitch.data(), maxCount, out.data());
+        for (size_t i = 0; i < maxCount; i++) {
+            const double half = double(pitch[i].x / 2);
+            CHECK(std::abs(double(out[i].s) - std::cos(half)) <= 1e-7);
+            CHECK(std::abs(double(out[i].v.x) - std::sin(half)) <= 1e-7);
+        }
+    });
+}
+
+TEST_CASE("[Batch] MatrixToQuaternion inverts QuaternionToMatrix") {
+    std::mt19937 rng {7};
+    std::normal_distribution<float> g;
+    // Each component in turn the largest, for each case of Shepperd's method,
+    // then 180° rotations, where s = 0, and random ones
+    std::vector<Quaternion> rotations {
+        Quaternion(0.9f, {0.1f, -0.3f, 0.2f}).Normalized(),
+        Quaternion(0.1f, {-0.9f, 0.3f, 0.2f}).Normalized(),
+        Quaternion(-0.2f, {0.3f, 0.9f, -0.1f}).Normalized(),
+        Quaternion(0.2f, {0.1f, -0.3f, -0.9f}).Normalized(),
+        Quaternion(0, {1, 0, 0}), Quaternion(0, {0, 1, 0}), Quaternion(0, {0, 0, 1}),
+        Quaternion(0, {0.6f, 0, 0.8f}), Quaternion::Identity(),
+    };
+    while (rotations.size() < maxCount) {
+        rotations.push_back(Quaternion(g(rng), {g(rng), g(rng), g(rng)}).Normalized());
+    }
+    std::vector<Matrix<3, 3>> m3 (maxCount);
+    std::vector<Matrix<4, 4>> m4 (maxCount);
+    batch::QuaternionToMatrix(rotations.data(), maxCount, m3.data());
+    batch::QuaternionToMatrix(rotations.data(), maxCount, m4.data());
+    for (size_t i = 0; i < maxCount; i++) {
+        CHECK(m4[i].data == rotations[i].RotationMatrix().data);
+        for (size_t r = 0; r < 3; r++) {
+            for (size_t c = 0; c < 3; c++) {
+                CHECK(m3[i](r, c) == m4[i](r, c));
+            }
+        }
+    }
+    // Either q or -q
+    const auto check = [&](const std::vector<Quaternion>& out, size_t count) {
+        for (size_t i = 0; i < maxCount; i++) {
+            const Quaternion expected = i < count ? rotations[i] : Quaternion::Identity();
+            const float sign = Quaternion::Dot(out[i], expected) < 0 ? -1.0f : 1.0f;
+            CHECK(std::abs(out[i].s * sign - expected.s) <= 1e-6f);
+            CHECK(Near(out[i].v * sign, expected.v));
+        }
+    };
+    ForEachIsa([&] {
+        for (const size_t count : counts) {
+            std::vector<Quaternion> out3 (maxCount, Quaternion::Identity()), out4 = out3;
+            batch::MatrixToQuaternion(m3.data(), count, out3.data());
+            batch::MatrixToQuaternion(m4.data(), count, out4.data());
+            check(out3, count);
+            check(out4, count);
+        }
+    });
+}
@@ -0,0 +1,350 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "Geometry.h"
+
+// View and projection matrix builders with closed-form inverses.
+//
+// OpenGL conventions: right-handed view space looking down -z,
+// column vectors, clip space depth -w..w.
+// ReversedZ variants map near to depth 1 and far to depth 0 instead.
+// That only gains precision with a 0..1 depth range
+// (glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE), Vulkan, Direct3D).
+//
+// Every builder has an ...Inverse() counterpart taking the same arguments,
+// use it instead of Matrix::Inverse() for picking and light-space transforms.
+
+///Point projected by camera::ProjectToScreen(): pixel position
+///(origin top left, y down) and depth z / w in the projection's depth range
+template <typename T>
+struct ScreenPointT {
+    Vector2T<T> pixel;
+    T depth;
+};
+
+typedef ScreenPointT<float> ScreenPoint;
+
+namespace camera {
+    ///Bits of the ProjectToScreen() clip flags, set when a point is outside that plane
+    enum ClipFlag : uint8_t {
+        ClipLeft   = 1 << 0,
+        ClipRight  = 1 << 1,
+        ClipBottom = 1 << 2,
+        ClipTop    = 1 << 3,
+        ClipNear   = 1 << 4,
+        ClipFar    = 1 << 5,
+    };
+
+    // Points per inner block of ProjectToScreen(), the block loops are
+    // written so that compilers vectorize them across points
+    constexpr size_t lanes = 16;
+    // Smallest amount of points worth a thread
+    constexpr size_t chunk = 4096;
+
+    namespace detail {
+        template <typename T>
+        [[nodiscard]] constexpr T Focal(T fovY) {
+            // Allow non-std overloads of tan() for T
+            using std::tan;
+            return T(1) / tan(fovY / 2);
+        }
+
+        // All perspective projections are
+        //   x' = sx * x,  y' = sy * y,  z' = c * z + d,  w' = -z
+
+        template <typename T>
+        [[nodiscard]] constexpr Matrix<4, 4, T> Perspective(T sx, T sy, T c, T d) {
+            return Matrix<4, 4, T> {std::array<T, 16> {
+                sx, 0,  0,  0,
+                0,  sy, 0,  0,
+                0,  0,  c,  d,
+                0,  0,  -1, 0,
+            }};
+        }
+
+        template <typename T>
+        [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveInverse(T sx, T sy, T c, T d) {
+            return Matrix<4, 4, T> {std::array<T, 16> {
+                1 / sx, 0,      0,     0,
+                0,      1 / sy, 0,     0,
+                0,      0,      0,     -1,
+                0,      0,      1 / d, c / d,
+            }};
+        }
+
+        // All orthographic projections are
+        //   x' = sx * x + tx,  y' = sy * y + ty,  z' = sz * z + tz,  w' = 1
+
+        template <typename T>
+        [[nodiscard]] constexpr Matrix<4, 4, T> Orthographic(T sx, T tx, T sy, T ty, T sz, T tz) {
+            return Matrix<4, 4, T> {std::array<T, 16> {
+                sx, 0,  0,  tx,
+                0,  sy, 0,  ty,
+                0,  0,  sz, tz,
+                0,  0,  0,  1,
+            }};
+        }
+
+        template <typename T>
+        [[nodiscard]] constexpr Matrix<4, 4, T> OrthographicInverse(T sx, T tx, T sy, T ty, T sz, T tz) {
+            return Matrix<4, 4, T> {std::array<T, 16> {
+                1 / sx, 0,      0,      -tx / sx,
+                0,      1 / sy, 0,      -ty / sy,
+                0,      0,      1 / sz, -tz / sz,
+                0,      0,      0,      1,
+            }};
+        }
+
+        template <typename T>
+        void ProjectRange(const Matrix<4, 4, T>& viewProjection, T width, T height,
+                          const Vector3T<T>* points, ScreenPointT<T>* screen, uint8_t* clip,
+                          T nearDepth, T farDepth, size_t begin, size_t end) {
+            const auto& m = viewProjection;
+            // NDC to pixels folded into the matrix: pixel = ((x / w + 1) * width / 2, (1 - y / w) * height / 2)
+            std::array<T, 4> px {}, py {}, pz {}, pw {};
+            for (size_t j = 0; j < 4; j++) {
+                px[j] = (m(0, j) + m(3, j)) * (width / 2);
+                py[j] = (m(3, j) - m(1, j)) * (height / 2);
+                pz[j] = m(2, j);
+                pw[j] = m(3, j);
+            }
+            // +1 if depth grows from near to far, -1 for ReversedZ
+            const T toFar = farDepth > nearDepth ? T(1) : T(-1);
+            for (size_t base = begin; base < end; base += lanes) {
+                const size_t n = std::min(lanes, end - base);
+                // Only the last block is partial, constant trip counts vectorize better
+                std::array<T, lanes> x, y, z;
+                if (n == lanes) {
+                    for (size_t k = 0; k < lanes; k++) {
+                        x[k] = points[base + k].x;
+                        y[k] = points[base + k].y;
+                        z[k] = points[base + k].z;
+                    }
+                } else {
+                    x.fill(0);
+                    y.fill(0);
+                    z.fill(0);
+                    for (size_t k = 0; k < n; k++) {
+                        x[k] = points[base + k].x;
+                        y[k] = points[base + k].y;
+                        z[k] = points[base + k].z;
+                    }
+                }
+                std::array<T, lanes> sx, sy, sz;
+                std::array<uint8_t, lanes> flags;
+                for (size_t k = 0; k < lanes; k++) {
+                    const T cx = px[0] * x[k] + px[1] * y[k] + px[2] * z[k] + px[3];
+                    const T cy = py[0] * x[k] + py[1] * y[k] + py[2] * z[k] + py[3];
+                    const T cz = pz[0] * x[k] + pz[1] * y[k] + pz[2] * z[k] + pz[3];
+                    const T cw = pw[0] * x[k] + pw[1] * y[k] + pw[2] * z[k] + pw[3];
+                    const T invW = 1 / cw;
+                    sx[k] = cx * invW;
+                    sy[k] = cy * invW;
+                    sz[k] = cz * invW;
+                    // Clip space tests in pixel units: x < -w is cx < 0, x > w is cx > width * w
+                    flags[k] = uint8_t(
+                        uint8_t(cx < 0) * ClipLeft |
+                        uint8_t(cx > width * cw) * ClipRight |
+                        uint8_t(cy > height * cw) * ClipBottom |
+                        uint8_t(cy < 0) * ClipTop |
+                        uint8_t((cz - nearDepth * cw) * toFar < 0) * ClipNear |
+                        uint8_t((cz - farDepth * cw) * toFar > 0) * ClipFar);
+                }
+                if (n == lanes) {
+                    for (size_t k = 0; k < lanes; k++) {
+                        screen[base + k].pixel.x = sx[k];
+                        screen[base + k].pixel.y = sy[k];
+                        screen[base + k].depth = sz[k];
+                    }
+                    std::copy(flags.begin(), flags.end(), clip + base);
+                } else {
+                    for (size_t k = 0; k < n; k++) {
+                        screen[base + k].pixel.x = sx[k];
+                        screen[base + k].pixel.y = sy[k];
+                        screen[base + k].depth = sz[k];
+                        clip[base + k] = flags[k];
+                    }
+                }
+            }
+        }
+    }
+
+    ///fovY in radians, depth -1..1
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> Perspective(T fovY, T aspect, T zNear, T zFar) {
+        const T f = detail::Focal(fovY);
+        return detail::Perspective(f / aspect, f, (zFar + zNear) / (zNear - zFar), 2 * zFar * zNear / (zNear - zFar));
+    }
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveInverse(T fovY, T aspect, T zNear, T zFar) {
+        const T f = detail::Focal(fovY);
+        return detail::PerspectiveInverse(f / aspect, f, (zFar + zNear) / (zNear - zFar), 2 * zFar * zNear / (zNear - zFar));
+    }
+
+    ///Far plane at infinity, depth -1..1
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveInfinite(T fovY, T aspect, T zNear) {
+        const T f = detail::Focal(fovY);
+        return detail::Perspective(f / aspect, f, T(-1), -2 * zNear);
+    }
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveInfiniteInverse(T fovY, T aspect, T zNear) {
+        const T f = detail::Focal(fovY);
+        return detail::PerspectiveInverse(f / aspect, f, T(-1), -2 * zNear);
+    }
+
+    ///Depth 1 at near, 0 at far
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveReversedZ(T fovY, T aspect, T zNear, T zFar) {
+        const T f = detail::Focal(fovY);
+        return detail::Perspective(f / aspect, f, zNear / (zFar - zNear), zFar * zNear / (zFar - zNear));
+    }
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveReversedZInverse(T fovY, T aspect, T zNear, T zFar) {
+        const T f = detail::Focal(fovY);
+        return detail::PerspectiveInverse(f / aspect, f, zNear / (zFar - zNear), zFar * zNear / (zFar - zNear));
+    }
+
+    ///Depth 1 at near, 0 at infinity. Best depth precision of all
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveReversedZInfinite(T fovY, T aspect, T zNear) {
+        const T f = detail::Focal(fovY);
+        return detail::Perspective(f / aspect, f, T(0), zNear);
+    }
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> PerspectiveReversedZInfiniteInverse(T fovY, T aspect, T zNear) {
+        const T f = detail::Focal(fovY);
+        return detail::PerspectiveInverse(f / aspect, f, T(0), zNear);
+    }
+
+    ///Depth -1..1, same as glOrtho
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> Orthographic(T left, T right, T bottom, T top, T zNear, T zFar) {
+        return detail::Orthographic(
+            2 / (right - left), (right + left) / (left - right),
+            2 / (top - bottom), (top + bottom) / (bottom - top),
+            2 / (zNear - zFar), (zFar + zNear) / (zNear - zFar));
+    }
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> OrthographicInverse(T left, T right, T bottom, T top, T zNear, T zFar) {
+        return detail::OrthographicInverse(
+            2 / (right - left), (right + left) / (left - right),
+            2 / (top - bottom), (top + bottom) / (bottom - top),
+            2 / (zNear - zFar), (zFar + zNear) / (zNear - zFar));
+    }
+
+    ///Depth 1 at near, 0 at far
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> OrthographicReversedZ(T left, T right, T bottom, T top, T zNear, T zFar) {
+        return detail::Orthographic(
+            2 / (right - left), (right + left) / (left - right),
+            2 / (top - bottom), (top + bottom) / (bottom - top),
+            1 / (zFar - zNear), zFar / (zFar - zNear));
+    }
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> OrthographicReversedZInverse(T left, T right, T bottom, T top, T zNear, T zFar) {
+        return detail::OrthographicInverse(
+            2 / (right - left), (right + left) / (left - right),
+            2 / (top - bottom), (top + bottom) / (bottom - top),
+            1 / (zFar - zNear), zFar / (zFar - zNear));
+    }
+
+    ///View matrix, same as gluLookAt. `up` must not be parallel to the view direction
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> LookAt(const Vector3T<T>& eye, const Vector3T<T>& target, const Vector3T<T>& up) {
+        const Vector3T<T> f = (target - eye).Normalized();
+        const Vector3T<T> s = Vector3T<T>::Cross(f, up).Normalized();
+        const Vector3T<T> u = Vector3T<T>::Cross(s, f);
+        return Matrix<4, 4, T> {std::array<T, 16> {
+            s.x,  s.y,  s.z,  -Vector3T<T>::Dot(s, eye),
+            u.x,  u.y,  u.z,  -Vector3T<T>::Dot(u, eye),
+            -f.x, -f.y, -f.z, Vector3T<T>::Dot(f, eye),
+            0,    0,    0,    1,
+        }};
+    }
+    ///Camera to world transform, the rotation part is transposed
+    template <typename T>
+    [[nodiscard]] constexpr Matrix<4, 4, T> LookAtInverse(const Vector3T<T>& eye, const Vector3T<T>& target, const Vector3T<T>& up) {
+        const Vector3T<T> f = (target - eye).Normalized();
+        const Vector3T<T> s = Vector3T<T>::Cross(f, up).Normalized();
+        const Vector3T<T> u = Vector3T<T>::Cross(s, f);
+        return Matrix<4, 4, T> {std::array<T, 16> {
+            s.x, u.x, -f.x, eye.x,
+            s.y, u.y, -f.y, eye.y,
+            s.z, u.z, -f.z, eye.z,
+            0,   0,   0,    1,
+        }};
+    }
+
+    ///World space ray through a point in normalized device coordinates.
+    ///Origin is on the near plane, direction is normalized.
+    ///Pass nearDepth = 1, farDepth = 0 for ReversedZ projections
+    template <typename T>
+    [[nodiscard]] constexpr RayT<T> UnprojectRay(const Matrix<4, 4, T>& inverseViewProjection, const Vector2T<T>& ndc,
+                                                 T nearDepth = -1, T farDepth = 1) {
+        const auto& m = inverseViewProjection;
+        std::array<T, 4> n {}, f {};
+        for (size_t i = 0; i < 4; i++) {
+            const T xy = m(i, 0) * ndc.x + m(i, 1) * ndc.y + m(i, 3);
+            n[i] = xy + m(i, 2) * nearDepth;
+            f[i] = xy + m(i, 2) * farDepth;
+        }
+        const Vector3T<T> origin = Vector3T<T>(n[0], n[1], n[2]) / n[3];
+        // Homogeneous difference, works for a far plane at infinity (w = 0) too
+        const Vector3T<T> dir = Vector3T<T>(f[0], f[1], f[2]) - origin * f[3];
+        return RayT<T> {origin, dir.Normalized()};
+    }
+
+    ///World space rays through `count` screen points in pixels
+    ///(origin top left, y down, use x + 0.5 for pixel centers).
+    ///Runs lane-parallel without branches so that it vectorizes
+    template <typename T>
+    void UnprojectRays(const Matrix<4, 4, T>& inverseViewProjection, T width, T height,
+                       const Vector2T<T>* points, size_t count, RayT<T>* rays,
+                       T nearDepth = -1, T farDepth = 1) {
+        const auto& m = inverseViewProjection;
+        // Pixels to NDC folded into the matrix: ndc = (2x / width - 1, 1 - 2y / height)
+        std::array<T, 4> ax {}, ay {}, kn {}, kf {};
+        for (size_t i = 0; i < 4; i++) {
+            ax[i] = m(i, 0) * (2 / width);
+            ay[i] = m(i, 1) * (-2 / height);
+            const T k = m(i, 3) - m(i, 0) + m(i, 1);
+            kn[i] = k + m(i, 2) * nearDepth;
+            kf[i] = k + m(i, 2) * farDepth;
+        }
+        for (size_t j = 0; j < count; j++) {
+            const T x = points[j].x;
+            const T y = points[j].y;
+            T n[4], f[4];
+            for (size_t i = 0; i < 4; i++) {
+                const T xy = ax[i] * x + ay[i] * y;
+                n[i] = xy + kn[i];
+                f[i] = xy + kf[i];
+            }
+            const T invW = 1 / n[3];
+            const Vector3T<T> origin (n[0] * invW, n[1] * invW, n[2] * invW);
+            const Vector3T<T> dir (f[0] - origin.x * f[3], f[1] - origin.y * f[3], f[2] - origin.z * f[3]);
+            using std::sqrt;
+            const T invLen = 1 / sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+            rays[j] = RayT<T> {origin, dir * invLen};
+        }
+    }
+
+    ///Projects `count` world space points to pixels (origin top left, y down)
+    ///and depth in one pass, without building homogeneous vectors.
+    ///`clip` receives the ClipFlag bits of each point, 0 if it is inside the frustum.
+    ///Pixels are meaningless for points with ClipNear set, they may be behind the camera.
+    ///Pass nearDepth = 1, farDepth = 0 for ReversedZ projections.
+    ///Runs on up to `threads` threads (0 = all cores)
+    template <typename T>
+    void ProjectToScreen(const Matrix<4, 4, T>& viewProjection, T width, T height,
+                         const Vector3T<T>* points, size_t count, ScreenPointT<T>* screen, uint8_t* clip,
+                         T nearDepth = -1, T farDepth = 1, size_t threads = 0) {
+        ParallelFor(count, chunk, [&](size_t begin, size_t end) {
+            detail::ProjectRange(viewProjection, width, height, points, screen, clip, nearDepth, farDepth, begin, end);
+        }, threads);
+    }
+}
@@ -0,0 +1,309 @@
+#include "Camera.h"
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    bool Near(float a, float b, float eps = 1e-4f) {
+        return std::abs(a - b) <= eps;
+    }
+
+    bool Near(const Vector3& a, const Vector3& b, float eps = 1e-4f) {
+        return Near(a.x, b.x, eps) && Near(a.y, b.y, eps) && Near(a.z, b.z, eps);
+    }
+
+    bool NearIdentity(const Matrix<4, 4>& m, float eps = 1e-5f) {
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t j = 0; j < 4; j++) {
+                if (!Near(m(i, j), i == j ? 1.0f : 0.0f, eps)) { return false; }
+            }
+        }
+        return true;
+    }
+
+    // Both products, a left and a right inverse
+    bool Inverses(const Matrix<4, 4>& m, const Matrix<4, 4>& inverse) {
+        return NearIdentity(m * inverse) && NearIdentity(inverse * m);
+    }
+
+    VectorS<4> Transform(const Matrix<4, 4>& m, const Vector3& p) {
+        return VectorS<4>(m * p.Homogeneous(1));
+    }
+
+    Vector3 TransformPoint(const Matrix<4, 4>& m, const Vector3& p) {
+        const VectorS<4> r = Transform(m, p);
+        return Vector3(r[0], r[1], r[2]);
+    }
+
+    float DistanceToLine(const Ray& r, const Vector3& p) {
+        return Vector3::Cross(p - r.origin, r.direction).Magnitude();
+    }
+
+    // A projection, its closed-form inverse and depth range
+    struct Projection {
+        const char* name;
+        Matrix<4, 4> matrix, inverse;
+        float nearDepth, farDepth;
+    };
+
+    constexpr float fovY = 1.0f, aspect = 1.5f, zNear = 0.1f, zFar = 100.0f;
+
+    std::vector<Projection> Projections() {
+        using namespace camera;
+        return {
+            {"Perspective", Perspective(fovY, aspect, zNear, zFar), PerspectiveInverse(fovY, aspect, zNear, zFar), -1, 1},
+            {"PerspectiveInfinite", PerspectiveInfinite(fovY, aspect, zNear), PerspectiveInfiniteInverse(fovY, aspect, zNear), -1, 1},
+            {"PerspectiveReversedZ", PerspectiveReversedZ(fovY, aspect, zNear, zFar), PerspectiveReversedZInverse(fovY, aspect, zNear, zFar), 1, 0},
+            {"PerspectiveReversedZInfinite", PerspectiveReversedZInfinite(fovY, aspect, zNear), PerspectiveReversedZInfiniteInverse(fovY, aspect, zNear), 1, 0},
+            {"Orthographic", Orthographic(-3.0f, 5.0f, -2.0f, 4.0f, zNear, zFar), OrthographicInverse(-3.0f, 5.0f, -2.0f, 4.0f, zNear, zFar), -1, 1},
+            {"OrthographicReversedZ", OrthographicReversedZ(-3.0f, 5.0f, -2.0f, 4.0f, zNear, zFar), OrthographicReversedZInverse(-3.0f, 5.0f, -2.0f, 4.0f, zNear, zFar), 1, 0},
+        };
+    }
+
+    const Vector3 eye (1, 2, 3), target (4, -1, 0), up (0, 1, 0);
+}
+
+TEST_CASE("[Camera] builders times inverses are identity") {
+    for (const Projection& p : Projections()) {
+        CHECK(Inverses(p.matrix, p.inverse));
+    }
+    // Narrow and wide fields of view, near planes far apart
+    for (const float fov : {0.1f, 2.5f}) {
+        CHECK(Inverses(camera::Perspective(fov, 0.5f, 1.0f, 10.0f), camera::PerspectiveInverse(fov, 0.5f, 1.0f, 10.0f)));
+        CHECK(Inverses(camera::PerspectiveReversedZ(fov, 2.0f, 0.5f, 8.0f), camera::PerspectiveReversedZInverse(fov, 2.0f, 0.5f, 8.0f)));
+    }
+    CHECK(Inverses(camera::LookAt(eye, target, up), camera::LookAtInverse(eye, target, up)));
+    CHECK(Inverses(camera::LookAt(Vector3(0), Vector3(0, -1, -1), up), camera::LookAtInverse(Vector3(0), Vector3(0, -1, -1), up)));
+    CHECK(Inverses(camera::LookAt(Vector3(-5, 0, 2), Vector3(3, 1, 2), Vector3(0, 0, 1)),
+                   camera::LookAtInverse(Vector3(-5, 0, 2), Vector3(3, 1, 2), Vector3(0, 0, 1))));
+}
+
+TEST_CASE("[Camera] depth range") {
+    const auto depth = [](const Matrix<4, 4>& m, float z) {
+        const VectorS<4> c = Transform(m, Vector3(0, 0, z));
+        return c[2] / c[3];
+    };
+    for (const Projection& p : Projections()) {
+        CHECK(Near(depth(p.matrix, -zNear), p.nearDepth));
+        CHECK(Near(depth(p.matrix, -zFar), p.farDepth, 2e-3f));
+    }
+    // LookAt looks down -z at the target
+    const Vector3 t = TransformPoint(camera::LookAt(eye, target, up), target);
+    CHECK(Near(t, Vector3(0, 0, -(target - eye).Magnitude())));
+}
+
+TEST_CASE("[Camera] unprojected ray passes through the projected point") {
+    const Matrix<4, 4> view = camera::LookAt(eye, target, up);
+    const Matrix<4, 4> viewInverse = camera::LookAtInverse(eye, target, up);
+    std::mt19937 rng {1};
+    std::uniform_real_distribution<float> u (-1, 1), d (1, 50);
+    for (const Projection& p : Projections()) {
+        const Matrix<4, 4> viewProjection = p.matrix * view;
+        const Matrix<4, 4> inverse = viewInverse * p.inverse;
+        for (int i = 0; i < 100; i++) {
+            // Somewhere in front of the camera
+            const float z = -d(rng);
+            const Vector3 local (u(rng) * -z * 0.5f, u(rng) * -z * 0.5f, z);
+            const Vector3 world = TransformPoint(viewInverse, local);
+            const VectorS<4> clip = Transform(viewProjection, world);
+            const Vector2 ndc (clip[0] / clip[3], clip[1] / clip[3]);
+            const Ray ray = camera::UnprojectRay(inverse, ndc, p.nearDepth, p.farDepth);
+            CHECK(Near(ray.direction.Magnitude(), 1, 1e-5f));
+            // Relative to the distance, float precision of the projection
+            CHECK(DistanceToLine(ray, world) <= 1e-4f * (world - eye).Magnitude());
+            CHECK(Vector3::Dot(world - ray.origin, ray.direction) > 0);
+        }
+        // Through the center of the screen: along the view direction, from the near plane
+        const Ray center = camera::UnprojectRay(inverse, Vector2(0, 0), p.nearDepth, p.farDepth);
+        CHECK(Near(center.direction, (target - eye).Normalized()));
+        CHECK(Near(Vector3::Dot(center.origin - eye, (target - eye).Normalized()), zNear));
+    }
+}
+
+TEST_CASE("[Camera] UnprojectRays matches UnprojectRay") {
+    const float width = 800, height = 600;
+    const Matrix<4, 4> viewInverse = camera::LookAtInverse(eye, target, up);
+    std::mt19937 rng {2};
+    std::uniform_real_distribution<float> ux (0, width), uy (0, height);
+    // Corners, center, then random pixels, 37 in total
+    std::vector<Vector2> pixels {{0, 0}, {width, 0}, {0, height}, {width, height}, {width / 2, height / 2}};
+    while (pixels.size() < 37) {
+        pixels.push_back(Vector2(ux(rng), uy(rng)));
+    }
+    std::vector<Ray> rays (pixels.size());
+    for (const Projection& p : Projections()) {
+        const Matrix<4, 4> inverse = viewInverse * p.inverse;
+        camera::UnprojectRays(inverse, width, height, pixels.data(), pixels.size(), rays.data(), p.nearDepth, p.farDepth);
+        for (size_t i = 0; i < pixels.size(); i++) {
+            const Vector2 ndc (pixels[i].x * 2 / width - 1, 1 - pixels[i].y * 2 / height);
+            const Ray single = camera::UnprojectRay(inverse, ndc, p.nearDepth, p.farDepth);
+            CHECK(Near(rays[i].origin, single.origin));
+            CHECK(Near(rays[i].direction, single.direction, 1e-5f));
+        }
+    }
+}
+
+TEST_CASE("[Camera] ProjectToScreen clip flags on each side of each plane") {
+    const float width = 640, height = 480;
+    const Matrix<4, 4> view = camera::LookAt(eye, target, up);
+    const Matrix<4, 4> viewInverse = camera::LookAtInverse(eye, target, up);
+    for (const Projection& p : Projections()) {
+        const Matrix<4, 4> viewProjection = p.matrix * view;
+        const Matrix<4, 4> inverse = viewInverse * p.inverse;
+        const float toFar = p.farDepth > p.nearDepth ? 1.0f : -1.0f;
+        const float middle = (p.nearDepth + p.farDepth) / 2;
+        const bool infinite = std::string(p.name).find("Infinite") != std::string::npos;
+        // Normalized device coordinates 2% inside and outside each plane
+        struct Case {
+            Vector3 ndc;
+            uint8_t flags;
+        };
+        std::vector<Case> cases {
+            {{-0.98f, 0, middle}, 0}, {{-1.02f, 0, middle}, camera::ClipLeft},
+            {{0.98f, 0, middle}, 0}, {{1.02f, 0, middle}, camera::ClipRight},
+            {{0, -0.98f, middle}, 0}, {{0, -1.02f, middle}, camera::ClipBottom},
+            {{0, 0.98f, middle}, 0}, {{0, 1.02f, middle}, camera::ClipTop},
+            {{0, 0, p.nearDepth + 0.02f * toFar}, 0}, {{0, 0, p.nearDepth - 0.02f * toFar}, camera::ClipNear},
+            {{0, 0, p.farDepth - 0.02f * toFar}, 0},
+            {{-1.02f, 1.02f, middle}, camera::ClipLeft | camera::ClipTop},
+            {{1.02f, -1.02f, p.nearDepth - 0.02f * toFar}, camera::ClipRight | camera::ClipBottom | camera::ClipNear},
+        };
+        // Perspective depth never gets more than 2n / (f - n) past farDepth, beyond
+        // that and beyond an infinite far plane there are only points behind the camera
+        if (!infinite) {
+            cases.push_back({{0, 0, p.farDepth + 0.0005f * toFar}, camera::ClipFar});
+        }
+        std::vector<Vector3> points;
+        for (const Case& c : cases) {
+            const VectorS<4> h (inverse * c.ndc.Homogeneous(1));
+            points.push_back(Vector3(h[0] / h[3], h[1] / h[3], h[2] / h[3]));
+        }
+        std::vector<ScreenPoint> screen (points.size());
+        std::vector<uint8_t> clip (points.size());
+        camera::ProjectToScreen(viewProjection, width, height, points.data(), points.size(), screen.data(), clip.data(),
+                                p.nearDepth, p.farDepth);
+        for (size_t i = 0; i < cases.size(); i++) {
+            CHECK(clip[i] == cases[i].flags);
+            if (cases[i].flags & camera::ClipNear) { continue; }
+            const Vector3& ndc = cases[i].ndc;
+            CHECK(Near(screen[i].pixel.x, (ndc.x + 1) * width / 2, 2e-3f));
+            CHECK(Near(screen[i].pixel.y, (1 - ndc.y) * height / 2, 2e-3f));
+            CHECK(Near(screen[i].depth, ndc.z, 1e-4f));
+        }
+    }
+}
+
+TEST_CASE("[Camera] ProjectToScreen flags points behind the camera") {
+    const Matrix<4, 4> view = camera::LookAt(eye, target, up);
+    const Vector3 forward = (target - eye).Normalized();
+    const Vector3 side = Vector3::Cross(forward, up).Normalized();
+    // Behind at several distances, off to the side, and in the camera plane where w = 0
+    const std::vector<Vector3> points {
+        eye - forward * 0.5f, eye - forward * 5.0f, eye - forward * 50.0f + side * 3.0f,
+        eye - forward * 2.0f + up * 10.0f, eye + side * 2.0f, eye + up * 0.5f,
+    };
+    std::vector<ScreenPoint> screen (points.size());
+    std::vector<uint8_t> clip (points.size());
+    for (const Projection& p : Projections()) {
+        camera::ProjectToScreen(p.matrix * view, 800.0f, 600.0f, points.data(), points.size(), screen.data(), clip.data(),
+                                p.nearDepth, p.farDepth);
+        for (size_t i = 0; i < points.size(); i++) {
+            CHECK((clip[i] & camera::ClipNear) != 0);
+            // w <= 0 for perspective projections
+            if (p.matrix(3, 2) != 0) {
+                CHECK(Transform(p.matrix * view, points[i])[3] <= 1e-5f);
+            }
+        }
+    }
+}
+
+TEST_CASE("[Camera] ProjectToScreen matches the homogeneous product") {
+    const float width = 640, height = 480;
+    std::mt19937 rng {3};
+    std::uniform_real_distribution<float> u (-30, 30);
+    std::vector<Vector3> points;
+    for (size_t i = 0; i < 2 * camera::chunk + 9; i++) {
+        points.push_back(Vector3(u(rng), u(rng), u(rng) - 20));
+    }
+    const Matrix<4, 4> view = camera::LookAt(Vector3(1, 2, 3), Vector3(0, 0, -15), up);
+    std::vector<ScreenPoint> screen (points.size());
+    std::vector<uint8_t> clip (points.size());
+    for (const Projection& p : Projections()) {
+        const Matrix<4, 4> viewProjection = p.matrix * view;
+        camera::ProjectToScreen(viewProjection, width, height, points.data(), points.size(), screen.data(), clip.data(),
+                                p.nearDepth, p.farDepth, 3);
+        const float toFar = p.farDepth > p.nearDepth ? 1.0f : -1.0f;
+        size_t inside = 0;
+        for (size_t i = 0; i < points.size(); i++) {
+            const VectorS<4> c = Transform(viewProjection, points[i]);
+            const float w = c[3];
+            uint8_t flags = 0;
+            if (c[0] < -w) { flags |= camera::ClipLeft; }
+            if (c[0] > w) { flags |= camera::ClipRight; }
+            if (c[1] < -w) { flags |= camera::ClipBottom; }
+            if (c[1] > w) { flags |= camera::ClipTop; }
+            if ((c[2] - p.nearDepth * w) * toFar < 0) { flags |= camera::ClipNear; }
+            if ((c[2] - p.farDepth * w) * toFar > 0) { flags |= camera::ClipFar; }
+            // Points on a plane may round either way
+            const float slack = 1e-4f * std::abs(w);
+            const bool edge = std::abs(std::abs(c[0]) - std::abs(w)) < slack || std::abs(std::abs(c[1]) - std::abs(w)) < slack
+                           || std::abs(c[2] - p.nearDepth * w) < slack || std::abs(c[2] - p.farDepth * w) < slack;
+            if (!edge) { CHECK(clip[i] == flags); }
+            if (clip[i] == 0) {
+                inside++;
+                CHECK(Near(screen[i].pixel.x, (c[0] / w + 1) * width / 2, 2e-3f));
+                CHECK(Near(screen[i].pixel.y, (1 - c[1] / w) * height / 2, 2e-3f));
+                CHECK(Near(screen[i].depth, c[2] / w, 1e-5f));
+            }
+        }
+        // The orthographic box is small compared with the point cloud
+        CHECK(inside > 50);
+        CHECK(inside < points.size() - 50);
+    }
+}
+
+TEST_CASE("[Camera] ProjectRange matches ProjectToScreen") {
+    std::mt19937 rng {4};
+    std::uniform_real_distribution<float> u (-20, 20);
+    std::vector<Vector3> points;
+    for (size_t i = 0; i < camera::chunk + 37; i++) {
+        points.push_back(Vector3(u(rng), u(rng), u(rng)));
+    }
+    const Matrix<4, 4> viewProjection = Projections()[0].matrix * camera::LookAt(eye, target, up);
+    std::vector<ScreenPoint> expected (points.size());
+    std::vector<uint8_t> expectedClip (points.size());
+    camera::ProjectToScreen(viewProjection, 800.0f, 600.0f, points.data(), points.size(), expected.data(), expectedClip.data(),
+                            -1.0f, 1.0f, 1);
+    // Whole blocks, partial ones at either end, a single point and an empty range
+    const std::pair<size_t, size_t> ranges[] = {{0, 16}, {5, 21}, {16, 53}, {40, 41}, {60, 60}, {100, camera::chunk + 37}};
+    for (const auto& [begin, end] : ranges) {
+        std::vector<ScreenPoint> screen (points.size(), ScreenPoint {Vector2(-1, -1), -7});
+        std::vector<uint8_t> clip (points.size(), 0xFF);
+        camera::detail::ProjectRange(viewProjection, 800.0f, 600.0f, points.data(), screen.data(), clip.data(),
+                                     -1.0f, 1.0f, begin, end);
+        for (size_t i = 0; i < points.size(); i++) {
+            if (i >= begin && i < end) {
+                CHECK(screen[i].pixel == expected[i].pixel);
+                CHECK(screen[i].depth == expected[i].depth);
+                CHECK(clip[i] == expectedClip[i]);
+            } else {
+                // Untouched
+                CHECK(screen[i].depth == -7);
+                CHECK(clip[i] == 0xFF);
+            }
+        }
+    }
+    // Same results with more threads
+    std::vector<ScreenPoint> screen (points.size());
+    std::vector<uint8_t> clip (points.size());
+    camera::ProjectToScreen(viewProjection, 800.0f, 600.0f, points.data(), points.size(), screen.data(), clip.data(),
+                            -1.0f, 1.0f, 4);
+    for (size_t i = 0; i < points.size(); i++) {
+        CHECK(screen[i].pixel == expected[i].pixel);
+        CHECK(clip[i] == expectedClip[i]);
+    }
+}
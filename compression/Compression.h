@@ -0,0 +1,200 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "Quaternion.h"
+
+namespace compression {
+    [[nodiscard]] inline constexpr uint32_t Quantize(float v, float min, float max, uint32_t levels) {
+        const float t = (v - min) / (max - min);
+        const float q = t * float(levels) + 0.5f;
+        return q <= 0 ? 0 : q >= float(levels) ? levels : uint32_t(q);
+    }
+    [[nodiscard]] inline constexpr float Dequantize(uint32_t q, float min, float max, uint32_t levels) {
+        return min + (max - min) * (float(q) / float(levels));
+    }
+    [[nodiscard]] inline constexpr float SignNotZero(float v) {
+        return v < 0 ? -1.0f : 1.0f;
+    }
+}
+
+
+///Smallest-three quaternion encoding in 32, 48 or 64 bits.
+///The largest component is dropped (2 bit index) and restored from the
+///unit length constraint, the other three are stored in (bits - 2) / 3 bits each.
+///Max quantization error of a stored component is maxError, restoring
+///the dropped component raises that to ~2.7x. Measured max error per decoded component:
+///  32 bits (10 per component): 1.9e-3
+///  48 bits (15 per component): 5.8e-5
+///  64 bits (20 per component): 1.9e-6 (limited by float precision)
+template <size_t bits>
+struct PackedQuaternion {
+    static_assert(bits == 32 || bits == 48 || bits == 64, "Only 32, 48 or 64 bit packing is supported");
+    static constexpr size_t componentBits = (bits - 2) / 3;
+    static constexpr uint32_t levels = (uint32_t(1) << componentBits) - 1;
+    static constexpr float range = 0.70710678118654752f;  // 1 / sqrt(2)
+    static constexpr float maxError = range / levels;
+
+    std::array<uint16_t, bits / 16> data;
+
+    ///Input must be a unit quaternion
+    [[nodiscard]] static constexpr PackedQuaternion<bits> Encode(const QuaternionT<float>& q) {
+        const std::array<float, 4> c {q.s, q.v.x, q.v.y, q.v.z};
+        size_t largest = 0;
+        for (size_t i = 1; i < 4; i++) {
+            if (std::abs(c[i]) > std::abs(c[largest])) { largest = i; }
+        }
+        // q and -q are the same rotation, make the dropped component positive
+        const float sign = c[largest] < 0 ? -1.0f : 1.0f;
+        uint64_t packed = largest;
+        for (size_t i = 0, shift = 2; i < 4; i++) {
+            if (i == largest) { continue; }
+            packed |= uint64_t(compression::Quantize(c[i] * sign, -range, range, levels)) << shift;
+            shift += componentBits;
+        }
+        PackedQuaternion<bits> ret {};
+        for (size_t i = 0; i < ret.data.size(); i++) {
+            ret.data[i] = uint16_t(packed >> (16 * i));
+        }
+        return ret;
+    }
+
+    [[nodiscard]] constexpr QuaternionT<float> Decode() const {
+        uint64_t packed = 0;
+        for (size_t i = 0; i < data.size(); i++) {
+            packed |= uint64_t(data[i]) << (16 * i);
+        }
+        const size_t largest = packed & 3;
+        std::array<float, 4> c {};
+        float sumSqr = 0;
+        for (size_t i = 0, shift = 2; i < 4; i++) {
+            if (i == largest) { continue; }
+            const uint32_t q = uint32_t(packed >> shift) & levels;
+            c[i] = compression::Dequantize(q, -range, range, levels);
+            sumSqr += c[i] * c[i];
+            shift += componentBits;
+        }
+        c[largest] = std::sqrt(std::max(0.0f, 1 - sumSqr));
+        return QuaternionT<float> (c[0], {c[1], c[2], c[3]});
+    }
+};
+
+
+///Octahedral encoding of unit vectors in 16 or 32 bits (bits / 2 per axis).
+///Max angular error, for unit input:
+///  16 bits: 0.017 rad (0.95 degrees)
+///  32 bits: 6.5e-5 rad (0.0037 degrees)
+template <size_t bits>
+struct PackedDirection {
+    static_assert(bits == 16 || bits == 32, "Only 16 or 32 bit packing is supported");
+    static constexpr uint32_t levels = (uint32_t(1) << (bits / 2)) - 1;
+    using storage_t = typename std::conditional<bits == 16, uint8_t, uint16_t>::type;
+
+    std::array<storage_t, 2> data;
+
+    ///Input must be a unit vector
+    [[nodiscard]] static constexpr PackedDirection<bits> Encode(const Vector3T<float>& v) {
+        const float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+        float u = v.x / l1;
+        float w = v.y / l1;
+        if (v.z < 0) {
+            const float u2 = (1 - std::abs(w)) * compression::SignNotZero(u);
+            w = (1 - std::abs(u)) * compression::SignNotZero(w);
+            u = u2;
+        }
+        return PackedDirection<bits> {{
+            storage_t(compression::Quantize(u, -1, 1, levels)),
+            storage_t(compression::Quantize(w, -1, 1, levels)),
+        }};
+    }
+
+    [[nodiscard]] constexpr Vector3T<float> Decode() const {
+        Vector3T<float> v (
+            compression::Dequantize(data[0], -1, 1, levels),
+            compression::Dequantize(data[1], -1, 1, levels),
+            0
+        );
+        v.z = 1 - std::abs(v.x) - std::abs(v.y);
+        const float t = std::max(-v.z, 0.0f);
+        v.x += v.x >= 0 ? -t : t;
+        v.y += v.y >= 0 ? -t : t;
+        return v.Normalized();
+    }
+};
+
+
+///Quantizes positions inside a fixed box to 16 bits per axis.
+///Max error per axis is (max - min) / 65535 / 2, see MaxError().
+template <typename T>
+struct PositionQuantizerT {
+    static constexpr uint32_t levels = 65535;
+    Vector3T<T> min;
+    Vector3T<T> max;
+
+    constexpr PositionQuantizerT(const Vector3T<T>& min, const Vector3T<T>& max) : min(min), max(max) { }
+
+    [[nodiscard]] constexpr Vector3T<T> MaxError() const {
+        return (max - min) / T(levels * 2);
+    }
+
+    ///Positions outside the box are clamped to it
+    [[nodiscard]] constexpr std::array<uint16_t, 3> Encode(const Vector3T<T>& p) const {
+        return {
+            uint16_t(compression::Quantize(p.x, min.x, max.x, levels)),
+            uint16_t(compression::Quantize(p.y, min.y, max.y, levels)),
+            uint16_t(compression::Quantize(p.z, min.z, max.z, levels)),
+        };
+    }
+
+    [[nodiscard]] constexpr Vector3T<T> Decode(const std::array<uint16_t, 3>& q) const {
+        return Vector3T<T> (
+            compression::Dequantize(q[0], min.x, max.x, levels),
+            compression::Dequantize(q[1], min.y, max.y, levels),
+            compression::Dequantize(q[2], min.z, max.z, levels)
+        );
+    }
+
+    void EncodeBatch(const Vector3T<T>* in, size_t count, std::array<uint16_t, 3>* out) const {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = Encode(in[i]);
+        }
+    }
+
+    void DecodeBatch(const std::array<uint16_t, 3>* in, size_t count, Vector3T<T>* out) const {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = Decode(in[i]);
+        }
+    }
+};
+
+
+template <size_t bits>
+void EncodeQuaternions(const QuaternionT<float>* in, size_t count, PackedQuaternion<bits>* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = PackedQuaternion<bits>::Encode(in[i]);
+    }
+}
+
+template <size_t bits>
+void DecodeQuaternions(const PackedQuaternion<bits>* in, size_t count, QuaternionT<float>* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = in[i].Decode();
+    }
+}
+
+template <size_t bits>
+void EncodeDirections(const Vector3T<float>* in, size_t count, PackedDirection<bits>* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = PackedDirection<bits>::Encode(in[i]);
+    }
+}
+
+template <size_t bits>
+void DecodeDirections(const PackedDirection<bits>* in, size_t count, Vector3T<float>* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = in[i].Decode();
+    }
+}
+
+typedef PositionQuantizerT<float> PositionQuantizer;
@@ -0,0 +1,180 @@
+#include "Compression.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    Quaternion RandomRotation(std::mt19937& rng) {
+        std::normal_distribution<float> n;
+        const Quaternion q (n(rng), {n(rng), n(rng), n(rng)});
+        return q.Normalized();
+    }
+
+    Vector3 RandomDirection(std::mt19937& rng) {
+        std::normal_distribution<float> n;
+        return Vector3(n(rng), n(rng), n(rng)).Normalized();
+    }
+
+    // Largest component error against q or -q, whichever is closer
+    float QuaternionError(const Quaternion& a, const Quaternion& b) {
+        const float sign = Quaternion::Dot(a, b) < 0 ? -1.0f : 1.0f;
+        return std::max({std::abs(a.s - b.s * sign), std::abs(a.v.x - b.v.x * sign),
+                         std::abs(a.v.y - b.v.y * sign), std::abs(a.v.z - b.v.z * sign)});
+    }
+
+    float Angle(const Vector3& a, const Vector3& b) {
+        return std::atan2(Vector3::Cross(a, b).Magnitude(), Vector3::Dot(a, b));
+    }
+
+    template <size_t bits>
+    float MaxQuaternionError(const std::vector<Quaternion>& inputs) {
+        float maxErr = 0;
+        for (const Quaternion& q : inputs) {
+            const PackedQuaternion<bits> packed = PackedQuaternion<bits>::Encode(q);
+            maxErr = std::max(maxErr, QuaternionError(packed.Decode(), q));
+            // q and -q are the same rotation and encode to the same bits
+            const PackedQuaternion<bits> negated = PackedQuaternion<bits>::Encode(Quaternion(-q.s, -q.v));
+            CHECK(negated.data == packed.data);
+        }
+        return maxErr;
+    }
+
+    template <size_t bits>
+    float MaxDirectionError(const std::vector<Vector3>& inputs) {
+        float maxErr = 0;
+        for (const Vector3& v : inputs) {
+            const Vector3 decoded = PackedDirection<bits>::Encode(v).Decode();
+            CHECK(std::abs(decoded.Magnitude() - 1) < 1e-5f);
+            maxErr = std::max(maxErr, Angle(decoded, v));
+        }
+        return maxErr;
+    }
+
+    std::vector<Quaternion> QuaternionInputs() {
+        std::vector<Quaternion> inputs;
+        const float h = std::sqrt(0.5f);
+        // Each component the largest one, with either sign
+        for (int i = 0; i < 4; i++) {
+            for (const float sign : {1.0f, -1.0f}) {
+                std::array<float, 4> c {0.1f, -0.2f, 0.3f, -0.1f};
+                c[i] = sign * 0.9f;
+                inputs.push_back(Quaternion(c[0], {c[1], c[2], c[3]}).Normalized());
+            }
+        }
+        inputs.push_back(Quaternion::Identity());
+        inputs.push_back(Quaternion(0, {0, 0, -1}));
+        // Ties for the largest component, stored components at the range limit
+        inputs.push_back(Quaternion(h, {h, 0, 0}));
+        inputs.push_back(Quaternion(0, {-h, 0, h}));
+        inputs.push_back(Quaternion(0.5f, {-0.5f, 0.5f, -0.5f}));
+        std::mt19937 rng {1};
+        for (int i = 0; i < 100000; i++) {
+            inputs.push_back(RandomRotation(rng));
+        }
+        return inputs;
+    }
+
+    std::vector<Vector3> DirectionInputs() {
+        std::vector<Vector3> inputs {
+            Vector3(0, 0, 1), Vector3(0, 0, -1),
+            Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(0, 1, 0), Vector3(0, -1, 0),
+        };
+        // Octahedral fold edges: the equator and |x| + |y| = 1 folded into z < 0
+        for (int i = 0; i < 360; i++) {
+            const float a = float(i) * 0.0174532925f;
+            inputs.push_back(Vector3(std::cos(a), std::sin(a), 0));
+            inputs.push_back(Vector3(std::cos(a), std::sin(a), -1e-4f).Normalized());
+            inputs.push_back(Vector3(std::cos(a), std::sin(a), -50).Normalized());
+        }
+        inputs.push_back(Vector3(1, 1, -1).Normalized());
+        inputs.push_back(Vector3(-1, 0, -1).Normalized());
+        std::mt19937 rng {2};
+        for (int i = 0; i < 100000; i++) {
+            inputs.push_back(RandomDirection(rng));
+        }
+        return inputs;
+    }
+}
+
+TEST_CASE("[Compression] quaternion error bounds") {
+    const std::vector<Quaternion> inputs = QuaternionInputs();
+    CHECK(MaxQuaternionError<32>(inputs) <= 1.9e-3f);
+    CHECK(MaxQuaternionError<48>(inputs) <= 5.8e-5f);
+    CHECK(MaxQuaternionError<64>(inputs) <= 1.9e-6f);
+    CHECK(sizeof(PackedQuaternion<32>) == 4);
+    CHECK(sizeof(PackedQuaternion<48>) == 6);
+    CHECK(sizeof(PackedQuaternion<64>) == 8);
+}
+
+TEST_CASE("[Compression] quaternion drops the largest component") {
+    const Quaternion q (0.1f, {-0.2f, -0.9539392f, 0.2f});
+    const PackedQuaternion<48> packed = PackedQuaternion<48>::Encode(q);
+    CHECK((packed.data[0] & 3) == 2);
+    // The dropped component comes back positive, the rest flip with it
+    const Quaternion d = packed.Decode();
+    CHECK(d.v.y > 0.95f);
+    CHECK(std::abs(d.s + 0.1f) < 1e-4f);
+}
+
+TEST_CASE("[Compression] direction error bounds") {
+    const std::vector<Vector3> inputs = DirectionInputs();
+    CHECK(MaxDirectionError<16>(inputs) <= 0.017f);
+    CHECK(MaxDirectionError<32>(inputs) <= 6.5e-5f);
+    // Poles come back exactly
+    CHECK(PackedDirection<16>::Encode(Vector3(0, 0, -1)).Decode() == Vector3(0, 0, -1));
+    CHECK(PackedDirection<32>::Encode(Vector3(0, 0, 1)).Decode().z == 1);
+}
+
+TEST_CASE("[Compression] position error bounds and clamping") {
+    const PositionQuantizer world (Vector3(-100, 0, -5), Vector3(100, 50, 5));
+    const Vector3 maxError = world.MaxError();
+    std::mt19937 rng {3};
+    std::uniform_real_distribution<float> ux (-100, 100), uy (0, 50), uz (-5, 5);
+    std::vector<Vector3> points {world.min, world.max, Vector3(0, 25, 0)};
+    for (int i = 0; i < 10000; i++) {
+        points.push_back(Vector3(ux(rng), uy(rng), uz(rng)));
+    }
+    std::vector<std::array<uint16_t, 3>> packed (points.size());
+    std::vector<Vector3> decoded (points.size());
+    world.EncodeBatch(points.data(), points.size(), packed.data());
+    world.DecodeBatch(packed.data(), packed.size(), decoded.data());
+    for (size_t i = 0; i < points.size(); i++) {
+        // Slack for float rounding of the box coordinates themselves
+        for (int a = 0; a < 3; a++) {
+            CHECK(std::abs(decoded[i][a] - points[i][a]) <= maxError[a] * 1.01f + 1e-5f);
+        }
+    }
+
+    // Outside the box: clamped to its faces
+    CHECK(world.Decode(world.Encode(Vector3(1000, -1000, 5.5f))) == Vector3(100, 0, 5));
+    CHECK(world.Decode(world.Encode(Vector3(-1000, 1000, -6))) == Vector3(-100, 50, -5));
+    CHECK(world.Encode(world.max) == std::array<uint16_t, 3> {65535, 65535, 65535});
+    CHECK(world.Encode(world.min) == std::array<uint16_t, 3> {0, 0, 0});
+}
+
+TEST_CASE("[Compression] batch functions match single ones") {
+    std::mt19937 rng {4};
+    std::vector<Quaternion> q;
+    std::vector<Vector3> v;
+    for (int i = 0; i < 37; i++) {
+        q.push_back(RandomRotation(rng));
+        v.push_back(RandomDirection(rng));
+    }
+    std::vector<PackedQuaternion<32>> pq (q.size());
+    std::vector<PackedDirection<32>> pv (v.size());
+    std::vector<Quaternion> dq (q.size(), Quaternion::Identity());
+    std::vector<Vector3> dv (v.size());
+    EncodeQuaternions(q.data(), q.size(), pq.data());
+    DecodeQuaternions(pq.data(), pq.size(), dq.data());
+    EncodeDirections(v.data(), v.size(), pv.data());
+    DecodeDirections(pv.data(), pv.size(), dv.data());
+    for (size_t i = 0; i < q.size(); i++) {
+        CHECK(pq[i].data == PackedQuaternion<32>::Encode(q[i]).data);
+        CHECK(QuaternionError(dq[i], pq[i].Decode()) == 0);
+        CHECK(pv[i].data == PackedDirection<32>::Encode(v[i]).data);
+        CHECK(dv[i] == pv[i].Decode());
+    }
+}
@@ -0,0 +1,387 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+
+#ifndef NO_MATRIX_DEP
+#include "Matrix.h"
+#endif /* NO_MATRIX_DEP */
+
+#ifndef MATRIX_REAL_TYPE
+#define MATRIX_REAL_TYPE
+///Type of non-integer results (magnitudes, angles, factors) for elements of type T.
+///Integers and 16 bit floats use float. Specialize it for custom number types.
+template <typename T>
+struct RealType {
+    using type = typename std::conditional<
+        std::is_floating_point<T>::value && (sizeof(T) >= sizeof(float)),
+        T, float>::type;
+};
+#endif /* MATRIX_REAL_TYPE */
+
+namespace fixed {
+    ///Portable unsigned 128 bit integer, used for Q32.32 when the
+    ///compiler has no __int128 (or FIXED_NO_INT128 is defined).
+    ///Exact, so both paths give the same bits.
+    struct U128 {
+        uint64_t hi;
+        uint64_t lo;
+
+        constexpr U128() : hi(0), lo(0) { }
+        constexpr U128(uint64_t v) : hi(0), lo(v) { }
+        constexpr U128(uint64_t hi, uint64_t lo) : hi(hi), lo(lo) { }
+        explicit constexpr operator uint64_t() const { return lo; }
+
+        friend constexpr U128 operator+(U128 a, U128 b) {
+            const uint64_t lo = a.lo + b.lo;
+            return U128(a.hi + b.hi + (lo < a.lo), lo);
+        }
+        friend constexpr U128 operator-(U128 a, U128 b) {
+            return U128(a.hi - b.hi - (a.lo < b.lo), a.lo - b.lo);
+        }
+        friend constexpr U128 operator-(U128 a) { return U128(0) - a; }
+        friend constexpr U128 operator|(U128 a, U128 b) { return U128(a.hi | b.hi, a.lo | b.lo); }
+        friend constexpr U128 operator<<(U128 a, unsigned s) {
+            if (s == 0) { return a; }
+            if (s >= 64) { return U128(a.lo << (s - 64), 0); }
+            return U128(a.hi << s | a.lo >> (64 - s), a.lo << s);
+        }
+        friend constexpr U128 operator>>(U128 a, unsigned s) {
+            if (s == 0) { return a; }
+            if (s >= 64) { return U128(0, a.hi >> (s - 64)); }
+            return U128(a.hi >> s, a.lo >> s | a.hi << (64 - s));
+        }
+        ///Low 128 bits of the product
+        friend constexpr U128 operator*(U128 a, U128 b) {
+            const uint64_t a0 = a.lo & 0xFFFFFFFF, a1 = a.lo >> 32;
+            const uint64_t b0 = b.lo & 0xFFFFFFFF, b1 = b.lo >> 32;
+            const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+            const uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF);
+            const uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+            return U128(hi + a.hi * b.lo + a.lo * b.hi, (mid << 32) | (p00 & 0xFFFFFFFF));
+        }
+        ///Restoring long division
+        friend constexpr U128 operator/(U128 n, U128 d) {
+            U128 q, r;
+            for (unsigned i = 128; i-- > 0;) {
+                r = r << 1 | ((n >> i).lo & 1);
+                if (r >= d) {
+                    r = r - d;
+                    q = q | (U128(1) << i);
+                }
+            }
+            return q;
+        }
+        friend constexpr bool operator==(U128 a, U128 b) { return a.hi == b.hi && a.lo == b.lo; }
+        friend constexpr bool operator!=(U128 a, U128 b) { return !(a == b); }
+        friend constexpr bool operator<(U128 a, U128 b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+        friend constexpr bool operator>(U128 a, U128 b) { return b < a; }
+        friend constexpr bool operator>=(U128 a, U128 b) { return !(a < b); }
+    };
+
+    namespace detail {
+        template <typename Int> struct Wide;
+        template <> struct Wide<int32_t> {
+            using type = int64_t;
+            using utype = uint64_t;
+        };
+        template <> struct Wide<int64_t> {
+#if defined(__SIZEOF_INT128__) && !defined(FIXED_NO_INT128)
+            // __extension__ silences -Wpedantic
+            __extension__ typedef __int128 type;
+            __extension__ typedef unsigned __int128 utype;
+#else
+            using type = U128;
+            using utype = U128;
+#endif
+        };
+
+        ///|v| as unsigned, defined for the minimum value too
+        template <typename Int>
+        [[nodiscard]] constexpr typename std::make_unsigned<Int>::type Abs(Int v) {
+            using UInt = typename std::make_unsigned<Int>::type;
+            return v < 0 ? UInt(0) - UInt(v) : UInt(v);
+        }
+
+        ///round(a * b / 2^shift), halves round up
+        template <size_t shift, typename Int>
+        [[nodiscard]] constexpr Int MulShift(Int a, Int b) {
+            using W = typename Wide<Int>::type;
+            if constexpr (std::is_same<W, U128>::value) {
+                // Two's complement product, low 64 bits of the floor shift
+                // are the same for logical and arithmetic shifts
+                U128 p = U128(Abs(a)) * U128(Abs(b));
+                if ((a < 0) != (b < 0)) { p = -p; }
+                p = p + (U128(1) << (shift - 1));
+                return Int(uint64_t(p >> shift));
+            } else {
+                const W p = W(a) * W(b) + (W(1) << (shift - 1));
+                return Int(p >> shift);
+            }
+        }
+
+        ///a * 2^shift / b, truncated towards zero. b must not be 0
+        template <size_t shift, typename Int>
+        [[nodiscard]] constexpr Int DivShift(Int a, Int b) {
+            using W = typename Wide<Int>::type;
+            using UInt = typename std::make_unsigned<Int>::type;
+            if constexpr (std::is_same<W, U128>::value) {
+                const UInt q = UInt(uint64_t((U128(Abs(a)) << shift) / U128(Abs(b))));
+                return Int((a < 0) != (b < 0) ? UInt(0) - q : q);
+            } else {
+                return Int(W(a) * (W(1) << shift) / W(b));
+            }
+        }
+
+        ///round(sqrt(v))
+        template <typename UW>
+        [[nodiscard]] constexpr UW ISqrt(UW v) {
+            UW res = 0;
+            UW bit = UW(1) << (sizeof(UW) * 8 - 2);
+            while (bit > v) { bit = bit >> 2; }
+            while (bit != 0) {
+                if (v >= res + bit) {
+                    v = v - (res + bit);
+                    res = (res >> 1) + bit;
+                } else {
+                    res = res >> 1;
+                }
+                bit = bit >> 2;
+            }
+            // v is now the remainder v - res²
+            if (v > res) { res = res + 1; }
+            return res;
+        }
+    }
+}
+
+
+///Signed fixed-point number with `frac` fractional bits, stored in `Int`.
+///Every operation is integer arithmetic, so results are bit-identical
+///across compilers, flags and platforms. Use it as the element type of
+///Matrix, VectorS, Vector3T and QuaternionT for lockstep simulation.
+///
+///Multiplication rounds to nearest (halves up), division truncates towards
+///zero and saturates on division by zero, addition wraps on overflow.
+///Conversion from floating point is exact up to the final rounding,
+///but beware of computing the float itself differently on each platform.
+template <typename Int, size_t frac>
+class FixedT {
+    static_assert(std::is_same<Int, int32_t>::value || std::is_same<Int, int64_t>::value,
+                  "Only int32_t and int64_t storage is supported");
+    static_assert(frac > 0 && frac < sizeof(Int) * 8 - 1, "Invalid number of fractional bits");
+    using UInt = typename std::make_unsigned<Int>::type;
+    using UWide = typename fixed::detail::Wide<Int>::utype;
+public:
+    static constexpr size_t fracBits = frac;
+    static constexpr Int one = Int(1) << frac;
+
+    Int raw;
+
+    FixedT() = default;
+    template <typename I, typename std::enable_if<std::is_integral<I>::value, int>::type = 0>
+    constexpr FixedT(I v) : raw(Int(UInt(v) << frac)) { }
+    ///Rounds to nearest, halves away from zero
+    template <typename F, typename std::enable_if<std::is_floating_point<F>::value, int>::type = 0>
+    constexpr FixedT(F v) : raw(0) {
+        // Scaling by a power of two and splitting off the integer part are exact
+        const double scaled = double(v) * double(one);
+        Int i = Int(scaled);
+        const double rem = scaled - double(i);
+        if (rem >= 0.5) { i++; }
+        if (rem <= -0.5) { i--; }
+        raw = i;
+    }
+    ///Between precisions, rounds to nearest when dropping bits
+    template <typename Int2, size_t frac2>
+    explicit constexpr FixedT(FixedT<Int2, frac2> v) : raw(0) {
+        if constexpr (frac2 > frac) {
+            const Int2 half = Int2(1) << (frac2 - frac - 1);
+            raw = Int((v.raw + half) >> (frac2 - frac));
+        } else {
+            raw = Int(typename std::make_unsigned<Int>::type(Int(v.raw)) << (frac - frac2));
+        }
+    }
+
+    [[nodiscard]] static constexpr FixedT FromRaw(Int raw) {
+        FixedT ret;
+        ret.raw = raw;
+        return ret;
+    }
+
+    [[nodiscard]] explicit constexpr operator double() const { return double(raw) / double(one); }
+    [[nodiscard]] explicit constexpr operator float() const { return float(double(*this)); }
+    [[nodiscard]] explicit constexpr operator bool() const { return raw != 0; }
+    ///Rounds towards negative infinity
+    [[nodiscard]] explicit constexpr operator int() const { return int(raw >> frac); }
+
+    [[nodiscard]] static constexpr FixedT Pi() { return FixedT(3.14159265358979323846); }
+    [[nodiscard]] static constexpr FixedT HalfPi() { return FixedT(1.57079632679489661923); }
+    [[nodiscard]] static constexpr FixedT TwoPi() { return FixedT(6.28318530717958647692); }
+
+    [[nodiscard]] friend constexpr FixedT operator+(FixedT a, FixedT b) { return FromRaw(Int(UInt(a.raw) + UInt(b.raw))); }
+    [[nodiscard]] friend constexpr FixedT operator-(FixedT a, FixedT b) { return FromRaw(Int(UInt(a.raw) - UInt(b.raw))); }
+    [[nodiscard]] friend constexpr FixedT operator-(FixedT a) { return FromRaw(Int(UInt(0) - UInt(a.raw))); }
+    [[nodiscard]] friend constexpr FixedT operator+(FixedT a) { return a; }
+    [[nodiscard]] friend constexpr FixedT operator*(FixedT a, FixedT b) {
+        return FromRaw(fixed::detail::MulShift<frac>(a.raw, b.raw));
+    }
+    [[nodiscard]] friend constexpr FixedT operator/(FixedT a, FixedT b) {
+        if (b.raw == 0) { return a.raw < 0 ? std::numeric_limits<FixedT>::lowest() : std::numeric_limits<FixedT>::max(); }
+        return FromRaw(fixed::detail::DivShift<frac>(a.raw, b.raw));
+    }
+
+    constexpr FixedT& operator+=(FixedT v) { return *this = *this + v; }
+    constexpr FixedT& operator-=(FixedT v) { return *this = *this - v; }
+    constexpr FixedT& operator*=(FixedT v) { return *this = *this * v; }
+    constexpr FixedT& operator/=(FixedT v) { return *this = *this / v; }
+
+    [[nodiscard]] friend constexpr bool operator==(FixedT a, FixedT b) { return a.raw == b.raw; }
+    [[nodiscard]] friend constexpr bool operator!=(FixedT a, FixedT b) { return a.raw != b.raw; }
+    [[nodiscard]] friend constexpr bool operator<(FixedT a, FixedT b) { return a.raw < b.raw; }
+    [[nodiscard]] friend constexpr bool operator>(FixedT a, FixedT b) { return a.raw > b.raw; }
+    [[nodiscard]] friend constexpr bool operator<=(FixedT a, FixedT b) { return a.raw <= b.raw; }
+    [[nodiscard]] friend constexpr bool operator>=(FixedT a, FixedT b) { return a.raw >= b.raw; }
+
+    // Math functions, found by ADL from Vector.h and Quaternion.h
+    // (`using std::sqrt; sqrt(x);`). All are deterministic.
+
+    [[nodiscard]] friend constexpr FixedT abs(FixedT v) { return v.raw < 0 ? -v : v; }
+
+    ///Rounded to nearest, 0 for negative input
+    [[nodiscard]] friend constexpr FixedT sqrt(FixedT v) {
+        if (v.raw <= 0) { return 0; }
+        const UWide r = fixed::detail::ISqrt(UWide(UInt(v.raw)) << frac);
+        return FromRaw(Int(uint64_t(r)));
+    }
+
+    ///Sums squares in double width, so it doesn't overflow
+    ///for any representable result
+    [[nodiscard]] friend constexpr FixedT hypot(FixedT x, FixedT y) {
+        return FromRaw(Int(uint64_t(fixed::detail::ISqrt(Sqr(x) + Sqr(y)))));
+    }
+    [[nodiscard]] friend constexpr FixedT hypot(FixedT x, FixedT y, FixedT z) {
+        return FromRaw(Int(uint64_t(fixed::detail::ISqrt(Sqr(x) + Sqr(y) + Sqr(z)))));
+    }
+
+    [[nodiscard]] friend constexpr FixedT sin(FixedT x) {
+        FixedT r = Reduce(x);
+        // sin(x) = sin(π - x)
+        if (r > HalfPi()) { r = Pi() - r; }
+        else if (r < -HalfPi()) { r = -Pi() - r; }
+        return r * Series(r * r, 2);
+    }
+
+    [[nodiscard]] friend constexpr FixedT cos(FixedT x) {
+        const FixedT r = abs(Reduce(x));
+        // cos(x) = -cos(π - x)
+        if (r > HalfPi()) {
+            const FixedT t = Pi() - r;
+            return -Series(t * t, 1);
+        }
+        return Series(r * r, 1);
+    }
+
+    [[nodiscard]] friend constexpr FixedT atan(FixedT x) {
+        if (x.raw < 0) { return -atan(-x); }
+        if (x > FixedT(1)) { return HalfPi() - atan(FixedT(1) / x); }
+        // atan(x) = π/4 + atan((x - 1) / (x + 1)), so that |x| <= tan(π/8)
+        FixedT offset = 0;
+        if (x > FixedT(0.41421356237309504880)) {
+            offset = FromRaw(Pi().raw / 4);
+            x = (x - FixedT(1)) / (x + FixedT(1));
+        }
+        // x - x³/3 + x⁵/5 - ... up to x²⁵
+        const FixedT x2 = x * x;
+        FixedT r = FromRaw(one / 25);
+        for (int k = 11; k >= 0; k--) {
+            r = FromRaw(one / (2 * k + 1)) - x2 * r;
+        }
+        return offset + x * r;
+    }
+
+    ///Input is clamped to [-1, 1]
+    [[nodiscard]] friend constexpr FixedT acos(FixedT x) {
+        if (x.raw < 0) { return Pi() - acos(-x); }
+        if (x >= FixedT(1)) { return 0; }
+        // acos(x) = 2 atan(sqrt((1 - x) / (1 + x))), 1 - x is exact
+        // so take its root before dividing
+        const FixedT a = atan(sqrt(FixedT(1) - x) / sqrt(FixedT(1) + x));
+        return a + a;
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, FixedT v) {
+        return o << double(v);
+    }
+
+private:
+    [[nodiscard]] static constexpr UWide Sqr(FixedT v) {
+        const UWide a = UWide(uint64_t(fixed::detail::Abs(v.raw)));
+        return a * a;
+    }
+
+    ///x to [-π, π]
+    [[nodiscard]] static constexpr FixedT Reduce(FixedT x) {
+        const Int twoPi = TwoPi().raw;
+        Int r = x.raw % twoPi;
+        if (r > Pi().raw) { r -= twoPi; }
+        else if (r < -Pi().raw) { r += twoPi; }
+        return FromRaw(r);
+    }
+
+    ///Taylor series of sin(x) / x (start = 2) or cos(x) (start = 1)
+    ///in Horner form, x2 = x² <= (π/2)²
+    [[nodiscard]] static constexpr FixedT Series(FixedT x2, int start) {
+        FixedT r = 1;
+        for (int k = 9; k >= 1; k--) {
+            const int d = (2 * k + start - 2) * (2 * k + start - 1);
+            r = FixedT(1) - FromRaw((x2 * r).raw / d);
+        }
+        return r;
+    }
+};
+
+///Q16.16: range ±32768, precision 1.5e-5
+typedef FixedT<int32_t, 16> Fixed16;
+///Q32.32: range ±2.1e9, precision 2.3e-10
+typedef FixedT<int64_t, 32> Fixed32;
+
+static_assert(std::is_trivially_copyable<Fixed16>::value, "FixedT must be trivially copyable");
+static_assert(sizeof(Fixed16) == sizeof(int32_t), "FixedT must not have padding");
+
+namespace std {
+template <typename Int, size_t frac>
+class numeric_limits<FixedT<Int, frac>> {
+    using F = FixedT<Int, frac>;
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = true;
+    static constexpr bool has_infinity = false;
+    static constexpr bool has_quiet_NaN = false;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = true;
+    static constexpr int radix = 2;
+    static constexpr int digits = std::numeric_limits<Int>::digits;
+    static constexpr F min() noexcept { return F::FromRaw(1); }
+    static constexpr F max() noexcept { return F::FromRaw(std::numeric_limits<Int>::max()); }
+    static constexpr F lowest() noexcept { return F::FromRaw(std::numeric_limits<Int>::min()); }
+    static constexpr F epsilon() noexcept { return F::FromRaw(1); }
+    static constexpr F round_error() noexcept { return F::FromRaw(Int(1) << (frac - 1)); }
+};
+}
+
+///Magnitudes, angles and factors stay fixed-point
+template <typename Int, size_t frac>
+struct RealType<FixedT<Int, frac>> { using type = FixedT<Int, frac>; };
+
+#ifndef NO_MATRIX_DEP
+///Q16.16 products are exact in Q32.32, so sums only round once
+template <> struct MatrixAccumulator<Fixed16> { using type = Fixed32; };
+
+template <typename Int, size_t frac>
+struct MatrixReciprocalDivide<FixedT<Int, frac>> : std::true_type { };
+#endif /* NO_MATRIX_DEP */
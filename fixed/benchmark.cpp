@@ -0,0 +1,97 @@
+// Time per call of the operations a lockstep simulation spends most time in,
+// with float, Fixed16 and Fixed32 elements. Generates the table in README.md.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <vector>
+#include "Fixed.h"
+#include "Quaternion.h"
+
+namespace {
+    constexpr size_t count = 1024;
+
+    // Nanoseconds per item, best of a few runs
+    double Measure(const std::function<void()>& f) {
+        using Clock = std::chrono::steady_clock;
+        double best = 1e30;
+        for (int run = 0; run < 5; run++) {
+            constexpr int reps = 20;
+            const auto start = Clock::now();
+            for (int r = 0; r < reps; r++) {
+                f();
+                // Keep the compiler from dropping or merging repetitions
+                asm volatile("" : : : "memory");
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            best = std::min(best, seconds / (count * reps) * 1e9);
+        }
+        return best;
+    }
+
+    // Same inputs for every element type, converted from float
+    template <typename T>
+    struct Data {
+        std::vector<Matrix<4, 4, T>> a, b, matrices;
+        std::vector<QuaternionT<T>> rotations;
+        std::vector<Vector3T<T>> points, rotated;
+        std::vector<T> angles, sines, cosines;
+
+        Data() {
+            std::mt19937 rng {42};
+            std::uniform_real_distribution<float> dist {-1, 1};
+            for (size_t i = 0; i < count; i++) {
+                Matrix<4, 4, T> ma, mb;
+                for (size_t e = 0; e < 16; e++) {
+                    // Diagonally dominant, so every inverse exists
+                    ma[e] = T(dist(rng) + (e % 5 == 0 ? 4 : 0));
+                    mb[e] = T(dist(rng));
+                }
+                a.push_back(ma);
+                b.push_back(mb);
+                const Quaternion q = Quaternion::Euler(dist(rng) * 3, dist(rng) * 3, dist(rng) * 3);
+                rotations.push_back(QuaternionT<T>(T(q.s), Vector3T<T>(T(q.v.x), T(q.v.y), T(q.v.z))));
+                points.push_back(Vector3T<T>(T(dist(rng) * 100), T(dist(rng) * 100), T(dist(rng) * 100)));
+                angles.push_back(T(dist(rng) * 10));
+            }
+            matrices.resize(count);
+            rotated.resize(count);
+            sines.resize(count);
+            cosines.resize(count);
+        }
+    };
+
+    template <typename T>
+    std::vector<double> Run() {
+        Data<T> d;
+        return {
+            Measure([&] {
+                for (size_t i = 0; i < count; i++) { d.matrices[i] = d.a[i] * d.b[i]; }
+            }),
+            Measure([&] {
+                for (size_t i = 0; i < count; i++) { d.matrices[i] = d.a[i].Inverse(); }
+            }),
+            Measure([&] {
+                for (size_t i = 0; i < count; i++) { d.rotated[i] = d.rotations[i].Rotate(d.points[i]); }
+            }),
+            Measure([&] {
+                using std::sin, std::cos;
+                for (size_t i = 0; i < count; i++) {
+                    d.sines[i] = sin(d.angles[i]);
+                    d.cosines[i] = cos(d.angles[i]);
+                }
+            }),
+        };
+    }
+}
+
+int main() {
+    const char* names[] = {"4x4 multiply", "4x4 inverse", "Quaternion rotate", "sin + cos"};
+    const std::vector<double> results[] = {Run<float>(), Run<Fixed16>(), Run<Fixed32>()};
+    std::printf("ns per call          float  Fixed16  Fixed32\n");
+    for (size_t op = 0; op < std::size(names); op++) {
+        std::printf("%-18s %7.1f  %7.1f  %7.1f\n", names[op], results[0][op], results[1][op], results[2][op]);
+    }
+}
@@ -0,0 +1,104 @@
+#include "Fixed.h"
+#include "Quaternion.h"
+#include <cmath>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+// Raw values below are golden: every platform must produce exactly these bits
+
+TEST_CASE("[Fixed] conversions") {
+    CHECK(Fixed16(1).raw == 65536);
+    CHECK(Fixed16(-3).raw == -196608);
+    CHECK(Fixed16(0.5).raw == 32768);
+    CHECK(Fixed16(-1.25f).raw == -81920);
+    CHECK(Fixed16(1.0 / 65536 / 2).raw == 1);     // halves away from zero
+    CHECK(Fixed16(-1.0 / 65536 / 2).raw == -1);
+    CHECK(Fixed32(0.1).raw == 429496730);
+    CHECK(double(Fixed16::FromRaw(98304)) == 1.5);
+    CHECK(int(Fixed16(-1.5)) == -2);
+    CHECK(Fixed16(Fixed32(2.75)).raw == Fixed16(2.75).raw);
+    CHECK(Fixed32(Fixed16(-2.75)).raw == Fixed32(-2.75).raw);
+    CHECK(Fixed16(Fixed32::FromRaw(int64_t(1) << 15)).raw == 1);
+}
+
+TEST_CASE("[Fixed] arithmetic") {
+    CHECK((Fixed16(1.5) * Fixed16(-2.25)).raw == Fixed16(-3.375).raw);
+    CHECK((Fixed32(1.5) * Fixed32(-2.25)).raw == -14495514624);
+    CHECK((Fixed16(1) / Fixed16(3)).raw == 21845);
+    CHECK((Fixed32(-1) / Fixed32(3)).raw == -1431655765);
+    CHECK((Fixed16(5) / 0) == std::numeric_limits<Fixed16>::max());
+    CHECK((Fixed16(-5) / 0) == std::numeric_limits<Fixed16>::lowest());
+    // Rounding of products: 1 ulp * 0.5 is a half, rounds up
+    CHECK((Fixed16::FromRaw(1) * Fixed16(0.5)).raw == 1);
+    CHECK((Fixed16::FromRaw(-1) * Fixed16(0.5)).raw == 0);
+    Fixed16 a = 2;
+    a += 1;
+    a *= a;
+    a -= Fixed16(0.5);
+    a /= 2;
+    CHECK(a == Fixed16(4.25));
+    CHECK(Fixed16(1) < Fixed16(1.5));
+    CHECK(-Fixed16(2) == Fixed16(-2));
+}
+
+TEST_CASE("[Fixed] math functions") {
+    CHECK(sqrt(Fixed16(2)).raw == 92682);
+    CHECK(sqrt(Fixed32(2)).raw == 6074001000);
+    CHECK(sqrt(Fixed16(-1)) == 0);
+    CHECK(sin(Fixed16(1)).raw == 55147);
+    CHECK(sin(Fixed32(1)).raw == 3614090361);
+    CHECK(cos(Fixed16(1)).raw == 35409);
+    CHECK(cos(Fixed32(1)).raw == 2320580734);
+    CHECK(acos(Fixed16(0.5)).raw == 68628);
+    CHECK(acos(Fixed32(0.5)).raw == 4497679236);
+    CHECK(sin(Fixed16(0)) == 0);
+    CHECK(cos(Fixed16(0)) == 1);
+    CHECK(acos(Fixed16(1)) == 0);
+    CHECK(hypot(Fixed16(3), Fixed16(4)) == 5);
+    // Squares are summed in double width
+    CHECK(hypot(Fixed16(20000), Fixed16(20000)).raw == 1853638000);
+
+    for (double x = -20; x < 20; x += 0.01) {
+        REQUIRE(std::abs(double(sin(Fixed16(x))) - std::sin(double(Fixed16(x)))) < 4e-5);
+        REQUIRE(std::abs(double(cos(Fixed16(x))) - std::cos(double(Fixed16(x)))) < 4e-5);
+        REQUIRE(std::abs(double(sin(Fixed32(x))) - std::sin(double(Fixed32(x)))) < 1e-9);
+    }
+    for (double x = -1; x <= 1; x += 0.001) {
+        REQUIRE(std::abs(double(acos(Fixed16(x))) - std::acos(double(Fixed16(x)))) < 1e-4);
+        REQUIRE(std::abs(double(acos(Fixed32(x))) - std::acos(double(Fixed32(x)))) < 2e-9);
+    }
+}
+
+TEST_CASE("[Fixed] Matrix") {
+    const Matrix<3, 3, Fixed16> m ({2, 1, 0, 1, 3, 1, 0, 1, 4});
+    const auto inv = m.Inverse();
+    const std::array<int32_t, 9> expected {40049, -14563, 3641, -14563, 29127, -7281, 3641, -7282, 18204};
+    for (size_t i = 0; i < 9; i++) {
+        CHECK(inv[i].raw == expected[i]);
+    }
+    const auto id = m * inv;
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            CHECK(std::abs(double(id(i, j)) - (i == j)) < 1e-4);
+        }
+    }
+    // Q16.16 products accumulate exactly in Q32.32, then round once
+    const Matrix<1, 2, Fixed16> a ({Fixed16::FromRaw(1), Fixed16::FromRaw(1)});
+    const Matrix<2, 1, Fixed16> b ({Fixed16(0.5), Fixed16(0.5)});
+    CHECK((a * b)[0].raw == 1);
+}
+
+TEST_CASE("[Fixed] Vector and Quaternion") {
+    const Vector3T<Fixed16> v (3, 4, 12);
+    CHECK(v.Magnitude() == 13);
+    CHECK(Vector3T<Fixed16>::AngleBetween({1, 0, 0}, {1, 1, 0}).raw == 51472);
+
+    const VectorS<4, Fixed16> vs ({1, 2, 3, 4});
+    CHECK(VectorS<4, Fixed16>::Dot(vs, vs) == 30);
+
+    const auto q = QuaternionT<Fixed32>::Rotation(Fixed32::HalfPi(), {0, 0, 1});
+    const Vector3T<Fixed32> r = q.Rotate({1, 0, 0});
+    CHECK(r.x.raw == 0);
+    CHECK(r.y.raw == int64_t(1) << 32);
+    CHECK(r.z.raw == 0);
+}
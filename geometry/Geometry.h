@@ -0,0 +1,678 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <algorithm>
+#include "Vector.h"
+#include "Parallel.h"
+
+template <typename T>
+struct PlaneT {
+    using real_t = typename Vector3T<T>::real_t;
+    Vector3T<T> normal;
+    T d;
+
+    PlaneT() = default;
+    constexpr PlaneT(const Vector3T<T>& normal, T d) : normal(normal), d(d) { }
+    ///Plane a*x + b*y + c*z + d = 0
+    constexpr PlaneT(T a, T b, T c, T d) : normal(a, b, c), d(d) { }
+
+    [[nodiscard]] static constexpr PlaneT<T> FromPointNormal(const Vector3T<T>& point, const Vector3T<T>& normal) {
+        return PlaneT<T> (normal, -Vector3T<T>::Dot(normal, point));
+    }
+
+    ///Signed distance, only in world units if the plane is normalized
+    [[nodiscard]] constexpr T Distance(const Vector3T<T>& point) const {
+        return Vector3T<T>::Dot(normal, point) + d;
+    }
+
+    ///Remember to check if normal is zero
+    [[nodiscard]] constexpr PlaneT<T> Normalized() const {
+        const real_t len = normal.Magnitude();
+        return PlaneT<T> (normal / len, d / len);
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const PlaneT<T>& p) {
+        return o << p.normal << ' ' << p.d;
+    }
+};
+
+
+template <typename T>
+struct AABBT {
+    Vector3T<T> min;
+    Vector3T<T> max;
+
+    AABBT() = default;
+    constexpr AABBT(const Vector3T<T>& min, const Vector3T<T>& max) : min(min), max(max) { }
+
+    [[nodiscard]] static constexpr AABBT<T> FromCenterExtent(const Vector3T<T>& center, const Vector3T<T>& extent) {
+        return AABBT<T> (center - extent, center + extent);
+    }
+
+    ///Inverted box, merging anything into it yields that thing
+    [[nodiscard]] static constexpr AABBT<T> Empty() {
+        const T inf = std::numeric_limits<T>::has_infinity
+            ? std::numeric_limits<T>::infinity()
+            : std::numeric_limits<T>::max();
+        return AABBT<T> (Vector3T<T>(inf), Vector3T<T>(-inf));
+    }
+
+    [[nodiscard]] constexpr Vector3T<T> Center() const { return (min + max) / 2; }
+    ///Half-size along each axis
+    [[nodiscard]] constexpr Vector3T<T> Extent() const { return (max - min) / 2; }
+    [[nodiscard]] constexpr Vector3T<T> Size() const { return max - min; }
+
+    [[nodiscard]] constexpr bool Contains(const Vector3T<T>& p) const {
+        return p.x >= min.x && p.x <= max.x
+            && p.y >= min.y && p.y <= max.y
+            && p.z >= min.z && p.z <= max.z;
+    }
+
+    [[nodiscard]] constexpr bool Overlaps(const AABBT<T>& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x
+            && min.y <= other.max.y && max.y >= other.min.y
+            && min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    constexpr void Merge(const Vector3T<T>& p) {
+        min = Vector3T<T> (std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = Vector3T<T> (std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+
+    ///Empty() on either side leaves the other box as it is
+    constexpr void Merge(const AABBT<T>& other) {
+        min = Vector3T<T> (std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z));
+        max = Vector3T<T> (std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z));
+    }
+
+    [[nodiscard]] static constexpr AABBT<T> Merged(AABBT<T> a, const AABBT<T>& b) {
+        a.Merge(b);
+        return a;
+    }
+
+    ///Bounds of the transformed box, `m` must be affine.
+    ///Arvo's method in center/extent form: 1 point transform + |m| * extent instead of 8 corners
+    [[nodiscard]] constexpr AABBT<T> Transformed(const Matrix<4, 4, T>& m) const {
+        const Vector3T<T> c = Center();
+        const Vector3T<T> e = Extent();
+        Vector3T<T> nc, ne;
+        for (size_t i = 0; i < 3; i++) {
+            nc[i] = m(i, 0) * c.x + m(i, 1) * c.y + m(i, 2) * c.z + m(i, 3);
+            ne[i] = std::abs(m(i, 0)) * e.x + std::abs(m(i, 1)) * e.y + std::abs(m(i, 2)) * e.z;
+        }
+        return FromCenterExtent(nc, ne);
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const AABBT<T>& b) {
+        return o << b.min << ' ' << b.max;
+    }
+};
+
+
+template <typename T>
+struct SphereT {
+    Vector3T<T> center;
+    T radius;
+
+    ///Encloses the box, usually looser than the box itself
+    [[nodiscard]] static constexpr SphereT<T> FromAABB(const AABBT<T>& box) {
+        return SphereT<T> {box.Center(), T(box.Extent().Magnitude())};
+    }
+
+    ///Bounds of the transformed sphere, `m` must be affine.
+    ///The radius grows with the largest axis scale, so non-uniform scales give a loose fit
+    [[nodiscard]] constexpr SphereT<T> Transformed(const Matrix<4, 4, T>& m) const {
+        using std::sqrt;
+        Vector3T<T> c;
+        T scaleSqr = 0;
+        for (size_t i = 0; i < 3; i++) {
+            c[i] = m(i, 0) * center.x + m(i, 1) * center.y + m(i, 2) * center.z + m(i, 3);
+            const T column = m(0, i) * m(0, i) + m(1, i) * m(1, i) + m(2, i) * m(2, i);
+            scaleSqr = std::max(scaleSqr, column);
+        }
+        return SphereT<T> {c, radius * sqrt(scaleSqr)};
+    }
+
+    [[nodiscard]] constexpr bool Contains(const Vector3T<T>& p) const {
+        const Vector3T<T> d = p - center;
+        return Vector3T<T>::Dot(d, d) <= radius * radius;
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const SphereT<T>& s) {
+        return o << s.center << ' ' << s.radius;
+    }
+};
+
+
+///Structure-of-arrays view over boxes in center/extent form, used by batch kernels
+template <typename T>
+struct AABBSoAT {
+    const T* cx; const T* cy; const T* cz;
+    const T* ex; const T* ey; const T* ez;
+    size_t count;
+};
+
+///Output of batch kernels, boxes in center/extent form like AABBSoAT
+template <typename T>
+struct AABBStreamT {
+    T* cx; T* cy; T* cz;
+    T* ex; T* ey; T* ez;
+};
+
+
+///Structure-of-arrays view over triangles as first vertex and two edges
+///(e1 = v1 - v0, e2 = v2 - v0), precomputed once for all rays
+template <typename T>
+struct TriangleSoAT {
+    const T* v0x; const T* v0y; const T* v0z;
+    const T* e1x; const T* e1y; const T* e1z;
+    const T* e2x; const T* e2y; const T* e2z;
+    size_t count;
+};
+
+
+///Hit distance along the ray in units of its direction's length,
+///and barycentric coordinates of v1 (u) and v2 (v) for triangles.
+///The hit point is v0 + u * e1 + v * e2
+template <typename T>
+struct RayHitT {
+    T t;
+    T u;
+    T v;
+};
+
+
+template <typename T>
+struct RayT {
+    Vector3T<T> origin;
+    ///Usually normalized, then parameters along the ray are distances
+    Vector3T<T> direction;
+
+    [[nodiscard]] constexpr Vector3T<T> At(T t) const {
+        return origin + direction * t;
+    }
+
+    ///Hits in front of the origin only, `t` is written on hit
+    [[nodiscard]] constexpr bool Intersect(const PlaneT<T>& plane, T& t) const {
+        const T denom = Vector3T<T>::Dot(plane.normal, direction);
+        if (denom == 0) { return false; }
+        const T tt = -plane.Distance(origin) / denom;
+        if (tt < 0) { return false; }
+        t = tt;
+        return true;
+    }
+
+    ///Nearest hit in front of the origin, the exit point if the origin is inside
+    [[nodiscard]] constexpr bool IntersectSphere(const Vector3T<T>& center, T radius, T& t) const {
+        using std::sqrt;
+        const Vector3T<T> oc = origin - center;
+        const T a = Vector3T<T>::Dot(direction, direction);
+        const T b = Vector3T<T>::Dot(oc, direction);
+        const T c = Vector3T<T>::Dot(oc, oc) - radius * radius;
+        const T disc = b * b - a * c;
+        if (disc < 0 || a == 0) { return false; }
+        const T root = sqrt(disc);
+        T tt = (-b - root) / a;
+        if (tt < 0) { tt = (-b + root) / a; }
+        if (tt < 0) { return false; }
+        t = tt;
+        return true;
+    }
+
+    ///Slab test, t is the entry distance (0 if the origin is inside)
+    [[nodiscard]] constexpr bool Intersect(const AABBT<T>& box, T& t) const {
+        T tmin = 0;
+        T tmax = std::numeric_limits<T>::max();
+        for (int i = 0; i < 3; i++) {
+            const T inv = 1 / direction[i];
+            T t0 = (box.min[i] - origin[i]) * inv;
+            T t1 = (box.max[i] - origin[i]) * inv;
+            if (t0 > t1) { std::swap(t0, t1); }
+            tmin = t0 > tmin ? t0 : tmin;
+            tmax = t1 < tmax ? t1 : tmax;
+        }
+        if (tmin > tmax) { return false; }
+        t = tmin;
+        return true;
+    }
+
+    ///Möller–Trumbore, two-sided. Hits in front of the origin only
+    [[nodiscard]] constexpr bool IntersectTriangle(const Vector3T<T>& v0, const Vector3T<T>& v1, const Vector3T<T>& v2, RayHitT<T>& hit) const {
+        const Vector3T<T> e1 = v1 - v0;
+        const Vector3T<T> e2 = v2 - v0;
+        const Vector3T<T> p = Vector3T<T>::Cross(direction, e2);
+        const T det = Vector3T<T>::Dot(e1, p);
+        if (det == 0) { return false; }
+        const T inv = 1 / det;
+        const Vector3T<T> s = origin - v0;
+        const T u = Vector3T<T>::Dot(s, p) * inv;
+        if (u < 0 || u > 1) { return false; }
+        const Vector3T<T> q = Vector3T<T>::Cross(s, e1);
+        const T v = Vector3T<T>::Dot(direction, q) * inv;
+        if (v < 0 || u + v > 1) { return false; }
+        const T t = Vector3T<T>::Dot(e2, q) * inv;
+        if (t < 0) { return false; }
+        hit = RayHitT<T> {t, u, v};
+        return true;
+    }
+
+    ///Closest of `tris.count` (< 2^32 - 1) triangles closer than `tMax`, 8 per iteration.
+    ///Returns its index and writes `hit`, or returns tris.count on a miss
+    [[nodiscard]] constexpr size_t IntersectClosest(const TriangleSoAT<T>& tris, RayHitT<T>& hit,
+                                                    T tMax = std::numeric_limits<T>::max()) const {
+        constexpr size_t lanes = 8;
+        ClosestLanes<lanes> best {};
+        best.t.fill(tMax);
+        best.i.fill(uint32_t(-1));
+        const size_t full = tris.count / lanes * lanes;
+        for (size_t base = 0; base < full; base += lanes) {
+            TriangleLanes<lanes>(tris, base, best);
+        }
+        for (size_t j = full; j < tris.count; j++) {
+            TriangleLanes<1>(tris, j, best);
+        }
+        size_t k = 0;
+        for (size_t l = 1; l < lanes; l++) {
+            if (best.t[l] < best.t[k] || (best.t[l] == best.t[k] && best.i[l] < best.i[k])) { k = l; }
+        }
+        if (best.i[k] == uint32_t(-1)) { return tris.count; }
+        hit = RayHitT<T> {best.t[k], best.u[k], best.v[k]};
+        return best.i[k];
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const RayT<T>& r) {
+        return o << r.origin << ' ' << r.direction;
+    }
+
+private:
+    // Closest hit per lane, 32 bit indices keep all lanes the same width
+    template <size_t lanes>
+    struct ClosestLanes {
+        std::array<T, lanes> t, u, v;
+        std::array<uint32_t, lanes> i;
+    };
+
+    // Branchless Möller–Trumbore on precomputed edges, triangle base + k
+    // goes to lane k, which keeps the closer hit
+    template <size_t lanes, size_t stateLanes>
+    constexpr void TriangleLanes(const TriangleSoAT<T>& tr, size_t base, ClosestLanes<stateLanes>& state) const {
+        // Work on copies, so that the compiler knows stores can't alias the triangles
+        const Vector3T<T> o = origin;
+        const Vector3T<T> d = direction;
+        ClosestLanes<stateLanes> best = state;
+        for (size_t k = 0; k < lanes; k++) {
+            const size_t j = base + k;
+            const T px = d.y * tr.e2z[j] - d.z * tr.e2y[j];
+            const T py = d.z * tr.e2x[j] - d.x * tr.e2z[j];
+            const T pz = d.x * tr.e2y[j] - d.y * tr.e2x[j];
+            const T det = tr.e1x[j] * px + tr.e1y[j] * py + tr.e1z[j] * pz;
+            const T inv = 1 / det;
+            const T sx = o.x - tr.v0x[j];
+            const T sy = o.y - tr.v0y[j];
+            const T sz = o.z - tr.v0z[j];
+            const T u = (sx * px + sy * py + sz * pz) * inv;
+            const T qx = sy * tr.e1z[j] - sz * tr.e1y[j];
+            const T qy = sz * tr.e1x[j] - sx * tr.e1z[j];
+            const T qz = sx * tr.e1y[j] - sy * tr.e1x[j];
+            const T v = (d.x * qx + d.y * qy + d.z * qz) * inv;
+            const T t = (tr.e2x[j] * qx + tr.e2y[j] * qy + tr.e2z[j] * qz) * inv;
+            // NaN from det == 0 fails every comparison
+            const bool ok = (u >= 0) & (v >= 0) & (u + v <= 1) & (t >= 0) & (t < best.t[k]);
+            best.t[k] = ok ? t : best.t[k];
+            best.u[k] = ok ? u : best.u[k];
+            best.v[k] = ok ? v : best.v[k];
+            best.i[k] = ok ? uint32_t(j) : best.i[k];
+        }
+        state = best;
+    }
+};
+
+
+///Closest hits of a ray packet, one lane per ray
+template <typename T, size_t lanes = 8>
+struct PacketHitT {
+    std::array<T, lanes> t;
+    std::array<T, lanes> u;
+    std::array<T, lanes> v;
+
+    ///No hits closer than tMax yet
+    [[nodiscard]] static constexpr PacketHitT<T, lanes> Miss(T tMax = std::numeric_limits<T>::max()) {
+        PacketHitT<T, lanes> ret {};
+        ret.t.fill(tMax);
+        return ret;
+    }
+};
+
+
+///`lanes` rays in structure-of-arrays form, tested against one primitive
+///at a time with branchless loops that vectorize. Functions return a mask,
+///bit k is set if ray k hit closer than its current entry in `hits`/`t`,
+///and update those entries.
+template <typename T, size_t lanes = 8>
+struct RayPacketT {
+    static_assert(lanes <= 32, "Masks are 32 bit");
+    std::array<T, lanes> ox, oy, oz;
+    std::array<T, lanes> dx, dy, dz;
+    ///Reciprocal directions for slab tests
+    std::array<T, lanes> ix, iy, iz;
+
+    ///Takes up to `lanes` rays, missing lanes repeat rays[0]
+    [[nodiscard]] static constexpr RayPacketT<T, lanes> FromRays(const RayT<T>* rays, size_t count) {
+        RayPacketT<T, lanes> p {};
+        for (size_t k = 0; k < lanes; k++) {
+            const RayT<T>& r = rays[k < count ? k : 0];
+            p.ox[k] = r.origin.x;    p.oy[k] = r.origin.y;    p.oz[k] = r.origin.z;
+            p.dx[k] = r.direction.x; p.dy[k] = r.direction.y; p.dz[k] = r.direction.z;
+            p.ix[k] = 1 / r.direction.x;
+            p.iy[k] = 1 / r.direction.y;
+            p.iz[k] = 1 / r.direction.z;
+        }
+        return p;
+    }
+
+    constexpr uint32_t IntersectTriangle(const Vector3T<T>& v0, const Vector3T<T>& v1, const Vector3T<T>& v2, PacketHitT<T, lanes>& hits) const {
+        const Vector3T<T> e1 = v1 - v0;
+        const Vector3T<T> e2 = v2 - v0;
+        // Work on copies, so that the compiler knows stores can't alias the rays
+        PacketHitT<T, lanes> best = hits;
+        std::array<uint32_t, lanes> ok;
+        for (size_t k = 0; k < lanes; k++) {
+            const T px = dy[k] * e2.z - dz[k] * e2.y;
+            const T py = dz[k] * e2.x - dx[k] * e2.z;
+            const T pz = dx[k] * e2.y - dy[k] * e2.x;
+            const T inv = 1 / (e1.x * px + e1.y * py + e1.z * pz);
+            const T sx = ox[k] - v0.x;
+            const T sy = oy[k] - v0.y;
+            const T sz = oz[k] - v0.z;
+            const T u = (sx * px + sy * py + sz * pz) * inv;
+            const T qx = sy * e1.z - sz * e1.y;
+            const T qy = sz * e1.x - sx * e1.z;
+            const T qz = sx * e1.y - sy * e1.x;
+            const T v = (dx[k] * qx + dy[k] * qy + dz[k] * qz) * inv;
+            const T t = (e2.x * qx + e2.y * qy + e2.z * qz) * inv;
+            ok[k] = (u >= 0) & (v >= 0) & (u + v <= 1) & (t >= 0) & (t < best.t[k]);
+            best.t[k] = ok[k] ? t : best.t[k];
+            best.u[k] = ok[k] ? u : best.u[k];
+            best.v[k] = ok[k] ? v : best.v[k];
+        }
+        hits = best;
+        return Mask(ok);
+    }
+
+    ///Entry distance, 0 for rays starting inside
+    constexpr uint32_t Intersect(const AABBT<T>& box, std::array<T, lanes>& t) const {
+        std::array<T, lanes> best = t;
+        std::array<uint32_t, lanes> ok;
+        for (size_t k = 0; k < lanes; k++) {
+            const T x0 = (box.min.x - ox[k]) * ix[k], x1 = (box.max.x - ox[k]) * ix[k];
+            const T y0 = (box.min.y - oy[k]) * iy[k], y1 = (box.max.y - oy[k]) * iy[k];
+            const T z0 = (box.min.z - oz[k]) * iz[k], z1 = (box.max.z - oz[k]) * iz[k];
+            // Nested pairs, the initializer list overloads are loops that stop vectorization
+            const T tmin = std::max(std::max(std::max(T(0), std::min(x0, x1)), std::min(y0, y1)), std::min(z0, z1));
+            const T tmax = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::max(z0, z1));
+            ok[k] = (tmin <= tmax) & (tmin < best[k]);
+            best[k] = ok[k] ? tmin : best[k];
+        }
+        t = best;
+        return Mask(ok);
+    }
+
+    constexpr uint32_t IntersectSphere(const Vector3T<T>& center, T radius, std::array<T, lanes>& t) const {
+        using std::sqrt;
+        const T r2 = radius * radius;
+        std::array<T, lanes> best = t;
+        std::array<T, lanes> a, b, disc, root;
+        for (size_t k = 0; k < lanes; k++) {
+            const T cx = ox[k] - center.x, cy = oy[k] - center.y, cz = oz[k] - center.z;
+            a[k] = dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k];
+            b[k] = cx * dx[k] + cy * dy[k] + cz * dz[k];
+            const T c = cx * cx + cy * cy + cz * cz - r2;
+            disc[k] = b[k] * b[k] - a[k] * c;
+            root[k] = disc[k] > 0 ? disc[k] : T(0);
+        }
+        // Alone in its loop: sqrt may set errno, and the branch for
+        // that keeps any loop containing it from vectorizing
+        for (size_t k = 0; k < lanes; k++) {
+            root[k] = sqrt(root[k]);
+        }
+        std::array<uint32_t, lanes> ok;
+        for (size_t k = 0; k < lanes; k++) {
+            // Near root unless it's behind the origin. Selecting the sign only,
+            // so that no arithmetic is left on one side of the branch
+            const T nearRoot = -b[k] - root[k];
+            const T tt = (-b[k] + (nearRoot >= 0 ? -root[k] : root[k])) / a[k];
+            ok[k] = (disc[k] >= 0) & (tt >= 0) & (tt < best[k]);
+            best[k] = ok[k] ? tt : best[k];
+        }
+        t = best;
+        return Mask(ok);
+    }
+
+    constexpr uint32_t Intersect(const PlaneT<T>& plane, std::array<T, lanes>& t) const {
+        const Vector3T<T> n = plane.normal;
+        const T d = plane.d;
+        std::array<T, lanes> best = t;
+        std::array<uint32_t, lanes> ok;
+        for (size_t k = 0; k < lanes; k++) {
+            const T dist = n.x * ox[k] + n.y * oy[k] + n.z * oz[k] + d;
+            const T denom = n.x * dx[k] + n.y * dy[k] + n.z * dz[k];
+            const T tt = -dist / denom;
+            ok[k] = (tt >= 0) & (tt < best[k]);
+            best[k] = ok[k] ? tt : best[k];
+        }
+        t = best;
+        return Mask(ok);
+    }
+
+private:
+    // Separate from the lane loops, shifting into one mask there keeps them scalar
+    static constexpr uint32_t Mask(const std::array<uint32_t, lanes>& ok) {
+        uint32_t mask = 0;
+        for (size_t k = 0; k < lanes; k++) {
+            mask |= ok[k] << k;
+        }
+        return mask;
+    }
+};
+
+
+template <typename T>
+struct FrustumT {
+    enum Side { Left, Right, Bottom, Top, Near, Far };
+    ///Normals point inwards
+    std::array<PlaneT<T>, 6> planes;
+
+    ///Gribb-Hartmann extraction, OpenGL clip space (-w <= z <= w)
+    [[nodiscard]] static constexpr FrustumT<T> FromMatrix(const Matrix<4, 4, T>& viewProj) {
+        const auto& m = viewProj;
+        const auto plane = [&m](int row, T sign) {
+            return PlaneT<T> (
+                m(3, 0) + sign * m(row, 0),
+                m(3, 1) + sign * m(row, 1),
+                m(3, 2) + sign * m(row, 2),
+                m(3, 3) + sign * m(row, 3)
+            ).Normalized();
+        };
+        FrustumT<T> ret;
+        ret.planes[Left]   = plane(0,  1);
+        ret.planes[Right]  = plane(0, -1);
+        ret.planes[Bottom] = plane(1,  1);
+        ret.planes[Top]    = plane(1, -1);
+        ret.planes[Near]   = plane(2,  1);
+        ret.planes[Far]    = plane(2, -1);
+        return ret;
+    }
+
+    [[nodiscard]] constexpr bool Contains(const Vector3T<T>& p) const {
+        for (const auto& pl : planes) {
+            if (pl.Distance(p) < 0) { return false; }
+        }
+        return true;
+    }
+
+    [[nodiscard]] constexpr bool IntersectsSphere(const Vector3T<T>& center, T radius) const {
+        for (const auto& pl : planes) {
+            if (pl.Distance(center) < -radius) { return false; }
+        }
+        return true;
+    }
+
+    ///Conservative: may report boxes near frustum corners as visible
+    [[nodiscard]] constexpr bool Intersects(const AABBT<T>& box) const {
+        const Vector3T<T> c = box.Center();
+        const Vector3T<T> e = box.Extent();
+        for (const auto& pl : planes) {
+            const T r = std::abs(pl.normal.x) * e.x + std::abs(pl.normal.y) * e.y + std::abs(pl.normal.z) * e.z;
+            if (pl.Distance(c) < -r) { return false; }
+        }
+        return true;
+    }
+
+    ///Tests `boxes.count` boxes, bit `i % 8` of `visible[i / 8]` is set if box `i` is visible.
+    ///`visible` must hold (count + 7) / 8 bytes.
+    ///Boxes are processed 8 at a time with a branchless inner loop so that it vectorizes.
+    constexpr void Cull(const AABBSoAT<T>& boxes, uint8_t* visible) const {
+        constexpr size_t lanes = 8;
+        const size_t full = boxes.count / lanes * lanes;
+        size_t i = 0;
+        for (; i < full; i += lanes) {
+            visible[i / lanes] = CullBlock<lanes>(boxes, i);
+        }
+        if (i < boxes.count) {
+            uint8_t bits = 0;
+            for (size_t k = 0; i + k < boxes.count; k++) {
+                bits |= uint8_t(CullOne(boxes, i + k)) << k;
+            }
+            visible[i / lanes] = bits;
+        }
+    }
+
+private:
+    template <size_t lanes>
+    [[nodiscard]] constexpr uint8_t CullBlock(const AABBSoAT<T>& b, size_t base) const {
+        std::array<bool, lanes> in {};
+        for (size_t k = 0; k < lanes; k++) { in[k] = true; }
+        for (const auto& pl : planes) {
+            const T anx = std::abs(pl.normal.x);
+            const T any = std::abs(pl.normal.y);
+            const T anz = std::abs(pl.normal.z);
+            for (size_t k = 0; k < lanes; k++) {
+                const size_t j = base + k;
+                const T dist = pl.normal.x * b.cx[j] + pl.normal.y * b.cy[j] + pl.normal.z * b.cz[j] + pl.d;
+                const T r = anx * b.ex[j] + any * b.ey[j] + anz * b.ez[j];
+                in[k] = in[k] & (dist >= -r);
+            }
+        }
+        uint8_t bits = 0;
+        for (size_t k = 0; k < lanes; k++) {
+            bits |= uint8_t(in[k]) << k;
+        }
+        return bits;
+    }
+
+    [[nodiscard]] constexpr bool CullOne(const AABBSoAT<T>& b, size_t j) const {
+        const Vector3T<T> c (b.cx[j], b.cy[j], b.cz[j]);
+        const Vector3T<T> e (b.ex[j], b.ey[j], b.ez[j]);
+        return Intersects(AABBT<T>::FromCenterExtent(c, e));
+    }
+};
+
+namespace geometry {
+    // Boxes per inner block of MergeRange()
+    constexpr size_t lanes = 8;
+    // Smallest amount of boxes worth a thread
+    constexpr size_t chunk = 4096;
+
+    ///AABBT::Transformed() for boxes [begin, end), box i by matrices[i]
+    template <typename T>
+    void TransformRange(const Matrix<4, 4, T>* matrices, const AABBSoAT<T>& in,
+                        const AABBStreamT<T>& out, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const Matrix<4, 4, T>& m = matrices[i];
+            const T cx = in.cx[i], cy = in.cy[i], cz = in.cz[i];
+            const T ex = in.ex[i], ey = in.ey[i], ez = in.ez[i];
+            out.cx[i] = m[0] * cx + m[1] * cy + m[2]  * cz + m[3];
+            out.cy[i] = m[4] * cx + m[5] * cy + m[6]  * cz + m[7];
+            out.cz[i] = m[8] * cx + m[9] * cy + m[10] * cz + m[11];
+            out.ex[i] = std::abs(m[0]) * ex + std::abs(m[1]) * ey + std::abs(m[2])  * ez;
+            out.ey[i] = std::abs(m[4]) * ex + std::abs(m[5]) * ey + std::abs(m[6])  * ez;
+            out.ez[i] = std::abs(m[8]) * ex + std::abs(m[9]) * ey + std::abs(m[10]) * ez;
+        }
+    }
+
+    ///Bounds of boxes [begin, end), one running min/max per lane
+    template <typename T>
+    [[nodiscard]] AABBT<T> MergeRange(const AABBSoAT<T>& b, size_t begin, size_t end) {
+        const AABBT<T> empty = AABBT<T>::Empty();
+        std::array<std::array<T, lanes>, 3> lo, hi;
+        for (size_t a = 0; a < 3; a++) {
+            lo[a].fill(empty.min[a]);
+            hi[a].fill(empty.max[a]);
+        }
+        const std::array<const T*, 3> c {b.cx, b.cy, b.cz};
+        const std::array<const T*, 3> e {b.ex, b.ey, b.ez};
+        size_t base = begin;
+        for (; base + lanes <= end; base += lanes) {
+            for (size_t a = 0; a < 3; a++) {
+                for (size_t k = 0; k < lanes; k++) {
+                    const T low = c[a][base + k] - e[a][base + k];
+                    const T high = c[a][base + k] + e[a][base + k];
+                    lo[a][k] = low < lo[a][k] ? low : lo[a][k];
+                    hi[a][k] = high > hi[a][k] ? high : hi[a][k];
+                }
+            }
+        }
+        AABBT<T> ret = empty;
+        for (size_t k = 0; k < lanes; k++) {
+            ret.Merge(AABBT<T> ({lo[0][k], lo[1][k], lo[2][k]}, {hi[0][k], hi[1][k], hi[2][k]}));
+        }
+        for (; base < end; base++) {
+            const Vector3T<T> center (b.cx[base], b.cy[base], b.cz[base]);
+            const Vector3T<T> extent (b.ex[base], b.ey[base], b.ez[base]);
+            ret.Merge(AABBT<T>::FromCenterExtent(center, extent));
+        }
+        return ret;
+    }
+}
+
+///World bounds of many boxes in center/extent form, box i transformed by
+///the affine matrices[i]. Same results as AABBT::Transformed().
+///Runs on up to `threads` threads (0 = all cores).
+template <typename T>
+void TransformAABBs(const Matrix<4, 4, T>* matrices, const AABBSoAT<T>& boxes,
+                    const AABBStreamT<T>& out, size_t threads = 0) {
+    ParallelFor(boxes.count, geometry::chunk, [&](size_t begin, size_t end) {
+        geometry::TransformRange(matrices, boxes, out, begin, end);
+    }, threads);
+}
+
+///Box enclosing all `boxes`, AABBT::Empty() if there are none.
+///Runs on up to `threads` threads (0 = all cores).
+template <typename T>
+[[nodiscard]] AABBT<T> MergeAABBs(const AABBSoAT<T>& boxes, size_t threads = 0) {
+    AABBT<T> ret = AABBT<T>::Empty();
+    std::mutex mutex;
+    ParallelFor(boxes.count, geometry::chunk, [&](size_t begin, size_t end) {
+        const AABBT<T> part = geometry::MergeRange(boxes, begin, end);
+        // Min and max are exact, the order chunks finish in doesn't matter
+        const std::lock_guard<std::mutex> lock (mutex);
+        ret.Merge(part);
+    }, threads);
+    return ret;
+}
+
+typedef PlaneT<float> Plane;
+typedef AABBT<float> AABB;
+typedef SphereT<float> Sphere;
+typedef AABBSoAT<float> AABBSoA;
+typedef AABBStreamT<float> AABBStream;
+typedef RayT<float> Ray;
+typedef RayHitT<float> RayHit;
+typedef TriangleSoAT<float> TriangleSoA;
+typedef RayPacketT<float> RayPacket;
+typedef PacketHitT<float> PacketHit;
+typedef FrustumT<float> Frustum;
@@ -0,0 +1,466 @@
+#include "Geometry.h"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    bool Near(float a, float b, float eps = 1e-5f) {
+        return std::abs(a - b) <= eps;
+    }
+
+    bool Near(const Vector3& a, const Vector3& b, float eps = 1e-5f) {
+        return Near(a.x, b.x, eps) && Near(a.y, b.y, eps) && Near(a.z, b.z, eps);
+    }
+
+    Vector3 Corner(const AABB& b, int k) {
+        return Vector3((k & 1) ? b.max.x : b.min.x, (k & 2) ? b.max.y : b.min.y, (k & 4) ? b.max.z : b.min.z);
+    }
+
+    Vector3 TransformPoint(const Matrix<4, 4>& m, const Vector3& p) {
+        const VectorS<4> r = m * p.Homogeneous(1);
+        return Vector3(r[0], r[1], r[2]);
+    }
+
+    // Triangle soup stored both as vertices and as TriangleSoA
+    struct Soup {
+        std::vector<Vector3> a, b, c;
+        std::vector<float> v0x, v0y, v0z, e1x, e1y, e1z, e2x, e2y, e2z;
+
+        Soup() = default;
+
+        Soup(size_t count, std::mt19937& rng) {
+            std::uniform_real_distribution<float> u (-1, 1);
+            for (size_t i = 0; i < count; i++) {
+                const Vector3 center (u(rng) * 5, u(rng) * 5, u(rng) * 5);
+                Add(center + Vector3(u(rng), u(rng), u(rng)), center + Vector3(u(rng), u(rng), u(rng)),
+                    center + Vector3(u(rng), u(rng), u(rng)));
+            }
+        }
+
+        void Add(const Vector3& v0, const Vector3& v1, const Vector3& v2) {
+            a.push_back(v0);
+            b.push_back(v1);
+            c.push_back(v2);
+            v0x.push_back(v0.x); v0y.push_back(v0.y); v0z.push_back(v0.z);
+            e1x.push_back(v1.x - v0.x); e1y.push_back(v1.y - v0.y); e1z.push_back(v1.z - v0.z);
+            e2x.push_back(v2.x - v0.x); e2y.push_back(v2.y - v0.y); e2z.push_back(v2.z - v0.z);
+        }
+
+        TriangleSoA View(size_t count) const {
+            return {v0x.data(), v0y.data(), v0z.data(), e1x.data(), e1y.data(), e1z.data(),
+                    e2x.data(), e2y.data(), e2z.data(), count};
+        }
+
+        // Closest hit of the single-ray test, first index on ties
+        size_t Closest(const Ray& ray, size_t count, RayHit& best, float tMax = std::numeric_limits<float>::max()) const {
+            size_t index = count;
+            best.t = tMax;
+            for (size_t i = 0; i < count; i++) {
+                RayHit h {};
+                if (ray.IntersectTriangle(a[i], b[i], c[i], h) && h.t < best.t) {
+                    best = h;
+                    index = i;
+                }
+            }
+            return index;
+        }
+    };
+
+    // Rays aimed at triangles of the soup, every fourth in a random direction
+    std::vector<Ray> AimedRays(const Soup& soup, size_t count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> u (-1, 1);
+        std::vector<Ray> rays;
+        for (size_t r = 0; r < count; r++) {
+            const Vector3 o (u(rng) * 8, u(rng) * 8, u(rng) * 8);
+            const size_t i = r % soup.a.size();
+            const Vector3 aim = r % 4 == 0 ? Vector3(u(rng), u(rng), u(rng)) : (soup.a[i] + soup.b[i] + soup.c[i]) / 3.0f - o;
+            rays.push_back(Ray {o, aim.Normalized()});
+        }
+        return rays;
+    }
+
+    // Boxes in center/extent form, as AABBSoA and as an output stream
+    struct Boxes {
+        std::vector<float> c[3], e[3];
+
+        Boxes(size_t count, std::mt19937& rng) {
+            std::uniform_real_distribution<float> u (-50, 50), ue (0, 3);
+            for (size_t i = 0; i < count; i++) {
+                for (int k = 0; k < 3; k++) {
+                    c[k].push_back(u(rng));
+                    e[k].push_back(ue(rng));
+                }
+            }
+        }
+
+        AABBSoA View() const {
+            return {c[0].data(), c[1].data(), c[2].data(), e[0].data(), e[1].data(), e[2].data(), c[0].size()};
+        }
+        AABBStream Stream() {
+            return {c[0].data(), c[1].data(), c[2].data(), e[0].data(), e[1].data(), e[2].data()};
+        }
+        AABB Box(size_t i) const {
+            return AABB::FromCenterExtent(Vector3(c[0][i], c[1][i], c[2][i]), Vector3(e[0][i], e[1][i], e[2][i]));
+        }
+    };
+
+    // Rotation, non-uniform scale and translation
+    Matrix<4, 4> RandomAffine(std::mt19937& rng) {
+        std::uniform_real_distribution<float> u (-1, 1);
+        const Vector3 axis = Vector3(u(rng), u(rng), u(rng) + 2).Normalized();
+        const float angle = u(rng) * 3;
+        Matrix<4, 4> m = Matrix<4, 4>::Identity();
+        for (size_t j = 0; j < 3; j++) {
+            Vector3 unit (0);
+            unit[int(j)] = 1;
+            // Column j is the scaled, rotated axis j
+            const Vector3 column = Vector3::Rotate(unit, axis, angle) * (1.5f + u(rng));
+            for (size_t i = 0; i < 3; i++) {
+                m(i, j) = column[int(i)];
+            }
+            m(j, 3) = u(rng) * 20;
+        }
+        return m;
+    }
+
+    // Perspective with 90° vertical fov, aspect 1, near 1, far 10
+    const Matrix<4, 4> perspective ({
+        1, 0, 0,          0,
+        0, 1, 0,          0,
+        0, 0, -11.0f / 9, -20.0f / 9,
+        0, 0, -1,         0,
+    });
+}
+
+TEST_CASE("[Geometry] plane") {
+    const Plane p = Plane::FromPointNormal(Vector3(0, 2, 0), Vector3(0, 1, 0));
+    CHECK(Near(p.Distance(Vector3(5, 7, -3)), 5));
+    const Plane q = Plane(0, 3, 4, 10).Normalized();
+    CHECK(Near(q.normal, Vector3(0, 0.6f, 0.8f)));
+    CHECK(Near(q.d, 2));
+}
+
+TEST_CASE("[Geometry] frustum planes from a perspective matrix") {
+    const Frustum f = Frustum::FromMatrix(perspective);
+    const float s = std::sqrt(0.5f);
+    CHECK(Near(f.planes[Frustum::Left].normal, Vector3(s, 0, -s)));
+    CHECK(Near(f.planes[Frustum::Right].normal, Vector3(-s, 0, -s)));
+    CHECK(Near(f.planes[Frustum::Bottom].normal, Vector3(0, s, -s)));
+    CHECK(Near(f.planes[Frustum::Top].normal, Vector3(0, -s, -s)));
+    CHECK(Near(f.planes[Frustum::Near].normal, Vector3(0, 0, -1)));
+    CHECK(Near(f.planes[Frustum::Near].d, -1));
+    CHECK(Near(f.planes[Frustum::Far].normal, Vector3(0, 0, 1)));
+    CHECK(Near(f.planes[Frustum::Far].d, 10));
+    for (const Plane& p : f.planes) {
+        CHECK(Near(p.normal.Magnitude(), 1));
+    }
+
+    CHECK(f.Contains(Vector3(0, 0, -5)));
+    CHECK(f.Contains(Vector3(4.9f, -4.9f, -5)));
+    CHECK_FALSE(f.Contains(Vector3(5.1f, 0, -5)));
+    CHECK_FALSE(f.Contains(Vector3(0, 0, -0.9f)));
+    CHECK_FALSE(f.Contains(Vector3(0, 0, -10.1f)));
+    CHECK(f.IntersectsSphere(Vector3(0, 0, -10.5f), 1));
+    CHECK_FALSE(f.IntersectsSphere(Vector3(0, 0, 1), 1.5f));
+}
+
+TEST_CASE("[Geometry] AABB") {
+    AABB b = AABB::Empty();
+    b.Merge(Vector3(1, -2, 3));
+    b.Merge(Vector3(-1, 4, 0));
+    CHECK(Near(b.min, Vector3(-1, -2, 0)));
+    CHECK(Near(b.max, Vector3(1, 4, 3)));
+    CHECK(Near(b.Center(), Vector3(0, 1, 1.5f)));
+    CHECK(Near(b.Extent(), Vector3(1, 3, 1.5f)));
+    CHECK(b.Contains(Vector3(0, 0, 0)));
+    CHECK_FALSE(b.Contains(Vector3(0, 5, 0)));
+    CHECK(b.Overlaps(AABB(Vector3(1), Vector3(2))));
+    CHECK_FALSE(b.Overlaps(AABB(Vector3(1.5f), Vector3(2))));
+    const AABB merged = AABB::Merged(AABB::Empty(), b);
+    CHECK(Near(merged.min, b.min));
+    CHECK(Near(merged.max, b.max));
+    // Merging an empty box changes nothing either
+    const AABB same = AABB::Merged(b, AABB::Empty());
+    CHECK(Near(same.min, b.min));
+    CHECK(Near(same.max, b.max));
+}
+
+TEST_CASE("[Geometry] AABB transform matches 8 corners") {
+    std::mt19937 rng {7};
+    std::uniform_real_distribution<float> u (-3, 3);
+    for (int i = 0; i < 200; i++) {
+        Matrix<4, 4> m = Matrix<4, 4>::Identity();
+        for (int e = 0; e < 12; e++) {
+            m[e] = u(rng);
+        }
+        const Vector3 a (u(rng), u(rng), u(rng));
+        const Vector3 b (u(rng), u(rng), u(rng));
+        const AABB box (Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)),
+                        Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)));
+        AABB corners = AABB::Empty();
+        for (int k = 0; k < 8; k++) {
+            corners.Merge(TransformPoint(m, Corner(box, k)));
+        }
+        const AABB t = box.Transformed(m);
+        CHECK(Near(t.min, corners.min, 1e-4f));
+        CHECK(Near(t.max, corners.max, 1e-4f));
+    }
+}
+
+TEST_CASE("[Geometry] batch cull matches per-box test") {
+    const Frustum f = Frustum::FromMatrix(perspective);
+    std::mt19937 rng {3};
+    std::uniform_real_distribution<float> u (-12, 12), ue (0, 2);
+    // 77 is not a multiple of the 8 lanes, the last byte is partial
+    const size_t n = 77;
+    std::vector<float> c[3], e[3];
+    for (size_t i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            c[k].push_back(u(rng));
+            e[k].push_back(ue(rng));
+        }
+    }
+    std::vector<uint8_t> visible ((n + 7) / 8, 0xAA);
+    f.Cull(AABBSoA {c[0].data(), c[1].data(), c[2].data(), e[0].data(), e[1].data(), e[2].data(), n}, visible.data());
+    size_t seen = 0;
+    for (size_t i = 0; i < n; i++) {
+        const AABB box = AABB::FromCenterExtent(Vector3(c[0][i], c[1][i], c[2][i]), Vector3(e[0][i], e[1][i], e[2][i]));
+        const bool bit = visible[i / 8] >> (i % 8) & 1;
+        CHECK(bit == f.Intersects(box));
+        seen += bit;
+    }
+    CHECK(seen > 0);
+    CHECK(seen < n);
+    // Bits past the last box are cleared
+    CHECK((visible.back() >> (n % 8)) == 0);
+}
+
+TEST_CASE("[Geometry] sphere bounds") {
+    std::mt19937 rng {8};
+    std::uniform_real_distribution<float> u (-1, 1);
+    const AABB box (Vector3(-1, 2, 0), Vector3(3, 4, 1));
+    const Sphere fromBox = Sphere::FromAABB(box);
+    CHECK(Near(fromBox.center, box.Center()));
+    for (int k = 0; k < 8; k++) {
+        CHECK(Near((Corner(box, k) - fromBox.center).Magnitude(), fromBox.radius));
+    }
+
+    for (int i = 0; i < 100; i++) {
+        const Matrix<4, 4> m = RandomAffine(rng);
+        const Sphere sphere {Vector3(u(rng), u(rng), u(rng)) * 10.0f, 1 + u(rng)};
+        const Sphere t = sphere.Transformed(m);
+        CHECK(Near(t.center, TransformPoint(m, sphere.center), 1e-4f));
+        // Points on and inside the sphere stay inside
+        for (int p = 0; p < 20; p++) {
+            const Vector3 d = Vector3(u(rng), u(rng), u(rng) + 0.01f).Normalized() * (sphere.radius * (p % 2 ? 1.0f : 0.5f));
+            const Vector3 q = TransformPoint(m, sphere.center + d);
+            CHECK((q - t.center).Magnitude() <= t.radius * (1 + 1e-5f));
+        }
+        // Touches the longest scaled axis, so it is as tight as a sphere can be
+        float longest = 0;
+        for (size_t j = 0; j < 3; j++) {
+            longest = std::max(longest, Vector3(m(0, j), m(1, j), m(2, j)).Magnitude());
+        }
+        CHECK(Near(t.radius, sphere.radius * longest, 1e-5f * t.radius));
+    }
+    // Rotation with uniform scale keeps the radius times the scale
+    Matrix<4, 4> m = Matrix<4, 4>::Identity();
+    m(0, 1) = -2;
+    m(1, 0) = 2;
+    m(2, 2) = 2;
+    m(0, 0) = m(1, 1) = 0;
+    m(0, 3) = 5;
+    const Sphere t = Sphere {Vector3(1, 0, 0), 3}.Transformed(m);
+    CHECK(Near(t.center, Vector3(5, 2, 0)));
+    CHECK(Near(t.radius, 6));
+}
+
+TEST_CASE("[Geometry] TransformAABBs matches AABB::Transformed") {
+    std::mt19937 rng {9};
+    // Empty, below, at and above one chunk of boxes per thread
+    for (const size_t count : {size_t(0), size_t(1), size_t(4095), size_t(4096), size_t(4097), size_t(3 * 4096 + 5)}) {
+        const Boxes boxes (count, rng);
+        std::vector<Matrix<4, 4>> matrices;
+        for (size_t i = 0; i < count; i++) {
+            matrices.push_back(RandomAffine(rng));
+        }
+        for (const size_t threads : {size_t(1), size_t(3), size_t(0)}) {
+            Boxes out (count, rng);
+            TransformAABBs(matrices.data(), boxes.View(), out.Stream(), threads);
+            for (size_t i = 0; i < count; i++) {
+                const AABB expected = boxes.Box(i).Transformed(matrices[i]);
+                const AABB got = out.Box(i);
+                // Center and extent round differently than min and max
+                const float eps = 1e-5f * (1 + expected.max.Magnitude() + expected.min.Magnitude());
+                CHECK(Near(got.min, expected.min, eps));
+                CHECK(Near(got.max, expected.max, eps));
+            }
+        }
+    }
+}
+
+TEST_CASE("[Geometry] MergeAABBs matches a serial merge") {
+    std::mt19937 rng {10};
+    for (const size_t count : {size_t(0), size_t(1), size_t(7), size_t(8), size_t(4095), size_t(4096), size_t(4097), size_t(5 * 4096 + 3)}) {
+        Boxes boxes (count, rng);
+        // An outlier in the tail of the last chunk
+        if (count > 2) {
+            boxes.c[1][count - 2] = 1000;
+        }
+        AABB expected = AABB::Empty();
+        for (size_t i = 0; i < count; i++) {
+            expected.Merge(boxes.Box(i));
+        }
+        for (const size_t threads : {size_t(1), size_t(3), size_t(0)}) {
+            const AABB merged = MergeAABBs(boxes.View(), threads);
+            // Min and max of the same sums, exact
+            CHECK(merged.min == expected.min);
+            CHECK(merged.max == expected.max);
+        }
+    }
+    const AABB empty = MergeAABBs(AABBSoA {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0});
+    CHECK(empty.min == AABB::Empty().min);
+    CHECK(empty.max == AABB::Empty().max);
+}
+
+TEST_CASE("[Geometry] ray against a triangle: edges, misses and parallel rays") {
+    const Vector3 v0 (0, 0, 0), v1 (1, 0, 0), v2 (0, 1, 0);
+    const Vector3 down (0, 0, -1);
+    RayHit h {};
+    // Edges and corners count as hits
+    CHECK(Ray {Vector3(0.5f, 0, 1), down}.IntersectTriangle(v0, v1, v2, h));
+    CHECK((h.t == 1 && h.u == 0.5f && h.v == 0));
+    CHECK(Ray {Vector3(0, 0, 1), down}.IntersectTriangle(v0, v1, v2, h));
+    CHECK(Ray {Vector3(0.5f, 0.5f, 1), down}.IntersectTriangle(v0, v1, v2, h));
+    CHECK(Ray {Vector3(0, 1, 2), down}.IntersectTriangle(v0, v1, v2, h));
+    CHECK(h.t == 2);
+    // Just outside, behind the origin, parallel to the plane
+    CHECK_FALSE(Ray {Vector3(0.5f, -1e-3f, 1), down}.IntersectTriangle(v0, v1, v2, h));
+    CHECK_FALSE(Ray {Vector3(0.6f, 0.6f, 1), down}.IntersectTriangle(v0, v1, v2, h));
+    CHECK_FALSE(Ray {Vector3(0.2f, 0.2f, -1), down}.IntersectTriangle(v0, v1, v2, h));
+    CHECK_FALSE(Ray {Vector3(-1, 0.2f, 0), Vector3(1, 0, 0)}.IntersectTriangle(v0, v1, v2, h));
+    CHECK_FALSE(Ray {Vector3(-1, 0.2f, 1), Vector3(1, 0, 0)}.IntersectTriangle(v0, v1, v2, h));
+
+    // Same cases through the SoA and packet kernels
+    Soup soup;
+    soup.Add(v0, v1, v2);
+    const std::vector<Ray> rays {
+        {Vector3(0.5f, 0, 1), down}, {Vector3(0, 0, 1), down}, {Vector3(0.5f, 0.5f, 1), down},
+        {Vector3(0.5f, -1e-3f, 1), down}, {Vector3(0.2f, 0.2f, -1), down},
+        {Vector3(-1, 0.2f, 0), Vector3(1, 0, 0)}, {Vector3(-1, 0.2f, 1), Vector3(1, 0, 0)},
+    };
+    const RayPacket packet = RayPacket::FromRays(rays.data(), rays.size());
+    PacketHit hits = PacketHit::Miss();
+    const uint32_t mask = packet.IntersectTriangle(v0, v1, v2, hits);
+    for (size_t k = 0; k < rays.size(); k++) {
+        const bool single = rays[k].IntersectTriangle(v0, v1, v2, h);
+        RayHit closest {};
+        CHECK((rays[k].IntersectClosest(soup.View(1), closest) == 0) == single);
+        CHECK(bool(mask >> k & 1) == single);
+        if (single) {
+            CHECK((closest.t == h.t && closest.u == h.u && closest.v == h.v));
+            CHECK((hits.t[k] == h.t && hits.u[k] == h.u && hits.v[k] == h.v));
+        }
+    }
+}
+
+TEST_CASE("[Geometry] IntersectClosest matches single-ray tests") {
+    std::mt19937 rng {11};
+    // Full blocks of 8 and a tail
+    const Soup soup (8 * 25 + 3, rng);
+    const std::vector<Ray> rays = AimedRays(soup, 64, rng);
+    for (const size_t count : {size_t(0), size_t(5), size_t(8), soup.a.size()}) {
+        size_t hitCount = 0;
+        for (const Ray& ray : rays) {
+            RayHit expected {}, hit {};
+            const size_t index = soup.Closest(ray, count, expected);
+            REQUIRE(ray.IntersectClosest(soup.View(count), hit) == index);
+            if (index == count) { continue; }
+            hitCount++;
+            CHECK(Near(hit.t, expected.t, 1e-4f));
+            CHECK(Near(hit.u, expected.u, 1e-4f));
+            CHECK(Near(hit.v, expected.v, 1e-4f));
+            const Vector3 p = soup.a[index] + (soup.b[index] - soup.a[index]) * hit.u + (soup.c[index] - soup.a[index]) * hit.v;
+            CHECK(Near(p, ray.At(hit.t), 1e-3f));
+
+            // Nothing closer than the closest hit
+            RayHit none {};
+            CHECK(ray.IntersectClosest(soup.View(count), none, expected.t * 0.999f) == soup.Closest(ray, count, none, expected.t * 0.999f));
+        }
+        if (count == soup.a.size()) {
+            CHECK(hitCount > rays.size() / 2);
+        }
+    }
+}
+
+TEST_CASE("[Geometry] ray packets match single rays") {
+    std::mt19937 rng {12};
+    const Soup soup (61, rng);
+    std::vector<Ray> rays = AimedRays(soup, 19, rng);
+    // Axis-parallel rays: infinite reciprocals in the slab test, parallel to the plane below
+    rays.push_back(Ray {Vector3(0.5f, 0.5f, 9), Vector3(0, 0, -1)});
+    rays.push_back(Ray {Vector3(-9, 0.5f, 0.5f), Vector3(1, 0, 0)});
+    rays.push_back(Ray {Vector3(-9, 5, 0.5f), Vector3(1, 0, 0)});
+    const AABB box (Vector3(-1, -2, -1), Vector3(2, 1, 3));
+    const Vector3 center (1, 0, 0);
+    const Plane plane = Plane::FromPointNormal(Vector3(0, 1, 0), Vector3(0, 1, 0));
+
+    // 22 rays: two full packets and a tail of 6, whose missing lanes repeat the first ray
+    for (size_t base = 0; base < rays.size(); base += 8) {
+        const size_t n = std::min<size_t>(8, rays.size() - base);
+        const RayPacket packet = RayPacket::FromRays(&rays[base], n);
+        PacketHit hits = PacketHit::Miss();
+        uint32_t anyHit = 0;
+        for (size_t i = 0; i < soup.a.size(); i++) {
+            anyHit |= packet.IntersectTriangle(soup.a[i], soup.b[i], soup.c[i], hits);
+        }
+        std::array<float, 8> tBox, tSphere, tPlane;
+        tBox.fill(std::numeric_limits<float>::max());
+        tSphere = tBox;
+        tPlane = tBox;
+        const uint32_t boxMask = packet.Intersect(box, tBox);
+        const uint32_t sphereMask = packet.IntersectSphere(center, 2, tSphere);
+        const uint32_t planeMask = packet.Intersect(plane, tPlane);
+
+        for (size_t k = 0; k < 8; k++) {
+            const Ray& ray = rays[base + (k < n ? k : 0)];
+            RayHit expected {};
+            const size_t index = soup.Closest(ray, soup.a.size(), expected);
+            CHECK(bool(anyHit >> k & 1) == (index != soup.a.size()));
+            if (index != soup.a.size()) {
+                CHECK(Near(hits.t[k], expected.t, 1e-4f));
+                CHECK(Near(hits.u[k], expected.u, 1e-4f));
+                CHECK(Near(hits.v[k], expected.v, 1e-4f));
+            }
+            float t;
+            const bool hitBox = ray.Intersect(box, t);
+            CHECK(bool(boxMask >> k & 1) == hitBox);
+            if (hitBox) { CHECK(Near(tBox[k], t, 1e-4f)); }
+            const bool hitSphere = ray.IntersectSphere(center, 2, t);
+            CHECK(bool(sphereMask >> k & 1) == hitSphere);
+            if (hitSphere) {
+                CHECK(Near(tSphere[k], t, 1e-4f));
+                CHECK(Near((ray.At(t) - center).Magnitude(), 2, 1e-4f));
+            }
+            const bool hitPlane = ray.Intersect(plane, t);
+            CHECK(bool(planeMask >> k & 1) == hitPlane);
+            if (hitPlane) { CHECK(Near(tPlane[k], t, 1e-3f)); }
+        }
+        // Tail lanes get the first ray's results
+        for (size_t k = n; k < 8; k++) {
+            CHECK(hits.t[k] == hits.t[0]);
+            CHECK(tBox[k] == tBox[0]);
+        }
+    }
+
+    // A closer hit already in the packet is kept
+    const RayPacket packet = RayPacket::FromRays(rays.data(), 8);
+    std::array<float, 8> t;
+    t.fill(1e-3f);
+    CHECK(packet.Intersect(box, t) == 0);
+    CHECK(packet.IntersectSphere(center, 2, t) == 0);
+}
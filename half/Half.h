@@ -0,0 +1,172 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#if defined(__F16C__) && defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#ifndef NO_MATRIX_DEP
+#include "Matrix.h"
+#endif /* NO_MATRIX_DEP */
+
+namespace half {
+    [[nodiscard]] inline uint32_t FloatBits(float f) {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+        return x;
+    }
+
+    [[nodiscard]] inline float BitsFloat(uint32_t x) {
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+
+    ///IEEE 754 binary16, round to nearest even
+    [[nodiscard]] inline uint16_t FromFloat(float f) {
+        const uint32_t x = FloatBits(f);
+        const uint32_t sign = (x >> 16) & 0x8000;
+        const uint32_t absx = x & 0x7FFFFFFF;
+        // NaN stays NaN (quiet), infinity and overflow become infinity
+        if (absx > 0x7F800000) { return uint16_t(sign | 0x7E00); }
+        if (absx >= 0x47800000) { return uint16_t(sign | 0x7C00); }
+        // Normal
+        if (absx >= 0x38800000) {
+            uint32_t h = (absx >> 13) - (112 << 10);
+            const uint32_t rem = absx & 0x1FFF;
+            // Carry may roll into the exponent, up to infinity, which is correct
+            if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) { h++; }
+            return uint16_t(sign | h);
+        }
+        // Subnormal or zero, half of the smallest subnormal rounds to zero
+        if (absx <= 0x33000000) { return uint16_t(sign); }
+        const uint32_t shift = 126 - (absx >> 23);
+        const uint32_t m = (absx & 0x7FFFFF) | 0x800000;
+        uint32_t h = m >> shift;
+        const uint32_t rem = m & ((uint32_t(1) << shift) - 1);
+        const uint32_t halfway = uint32_t(1) << (shift - 1);
+        if (rem > halfway || (rem == halfway && (h & 1))) { h++; }
+        return uint16_t(sign | h);
+    }
+
+    [[nodiscard]] inline float ToFloat(uint16_t h) {
+        const uint32_t sign = uint32_t(h & 0x8000) << 16;
+        const uint32_t e = (h >> 10) & 0x1F;
+        const uint32_t m = h & 0x3FF;
+        if (e == 0x1F) { return BitsFloat(sign | 0x7F800000 | (m << 13)); }
+        if (e != 0) { return BitsFloat(sign | ((e + 112) << 23) | (m << 13)); }
+        // Subnormal or zero, m * 2^-24 is exact in float
+        const float v = float(m) * 5.9604644775390625e-8f;
+        return sign ? -v : v;
+    }
+
+    ///bfloat16, round to nearest even
+    [[nodiscard]] inline uint16_t BFromFloat(float f) {
+        uint32_t x = FloatBits(f);
+        if ((x & 0x7FFFFFFF) > 0x7F800000) { return uint16_t((x >> 16) | 0x40); }
+        x += 0x7FFF + ((x >> 16) & 1);
+        return uint16_t(x >> 16);
+    }
+
+    [[nodiscard]] inline float BToFloat(uint16_t b) {
+        return BitsFloat(uint32_t(b) << 16);
+    }
+}
+
+
+///16 bit storage type, all arithmetic happens in float.
+///Converts implicitly to and from float, so it can be used as
+///Matrix<rows, cols, float16> and Vector3T<float16>.
+///Max relative rounding error is 2^-11 (4.9e-4), range is ±65504.
+class float16 {
+public:
+    uint16_t bits;
+
+    float16() = default;
+    float16(float f) : bits(half::FromFloat(f)) { }
+    operator float() const { return half::ToFloat(bits); }
+
+    [[nodiscard]] static float16 FromBits(uint16_t bits) {
+        float16 ret;
+        ret.bits = bits;
+        return ret;
+    }
+
+    float16& operator+=(float v) { return *this = float(*this) + v; }
+    float16& operator-=(float v) { return *this = float(*this) - v; }
+    float16& operator*=(float v) { return *this = float(*this) * v; }
+    float16& operator/=(float v) { return *this = float(*this) / v; }
+};
+
+
+///Upper half of a float: same range as float, 8 bit mantissa.
+///Max relative rounding error is 2^-8 (3.9e-3).
+class bfloat16 {
+public:
+    uint16_t bits;
+
+    bfloat16() = default;
+    bfloat16(float f) : bits(half::BFromFloat(f)) { }
+    operator float() const { return half::BToFloat(bits); }
+
+    [[nodiscard]] static bfloat16 FromBits(uint16_t bits) {
+        bfloat16 ret;
+        ret.bits = bits;
+        return ret;
+    }
+
+    bfloat16& operator+=(float v) { return *this = float(*this) + v; }
+    bfloat16& operator-=(float v) { return *this = float(*this) - v; }
+    bfloat16& operator*=(float v) { return *this = float(*this) * v; }
+    bfloat16& operator/=(float v) { return *this = float(*this) / v; }
+};
+
+
+// Bulk conversion, uses F16C when compiled with -mf16c -mavx (or -march=native)
+
+inline void ToFloat(const float16* in, size_t count, float* out) {
+    size_t i = 0;
+#if defined(__F16C__) && defined(__AVX__)
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = in[i];
+    }
+}
+
+inline void FromFloat(const float* in, size_t count, float16* out) {
+    size_t i = 0;
+#if defined(__F16C__) && defined(__AVX__)
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = in[i];
+    }
+}
+
+inline void ToFloat(const bfloat16* in, size_t count, float* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = half::BToFloat(in[i].bits);
+    }
+}
+
+inline void FromFloat(const float* in, size_t count, bfloat16* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i].bits = half::BFromFloat(in[i]);
+    }
+}
+
+inline std::ostream& operator<<(std::ostream& o, float16 v) { return o << float(v); }
+inline std::ostream& operator<<(std::ostream& o, bfloat16 v) { return o << float(v); }
+
+#ifndef NO_MATRIX_DEP
+template <> struct MatrixAccumulator<float16> { using type = float; };
+template <> struct MatrixAccumulator<bfloat16> { using type = float; };
+#endif /* NO_MATRIX_DEP */
@@ -0,0 +1,83 @@
+// Throughput of bulk float16 conversion against a per-element loop.
+// bfloat16 has no hardware path, its bulk functions are plain loops.
+// Also checks that both produce the same bits.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+#include "Half.h"
+
+namespace {
+    constexpr size_t count = 4096;
+
+    // Millions of items per second, best of a few runs
+    double Measure(const std::function<void()>& f) {
+        using Clock = std::chrono::steady_clock;
+        double best = 0;
+        for (int run = 0; run < 5; run++) {
+            constexpr int reps = 200;
+            const auto start = Clock::now();
+            for (int r = 0; r < reps; r++) {
+                f();
+                // Keep the compiler from dropping or merging repetitions
+                asm volatile("" : : : "memory");
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            best = std::max(best, count * reps / seconds / 1e6);
+        }
+        return best;
+    }
+
+    struct Kernel {
+        const char* name;
+        std::function<void()> scalar, bulk;
+        // Outputs of the last runs
+        const void* scalarResult;
+        const void* bulkResult;
+        size_t bytes;
+    };
+}
+
+int main() {
+    std::mt19937 rng {42};
+    std::uniform_real_distribution<float> dist {-1000, 1000};
+    std::vector<float> floats (count);
+    for (float& f : floats) {
+        f = dist(rng);
+    }
+    std::vector<float16> halves (count), halvesOut (count);
+    for (size_t i = 0; i < count; i++) {
+        halves[i] = floats[i];
+    }
+    std::vector<float> scalarFloats (count), bulkFloats (count);
+
+    const Kernel kernels[] = {
+        {"float16 -> float",
+         [&] { for (size_t i = 0; i < count; i++) { scalarFloats[i] = half::ToFloat(halves[i].bits); } },
+         [&] { ToFloat(halves.data(), halves.size(), bulkFloats.data()); },
+         scalarFloats.data(), bulkFloats.data(), count * sizeof(float)},
+        {"float -> float16",
+         [&] { for (size_t i = 0; i < count; i++) { halvesOut[i].bits = half::FromFloat(floats[i]); } },
+         [&] { FromFloat(floats.data(), floats.size(), halves.data()); },
+         halvesOut.data(), halves.data(), count * sizeof(float16)},
+    };
+
+#if defined(__F16C__) && defined(__AVX__)
+    std::printf("Bulk float16 conversion uses F16C\n");
+#else
+    std::printf("Bulk float16 conversion is scalar, build with -mavx -mf16c for F16C\n");
+#endif
+    std::printf("Millions of items per second, %zu items\n\n", count);
+    std::printf("%-18s %8s %8s\n", "", "scalar", "bulk");
+    int mismatches = 0;
+    for (const Kernel& k : kernels) {
+        const double scalar = Measure(k.scalar);
+        const double bulk = Measure(k.bulk);
+        const bool same = std::memcmp(k.scalarResult, k.bulkResult, k.bytes) == 0;
+        mismatches += !same;
+        std::printf("%-18s %8.0f %8.0f%s\n", k.name, scalar, bulk, same ? "" : "  MISMATCH");
+    }
+    return mismatches != 0;
+}
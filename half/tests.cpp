@@ -0,0 +1,112 @@
+#include "Half.h"
+#include <cmath>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+TEST_CASE("[Half] exact values") {
+    CHECK(float16(0.0f).bits == 0x0000);
+    CHECK(float16(-0.0f).bits == 0x8000);
+    CHECK(float16(1.0f).bits == 0x3C00);
+    CHECK(float16(-2.0f).bits == 0xC000);
+    CHECK(float16(65504.0f).bits == 0x7BFF);
+    CHECK(float16(5.9604645e-8f).bits == 0x0001);
+    CHECK(float16(6.1035156e-5f).bits == 0x0400);
+    CHECK(float(float16::FromBits(0x3555)) == 0.333251953125f);
+}
+
+TEST_CASE("[Half] special values") {
+    CHECK(float16(65520.0f).bits == 0x7C00);
+    CHECK(float16(1e10f).bits == 0x7C00);
+    CHECK(float16(-INFINITY).bits == 0xFC00);
+    CHECK(std::isnan(float(float16(NAN))));
+    CHECK(std::isinf(float(float16::FromBits(0x7C00))));
+    CHECK(float16(2.9802322e-8f).bits == 0x0000);  // half of smallest subnormal, ties to even
+    CHECK(float16(4.4703484e-8f).bits == 0x0001);
+}
+
+TEST_CASE("[Half] round to nearest even") {
+    // 1 + 2^-11 is halfway between 1 and 1 + 2^-10
+    CHECK(float16(1.00048828125f).bits == 0x3C00);
+    CHECK(float16(1.00146484375f).bits == 0x3C02);
+    CHECK(float16(1.0005f).bits == 0x3C01);
+}
+
+TEST_CASE("[Half] roundtrip all values") {
+    for (uint32_t i = 0; i < 0x10000; i++) {
+        const float16 h = float16::FromBits(uint16_t(i));
+        const float f = h;
+        if (std::isnan(f)) { continue; }
+        REQUIRE(float16(f).bits == h.bits);
+    }
+}
+
+TEST_CASE("[Half] relative error") {
+    float maxErr = 0;
+    for (float f = 1e-4f; f < 60000; f *= 1.001f) {
+        maxErr = std::max(maxErr, std::abs(float(float16(f)) - f) / f);
+    }
+    CHECK(maxErr <= 0.00048828125f);
+
+    maxErr = 0;
+    for (float f = 1e-30f; f < 1e30f; f *= 1.01f) {
+        maxErr = std::max(maxErr, std::abs(float(bfloat16(f)) - f) / f);
+    }
+    CHECK(maxErr <= 0.00390625f);
+    CHECK(bfloat16(1.0f).bits == 0x3F80);
+    CHECK(float(bfloat16(3.0e38f)) > 2.9e38f);
+}
+
+TEST_CASE("[Half] bulk conversion") {
+    std::vector<float> in;
+    for (int i = 0; i < 1000; i++) {
+        in.push_back((i - 500) * 0.37f);
+    }
+    std::vector<float16> h (in.size());
+    std::vector<bfloat16> b (in.size());
+    std::vector<float> out (in.size());
+    FromFloat(in.data(), in.size(), h.data());
+    ToFloat(h.data(), h.size(), out.data());
+    for (size_t i = 0; i < in.size(); i++) {
+        REQUIRE(h[i].bits == float16(in[i]).bits);
+        REQUIRE(out[i] == float(float16(in[i])));
+    }
+    FromFloat(in.data(), in.size(), b.data());
+    ToFloat(b.data(), b.size(), out.data());
+    for (size_t i = 0; i < in.size(); i++) {
+        REQUIRE(out[i] == float(bfloat16(in[i])));
+    }
+}
+
+TEST_CASE("[Half] matrix") {
+    const Matrix<2, 3> a ({
+        1, 2, 3,
+        4, 5, 6,
+    });
+    const Matrix<3, 2> b ({
+        0.1f, 0.2f,
+        0.3f, 0.4f,
+        0.5f, 0.6f,
+    });
+    const Matrix<2, 3, float16> ah (a);
+    const Matrix<3, 2, float16> bh (b);
+    const Matrix<2, 2> expected = a * b;
+    const Matrix<2, 2> res (ah * bh);
+    for (size_t i = 0; i < res.n; i++) {
+        CHECK(std::abs(res[i] - expected[i]) < expected[i] * 0.002f);
+    }
+    CHECK(sizeof(ah) == 12);
+    CHECK(float(Matrix<3, 3, float16>::Identity().Trace()) == 3);
+    const auto inv = Matrix<2, 2, float16>(Matrix<2, 2>({4, 7, 2, 6})).Inverse();
+    CHECK(std::abs(inv(0, 0) - 0.6f) < 0.001f);
+    CHECK(std::abs(inv(0, 1) + 0.7f) < 0.001f);
+}
+
+TEST_CASE("[Half] accumulates in float") {
+    // 2048 + 1 is not representable in half, summing in half would stall
+    Matrix<1, 4096, float16> a;
+    Matrix<4096, 1, float16> b;
+    a.fill(1);
+    b.fill(1);
+    CHECK(float((a * b)[0]) == 4096);
+}
@@ -1,33 +1,333 @@
 #pragma once
+#include <array>
+#include <cmath>
+#include <sstream>
 #include <iomanip>
+#include <tuple>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
 
-template <size_t _rows, size_t _cols, typename T = float>
-class Matrix {
-    using real_t = typename std::conditional<
+// Define MATRIX_PROFILE to count calls, flops and cycles of the heavy
+// operations, see Profile.h. Hooks compile to nothing otherwise.
+#ifndef MATRIX_PROFILE_BEGIN
+#ifdef MATRIX_PROFILE
+#include "Profile.h"
+#else
+#define MATRIX_PROFILE_BEGIN(start)
+#define MATRIX_PROFILE_END(op, rows, cols, flops, start)
+#endif /* MATRIX_PROFILE */
+#endif /* MATRIX_PROFILE_BEGIN */
+
+#ifndef MATRIX_REAL_TYPE
+#define MATRIX_REAL_TYPE
+///Type of non-integer results (magnitudes, angles, factors) for elements of type T.
+///Integers and 16 bit floats use float. Specialize it for custom number types.
+template <typename T>
+struct RealType {
+    using type = typename std::conditional<
         std::is_floating_point<T>::value && (sizeof(T) >= sizeof(float)),
         T, float>::type;
+};
+#endif /* MATRIX_REAL_TYPE */
+
+#ifndef MATRIX_ACCUMULATOR
+#define MATRIX_ACCUMULATOR
+///Type used for intermediate sums in products and dot products.
+///Specialize it for element types that should widen while accumulating,
+///e.g. 16 bit floats accumulate in float.
+template <typename T>
+struct MatrixAccumulator { using type = T; };
+#endif /* MATRIX_ACCUMULATOR */
+
+///Accumulator for products of two element types, the wider of both
+///accumulators: Matrix<float> * Matrix<double> sums in double.
+template <typename T, typename U>
+using MatrixProductAccumulator = std::common_type_t<typename MatrixAccumulator<T>::type, typename MatrixAccumulator<U>::type>;
+
+///Whether Gauss() scales a row by the reciprocal of its lead, computed in
+///MatrixAccumulator<T>, instead of dividing every element by it.
+///Off by default so that float results don't change.
+template <typename T>
+struct MatrixReciprocalDivide : std::false_type { };
+
+// Kernels with at most this many scalar operations are fully unrolled,
+// larger ones keep their loops
+#ifndef MATRIX_UNROLL_LIMIT
+#define MATRIX_UNROLL_LIMIT 64
+#endif
+// The unrolled statements of a kernel are inlined into one body,
+// -O2 size limits would otherwise leave some of them as calls
+#if defined(__GNUC__)
+#define MATRIX_FLATTEN __attribute__((flatten))
+#else
+#define MATRIX_FLATTEN
+#endif
+
+template <size_t _rows, size_t _cols, typename T = float>
+class Matrix;
+template <size_t _rows, size_t _cols, typename T = float>
+class MatrixView;
+
+namespace matrix_detail {
+    template <typename F, size_t... i>
+    MATRIX_FLATTEN constexpr void Unrolled(F& f, std::index_sequence<i...>) noexcept {
+        (f(std::integral_constant<size_t, i>{}), ...);
+    }
+
+    // f(i) for i in [0, count). Unrolled, i is a std::integral_constant:
+    // every call of a generic lambda is its own instantiation, called once,
+    // so it is always inlined and no loop counters or index arithmetic remain
+    template <size_t count, bool unroll = (count <= MATRIX_UNROLL_LIMIT), typename F>
+    constexpr void For(F&& f) noexcept {
+        if constexpr (unroll) {
+            Unrolled(f, std::make_index_sequence<count>{});
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                f(i);
+            }
+        }
+    }
+
+    // Reduced row echelon form, in place.
+    // Works on anything with rows, cols, value_type and operator()(row, col)
+    template <typename M>
+    constexpr void Gauss(M& m) noexcept {
+        using T = typename M::value_type;
+        using real_t = typename RealType<T>::type;
+        constexpr size_t rows = M::rows;
+        constexpr size_t cols = M::cols;
+        MATRIX_PROFILE_BEGIN(profile_start);
+        // For each row, subtract it from all other rows
+        for (size_t current_row = 0; current_row < m.rows; current_row++) {
+
+            // Find the first non-zero element in current row
+            size_t cur_lead = m.cols;
+            for (size_t j = 0; j < m.cols; j++) {
+                if (m(current_row, j) != 0) {
+                    cur_lead = j;
+                    break;
+                }
+            }
+
+            // Make sure we're always working with the smallest lead.
+            // Lead can't be smaller then row index on row 0
+            // Lead can't be smaller then row index after row 0,
+            // because row 0 pass removes lead 0 from all other rows,
+            // so if lead == row than there's no smaller lead
+            if (cur_lead != current_row) {
+                size_t min_lead_row = current_row;
+                size_t min_lead = cur_lead;
+                // Find a smaller lead after current row
+                for (size_t ii = current_row + 1; ii < rows; ii++) {
+                    size_t lead = m.rows;
+                    // Find this row's lead
+                    // We don't care about it if it's same or bigger,
+                    // only if it's smaller
+                    for (size_t j = 0; j < cur_lead; j++) {
+                        if (m(ii, j) != 0) {
+                            lead = j;
+                            break;
+                        }
+                    }
+                    if (lead < min_lead) {
+                        min_lead_row = ii;
+                        min_lead = lead;
+                    }
+                }
+
+                // Swap rows
+                if (min_lead_row != current_row) {
+                    for (size_t j = min_lead; j < cols; j++) {
+                        // Allow non-std overloads of swap() for T
+                        using namespace std;
+                        swap(m(current_row, j), m(min_lead_row, j));
+                    }
+                    cur_lead = min_lead;
+                }
+            }
+
+            // Skip the row if it's empty
+            if (cur_lead == size_t(m.cols)) { break; }
+
+
+            // Divide current_row by lead for it to become 1
+            // Optimization: manually set lead to 1, ignore cells before lead
+            {
+                T lead_val = m(current_row, cur_lead);
+                if (lead_val != 1) {
+                    m(current_row, cur_lead) = 1;
+                    if constexpr (MatrixReciprocalDivide<T>::value) {
+                        using accum_t = typename MatrixAccumulator<T>::type;
+                        const accum_t inv = accum_t(1) / accum_t(lead_val);
+                        for (size_t j = cur_lead + 1; j < m.cols; j++) {
+                            m(current_row, j) = T(accum_t(m(current_row, j)) * inv);
+                        }
+                    } else {
+                        for (size_t j = cur_lead + 1; j < m.cols; j++) {
+                            m(current_row, j) /= lead_val;
+                        }
+                    }
+                }
+            }
+
+            // Zero out current lead's column on all rows except current
+            // by subtracting `current_row * f` from it
+            for (size_t other_row = 0; other_row < m.rows; other_row++) {
+                if (other_row == current_row) { continue; }
+                // Skip if other lead is already zero
+                if (m(other_row, cur_lead) == 0) { continue; }
+                // Calculate f so that lead becomes zero,
+                // current_row's lead is already 1
+                real_t f = m(other_row, cur_lead);
+                // Subtract current_row from other_row
+                for (size_t j = 0; j < m.cols; j++) {
+                    m(other_row, j) -= m(current_row, j) * f;
+                }
+            }
+
+        }
+        MATRIX_PROFILE_END(Gauss, rows, cols, 2 * rows * rows * cols, profile_start);
+    }
+
+    template <typename M>
+    [[nodiscard]] constexpr Matrix<M::rows, M::cols, typename M::value_type> Inverse(const M& a) noexcept {
+        using T = typename M::value_type;
+        constexpr size_t rows = M::rows;
+        constexpr size_t cols = M::cols;
+        static_assert(rows == cols, "Can't calculate inverse of a non-square matrix");
+        MATRIX_PROFILE_BEGIN(profile_start);
+        Matrix<rows, cols * 2, T> m ({0});
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                m(i, j) = a(i, j);
+            }
+            m(i, i + cols) = 1;
+        }
+        m.Gauss();
+        Matrix<rows, cols, T> ret;
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                ret(i, j) = m(i, j + cols);
+            }
+        }
+        MATRIX_PROFILE_END(Inverse, rows, cols, 4 * rows * rows * cols, profile_start);
+        return ret;
+    }
+
+    // Scaling and squaring (Golub & Van Loan, Matrix Computations, 11.3.1):
+    // scale a by 2^-s until its infinity norm is at most 1/2, take the
+    // [6/6] Padé approximant N / D by solving [D | N] with Gauss, square s times
+    template <typename M>
+    [[nodiscard]] constexpr Matrix<M::rows, M::cols, typename RealType<typename M::value_type>::type> Exp(const M& a) noexcept {
+        using real_t = typename RealType<typename M::value_type>::type;
+        constexpr size_t n = M::rows;
+        static_assert(M::rows == M::cols, "Can't calculate exponential of a non-square matrix");
+        real_t norm = 0;
+        for (size_t i = 0; i < n; i++) {
+            real_t rowSum = 0;
+            for (size_t j = 0; j < n; j++) {
+                const real_t v = real_t(a(i, j));
+                rowSum += v < 0 ? -v : v;
+            }
+            norm = std::max(norm, rowSum);
+        }
+        real_t scale = 1;
+        size_t squarings = 0;
+        // Also terminates for inf and NaN, scale underflows to 0
+        while (norm * scale > real_t(0.5)) {
+            scale /= 2;
+            squarings++;
+        }
+
+        Matrix<n, n, real_t> scaled;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                scaled(i, j) = real_t(a(i, j)) * scale;
+            }
+        }
+        Matrix<n, n * 2, real_t> dn;
+        for (size_t i = 0; i < n; i++) {
+            dn(i, i) = 1;
+            dn(i, i + n) = 1;
+        }
+        constexpr size_t q = 6;
+        Matrix<n, n, real_t> power = scaled;
+        real_t c = 1;
+        for (size_t k = 1; k <= q; k++) {
+            if (k > 1) { power = power * scaled; }
+            c = c * real_t(q - k + 1) / real_t(k * (2 * q - k + 1));
+            const real_t signedC = k % 2 ? -c : c;
+            for (size_t i = 0; i < n; i++) {
+                for (size_t j = 0; j < n; j++) {
+                    dn(i, j) += signedC * power(i, j);
+                    dn(i, j + n) += c * power(i, j);
+                }
+            }
+        }
+        dn.Gauss();
+
+        Matrix<n, n, real_t> ret;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                ret(i, j) = dn(i, j + n);
+            }
+        }
+        for (size_t i = 0; i < squarings; i++) {
+            ret = ret * ret;
+        }
+        return ret;
+    }
+
+    // Product of any two matrix-like operands (Matrix or MatrixView)
+    template <typename T, typename A, typename B>
+    [[nodiscard]] constexpr Matrix<A::rows, B::cols, T> Multiply(const A& a, const B& b) noexcept {
+        static_assert(A::cols == B::rows, "Can't multiply matrices with incompatible dimensions");
+        using accum_t = MatrixProductAccumulator<typename A::value_type, typename B::value_type>;
+        constexpr bool unroll = A::rows * A::cols * B::cols <= MATRIX_UNROLL_LIMIT;
+        MATRIX_PROFILE_BEGIN(profile_start);
+        Matrix<A::rows, B::cols, T> ret;
+        For<A::rows, unroll>([&](auto i) {
+            For<B::cols, unroll>([&](auto j) {
+                accum_t sum = 0;
+                For<A::cols, unroll>([&](auto k) {
+                    sum += accum_t(a(i, k)) * accum_t(b(k, j));
+                });
+                ret(i, j) = T(sum);
+            });
+        });
+        MATRIX_PROFILE_END(Multiply, A::rows, B::cols, 2 * A::rows * A::cols * B::cols, profile_start);
+        return ret;
+    }
+}
+
+template <size_t _rows, size_t _cols, typename T>
+class Matrix {
+    using real_t = typename RealType<T>::type;
+    using accum_t = typename MatrixAccumulator<T>::type;
     static_assert(_rows != 0, "Can't create matrix with 0 rows");
     static_assert(_cols != 0, "Can't create matrix with 0 columns");
 public:
     static constexpr size_t rows = _rows;
     static constexpr size_t cols = _cols;
     static constexpr size_t n = rows * cols;
+    using value_type = T;
     std::array<T, rows* cols> data;
 public:
 
     constexpr Matrix() noexcept : data() {}
     // std::array is not movable, so pass by const reference
     constexpr Matrix(const std::array<T, n>& data) noexcept : data(data) {}
-    constexpr Matrix(const Matrix<rows, cols, T>& other) noexcept : data(other.data) {}
+    // Defaulted copy and move keep Matrix trivially copyable (memcpy-able)
+    constexpr Matrix(const Matrix& other) noexcept = default;
     template <typename _T>
-    explicit constexpr Matrix(const Matrix<rows, cols, _T>& other) noexcept {
-        for(size_t i = 0; i < n; i++) {
-            data[i] = other[i];
-        }
+    explicit constexpr Matrix(const Matrix<rows, cols, _T>& other) noexcept : data() {
+        matrix_detail::For<n>([&](auto i) { data[i] = T(other[i]); });
     }
-    constexpr Matrix(Matrix<rows, cols, T>&& other) noexcept : data(std::move(other.data)) {}
-    constexpr Matrix<rows, cols, T>& operator=(const Matrix<rows, cols, T>& other)& noexcept { data = other.data; return *this; }
-    constexpr Matrix<rows, cols, T>& operator=(Matrix<rows, cols, T>&& other)& noexcept { data = std::move(other.data); return *this; }
+    constexpr Matrix(Matrix&& other) noexcept = default;
+    constexpr Matrix& operator=(const Matrix& other)& noexcept = default;
+    constexpr Matrix& operator=(Matrix&& other)& noexcept = default;
 
     [[nodiscard]] static constexpr Matrix<rows, cols, T> FromColumns(const std::array<Matrix<rows, 1, T>, cols>& columns) noexcept {
         Matrix<rows, cols, T> ret;
@@ -44,9 +344,7 @@ public:
     [[nodiscard]] static constexpr Matrix<rows, cols, T> Identity() noexcept {
         static_assert(rows == cols, "Identity matrix must be square");
         auto ret = Matrix<rows, cols, T>::Zero();
-        for (size_t i = 0; i < rows; i++) {
-            ret.data[(rows + 1)*i] = 1;
-        }
+        matrix_detail::For<rows>([&](auto i) { ret.data[(rows + 1)*i] = 1; });
         return ret;
     }
 
@@ -69,36 +367,26 @@ public:
 
     template <typename _T>
     constexpr Matrix<rows, cols, T>& operator+=(const Matrix<rows, cols, _T>& other)& noexcept {
-        for (size_t i = 0; i < n; i++) {
-            data[i] += other.data[i];
-        }
+        matrix_detail::For<n>([&](auto i) { data[i] += other.data[i]; });
         return *this;
     }
     template <typename _T>
     constexpr Matrix<rows, cols, T>& operator-=(const Matrix<rows, cols, _T>& other)& noexcept {
-        for (size_t i = 0; i < n; i++) {
-            data[i] -= other.data[i];
-        }
+        matrix_detail::For<n>([&](auto i) { data[i] -= other.data[i]; });
         return *this;
     }
     constexpr Matrix<rows, cols, T>& operator*=(const T other)& noexcept {
-        for (size_t i = 0; i < n; i++) {
-            data[i] *= other;
-        }
+        matrix_detail::For<n>([&](auto i) { data[i] *= other; });
         return *this;
     }
     constexpr Matrix<rows, cols, T>& operator/=(const T other)& noexcept {
-        for (size_t i = 0; i < n; i++) {
-            data[i] /= other;
-        }
+        matrix_detail::For<n>([&](auto i) { data[i] /= other; });
         return *this;
     }
 
     [[nodiscard]] constexpr Matrix<rows, cols, T> operator-() const noexcept {
         Matrix<rows, cols, T> ret;
-        for (size_t i = 0; i < n; i++) {
-            ret.data[i] = -this->data[i];
-        }
+        matrix_detail::For<n>([&](auto i) { ret.data[i] = -data[i]; });
         return ret;
     }
 
@@ -108,17 +396,34 @@ public:
 
     template <size_t cols2, typename _T>
     [[nodiscard]] constexpr Matrix<rows, cols2, T> operator*(const Matrix<cols, cols2, _T>& other) const noexcept {
-        Matrix<rows, cols2, T> ret;
-        for (size_t i = 0; i < ret.n; i++) {
-            const int cRow = ret.rOf(i);
-            const int cCol = ret.cOf(i);
-            T sum = 0;
+        return matrix_detail::Multiply<T>(*this, other);
+    }
+
+    template <size_t cols2, typename _T>
+    [[nodiscard]] constexpr Matrix<rows, cols2, T> operator*(const MatrixView<cols, cols2, _T>& other) const noexcept {
+        return matrix_detail::Multiply<T>(*this, other);
+    }
+
+    // Into a copy, the view may alias *this (m += m.TransposedView())
+    template <typename _T>
+    constexpr Matrix<rows, cols, T>& operator+=(const MatrixView<rows, cols, _T>& other)& noexcept {
+        Matrix<rows, cols, T> ret;
+        for (size_t i = 0; i < rows; i++) {
             for (size_t j = 0; j < cols; j++) {
-                sum += (*this)(cRow, j) * other(j, cCol);
+                ret(i, j) = (*this)(i, j) + other(i, j);
             }
-            ret[i] = sum;
         }
-        return ret;
+        return *this = ret;
+    }
+    template <typename _T>
+    constexpr Matrix<rows, cols, T>& operator-=(const MatrixView<rows, cols, _T>& other)& noexcept {
+        Matrix<rows, cols, T> ret;
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                ret(i, j) = (*this)(i, j) - other(i, j);
+            }
+        }
+        return *this = ret;
     }
 
     friend constexpr Matrix<rows, cols, T> operator+(Matrix<rows, cols, T> a, const Matrix<rows, cols, T>& b) noexcept { return a += b; }
@@ -186,149 +491,630 @@ public:
         return ret;
     }
 
-    [[nodiscard]] constexpr Matrix<rows, cols, T> Transposed() const noexcept {
+    [[nodiscard]] constexpr Matrix<cols, rows, T> Transposed() const noexcept {
         Matrix<cols, rows, T> ret;
-        for (size_t i = 0; i < rows; i++) {
-            for (size_t j = 0; j < cols; j++) {
-                ret(j, i) = (*this)(i, j);
-            }
-        }
+        constexpr bool unroll = n <= MATRIX_UNROLL_LIMIT;
+        matrix_detail::For<rows, unroll>([&](auto i) {
+            matrix_detail::For<cols, unroll>([&](auto j) { ret(j, i) = (*this)(i, j); });
+        });
         return ret;
     }
 
+    // Non-owning views, the matrix must outlive them
+
+    [[nodiscard]] constexpr MatrixView<cols, rows, T> TransposedView() noexcept { return {data.data(), 1, cols}; }
+    [[nodiscard]] constexpr MatrixView<cols, rows, const T> TransposedView() const noexcept { return {data.data(), 1, cols}; }
+    [[nodiscard]] constexpr MatrixView<1, cols, T> RowView(size_t row) noexcept { return {data.data() + row * cols, cols, 1}; }
+    [[nodiscard]] constexpr MatrixView<1, cols, const T> RowView(size_t row) const noexcept { return {data.data() + row * cols, cols, 1}; }
+    [[nodiscard]] constexpr MatrixView<rows, 1, T> ColumnView(size_t col) noexcept { return {data.data() + col, cols, 1}; }
+    [[nodiscard]] constexpr MatrixView<rows, 1, const T> ColumnView(size_t col) const noexcept { return {data.data() + col, cols, 1}; }
+
+    // The rows2 x cols2 block at (row, col). Requires row + rows2 <= rows and
+    // col + cols2 <= cols, the offsets aren't checked
+    template <size_t rows2, size_t cols2>
+    [[nodiscard]] constexpr MatrixView<rows2, cols2, T> SubmatrixView(size_t row = 0, size_t col = 0) noexcept {
+        static_assert(rows2 <= rows, "Submatrix must be smaller than the original matrix");
+        static_assert(cols2 <= cols, "Submatrix must be smaller than the original matrix");
+        return {data.data() + row * cols + col, cols, 1};
+    }
+    template <size_t rows2, size_t cols2>
+    [[nodiscard]] constexpr MatrixView<rows2, cols2, const T> SubmatrixView(size_t row = 0, size_t col = 0) const noexcept {
+        static_assert(rows2 <= rows, "Submatrix must be smaller than the original matrix");
+        static_assert(cols2 <= cols, "Submatrix must be smaller than the original matrix");
+        return {data.data() + row * cols + col, cols, 1};
+    }
+
     [[nodiscard]] constexpr real_t Trace() const noexcept {
         static_assert(rows == cols, "Trace of a non-square matrix is undefined");
         real_t sum = 0;
-        for (size_t i = 0; i < rows; i++) {
-            sum += data[(rows + 1) * i];
-        }
+        matrix_detail::For<rows>([&](auto i) { sum += data[(rows + 1) * i]; });
         return sum;
     }
 
     [[nodiscard]] constexpr Matrix Inverse() const noexcept {
-        static_assert(rows == cols, "Can't calculate inverse of a non-square matrix");
-        Matrix<rows, cols * 2, T> m ({0});
+        return matrix_detail::Inverse(*this);
+    }
+
+    constexpr void Gauss() noexcept {
+        matrix_detail::Gauss(*this);
+    }
+
+    ///this^n by repeated squaring, O(log n) multiplications. Pow(0) is identity
+    [[nodiscard]] constexpr Matrix Pow(unsigned n) const noexcept {
+        static_assert(rows == cols, "Can't raise a non-square matrix to a power");
+        Matrix ret = Identity();
+        Matrix base = *this;
+        while (n > 0) {
+            if (n & 1) { ret = ret * base; }
+            n >>= 1;
+            if (n > 0) { base = base * base; }
+        }
+        return ret;
+    }
+
+    ///this^n with the squarings unrolled at compile time
+    template <unsigned n>
+    [[nodiscard]] constexpr Matrix Pow() const noexcept {
+        static_assert(rows == cols, "Can't raise a non-square matrix to a power");
+        if constexpr (n == 0) {
+            return Identity();
+        } else if constexpr (n == 1) {
+            return *this;
+        } else {
+            const Matrix half = Pow<n / 2>();
+            if constexpr (n % 2 == 0) {
+                return half * half;
+            } else {
+                return half * half * *this;
+            }
+        }
+    }
+
+    ///Matrix exponential e^this, e.g. the transition matrix e^(Qt) of a
+    ///continuous-time Markov chain or e^(At) of x' = Ax.
+    ///Accurate to about machine precision of RealType<T>
+    [[nodiscard]] constexpr Matrix<rows, cols, real_t> Exp() const noexcept {
+        return matrix_detail::Exp(*this);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Matrix<rows, cols, T>& m) {
+        static const auto len = [](const T a) {
+            std::stringstream ss;
+            ss << a;
+            return ss.str().size();
+        };
+
+        if (rows * cols > 0) {
+
+            auto mlen = len(m.data[0]);
+            for (const auto& v : m.data) {
+                mlen = std::max(mlen, len(v));
+            }
+            for (size_t row = 0; row < rows; row++) {
+                os << '|';
+                for (size_t col = 0; col < cols - 1; col++) {
+                    os << std::setw(mlen) << m(row, col) << ' ';
+                }
+                os << std::setw(mlen) << m(row, cols - 1) << '|' << std::endl;
+            }
+        }
+        return os;
+    }
+};
+
+
+///Non-owning strided view of a matrix: element (row, col) is
+///ptr[row * rowStride + col * colStride]. Returned by Matrix::TransposedView(),
+///RowView(), ColumnView() and SubmatrixView(). Writes go through to the matrix.
+///The viewed storage must outlive the view.
+template <size_t _rows, size_t _cols, typename T>
+class MatrixView {
+    using value_t = std::remove_const_t<T>;
+public:
+    static constexpr size_t rows = _rows;
+    static constexpr size_t cols = _cols;
+    static constexpr size_t n = rows * cols;
+    using value_type = value_t;
+    T* ptr;
+    size_t rowStride;
+    size_t colStride;
+
+    constexpr MatrixView(T* ptr, size_t rowStride, size_t colStride) noexcept : ptr(ptr), rowStride(rowStride), colStride(colStride) {}
+    constexpr MatrixView(Matrix<rows, cols, value_t>& m) noexcept : ptr(m.data.data()), rowStride(cols), colStride(1) {}
+    constexpr MatrixView(const Matrix<rows, cols, value_t>& m) noexcept : ptr(m.data.data()), rowStride(cols), colStride(1) {}
+    // Mutable view to const view
+    template <typename _T>
+    constexpr MatrixView(const MatrixView<rows, cols, _T>& other) noexcept : ptr(other.ptr), rowStride(other.rowStride), colStride(other.colStride) {}
+
+    [[nodiscard]] constexpr T& operator()(int row, int col) const noexcept { return ptr[row * rowStride + col * colStride]; }
+
+    [[nodiscard]] constexpr Matrix<rows, cols, value_t> ToMatrix() const noexcept {
+        Matrix<rows, cols, value_t> ret;
         for (size_t i = 0; i < rows; i++) {
             for (size_t j = 0; j < cols; j++) {
-                m(i, j) = (*this)(i, j);
+                ret(i, j) = (*this)(i, j);
             }
-            m(i, i + cols) = 1;
         }
-        m.Gauss();
-        Matrix<rows, cols, T> ret;
+        return ret;
+    }
+
+    [[nodiscard]] constexpr MatrixView<cols, rows, T> TransposedView() const noexcept { return {ptr, colStride, rowStride}; }
+
+    // From a copy, `other` may be the viewed matrix (m.TransposedView() += m)
+    template <typename _T>
+    constexpr const MatrixView& operator+=(const Matrix<rows, cols, _T>& other) const noexcept {
+        const Matrix<rows, cols, _T> copy = other;
         for (size_t i = 0; i < rows; i++) {
             for (size_t j = 0; j < cols; j++) {
-                ret(i, j) = m(i, j + cols);
+                (*this)(i, j) += copy(i, j);
             }
         }
-        return ret;
+        return *this;
+    }
+    template <typename _T>
+    constexpr const MatrixView& operator-=(const Matrix<rows, cols, _T>& other) const noexcept {
+        const Matrix<rows, cols, _T> copy = other;
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                (*this)(i, j) -= copy(i, j);
+            }
+        }
+        return *this;
+    }
+    constexpr const MatrixView& operator*=(const value_t other) const noexcept {
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                (*this)(i, j) *= other;
+            }
+        }
+        return *this;
+    }
+    constexpr const MatrixView& operator/=(const value_t other) const noexcept {
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                (*this)(i, j) /= other;
+            }
+        }
+        return *this;
     }
 
-    constexpr void Gauss() noexcept {
-        Matrix<rows, cols, T>& m = *this;
-        // For each row, subtract it from all other rows
-        for (size_t current_row = 0; current_row < m.rows; current_row++) {
+    template <size_t cols2, typename _T>
+    [[nodiscard]] constexpr Matrix<rows, cols2, value_t> operator*(const Matrix<cols, cols2, _T>& other) const noexcept {
+        return matrix_detail::Multiply<value_t>(*this, other);
+    }
+    template <size_t cols2, typename _T>
+    [[nodiscard]] constexpr Matrix<rows, cols2, value_t> operator*(const MatrixView<cols, cols2, _T>& other) const noexcept {
+        return matrix_detail::Multiply<value_t>(*this, other);
+    }
 
-            // Find the first non-zero element in current row
-            size_t cur_lead = m.cols;
-            for (size_t j = 0; j < m.cols; j++) {
-                if (m(current_row, j) != 0) {
-                    cur_lead = j;
-                    break;
-                }
+    [[nodiscard]] constexpr Matrix<rows, cols, value_t> Inverse() const noexcept {
+        return matrix_detail::Inverse(*this);
+    }
+
+    ///Gauss-Jordan elimination in place, on the viewed elements
+    constexpr void Gauss() const noexcept {
+        MatrixView m = *this;
+        matrix_detail::Gauss(m);
+    }
+};
+
+///a * bᵀ without materializing the transpose, rows of both are read contiguously
+template <size_t rows, size_t cols, size_t rows2, typename T, typename _T>
+[[nodiscard]] constexpr Matrix<rows, rows2, T> MultiplyTransposed(const Matrix<rows, cols, T>& a, const Matrix<rows2, cols, _T>& b) noexcept {
+    return matrix_detail::Multiply<T>(a, b.TransposedView());
+}
+
+///aᵀ * b without materializing the transpose, accumulates row by row
+///so that both operands are read contiguously
+template <size_t rows, size_t cols, size_t cols2, typename T, typename _T>
+[[nodiscard]] constexpr Matrix<cols, cols2, T> TransposedMultiply(const Matrix<rows, cols, T>& a, const Matrix<rows, cols2, _T>& b) noexcept {
+    using accum_t = MatrixProductAccumulator<T, _T>;
+    Matrix<cols, cols2, accum_t> sum;
+    for (size_t k = 0; k < rows; k++) {
+        for (size_t i = 0; i < cols; i++) {
+            const accum_t aki = a(k, i);
+            for (size_t j = 0; j < cols2; j++) {
+                sum(i, j) += aki * accum_t(b(k, j));
             }
+        }
+    }
+    return Matrix<cols, cols2, T>(sum);
+}
 
-            // Make sure we're always working with the smallest lead.
-            // Lead can't be smaller then row index on row 0
-            // Lead can't be smaller then row index after row 0,
-            // because row 0 pass removes lead 0 from all other rows,
-            // so if lead == row than there's no smaller lead
-            if (cur_lead != current_row) {
-                size_t min_lead_row = current_row;
-                size_t min_lead = cur_lead;
-                // Find a smaller lead after current row
-                for (size_t ii = current_row + 1; ii < rows; ii++) {
-                    size_t lead = m.rows;
-                    // Find this row's lead
-                    // We don't care about it if it's same or bigger,
-                    // only if it's smaller
-                    for (size_t j = 0; j < cur_lead; j++) {
-                        if (m(ii, j) != 0) {
-                            lead = j;
-                            break;
-                        }
-                    }
-                    if (lead < min_lead) {
-                        min_lead_row = ii;
-                        min_lead = lead;
-                    }
-                }
+namespace matrix_detail {
+    // Below this an update loses more than half of the significant digits
+    template <typename T>
+    [[nodiscard]] constexpr T UpdateTolerance() noexcept {
+        using std::sqrt;
+        return sqrt(std::numeric_limits<T>::epsilon());
+    }
+}
 
-                // Swap rows
-                if (min_lead_row != current_row) {
-                    for (size_t j = min_lead; j < cols; j++) {
-                        // Allow non-std overloads of swap() for T
-                        using namespace std;
-                        swap(m(current_row, j), m(min_lead_row, j));
-                    }
-                    cur_lead = min_lead;
-                }
+///Sherman-Morrison: turns aInv = A⁻¹ into (A + u * vᵀ)⁻¹ in place, O(N²).
+///Returns false and leaves aInv unchanged when A + u * vᵀ is singular or
+///the update would cancel too many digits, invert from scratch in that case
+template <size_t n, typename T>
+constexpr bool InverseUpdateRank1(Matrix<n, n, T>& aInv, const Matrix<n, 1, T>& u, const Matrix<n, 1, T>& v) noexcept {
+    using real_t = typename RealType<T>::type;
+    using accum_t = typename MatrixAccumulator<T>::type;
+    Matrix<n, 1, T> z = aInv * u;
+    const Matrix<1, n, T> w = TransposedMultiply(v, aInv);
+    accum_t dot = 0;
+    real_t magnitude = 1;
+    for (size_t i = 0; i < n; i++) {
+        const accum_t term = accum_t(v[i]) * accum_t(z[i]);
+        dot += term;
+        magnitude += real_t(term < 0 ? -term : term);
+    }
+    const real_t denominator = real_t(1) + real_t(dot);
+    const real_t absDenominator = denominator < 0 ? -denominator : denominator;
+    // Negated so that NaN fails too
+    if (!(absDenominator > matrix_detail::UpdateTolerance<real_t>() * magnitude)) {
+        return false;
+    }
+    z *= T(real_t(1) / denominator);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            aInv(i, j) -= z[i] * w[j];
+        }
+    }
+    return true;
+}
+
+///Sherman-Morrison on both A and aInv = A⁻¹: A += u * vᵀ, then aInv is updated
+///in O(N²) or, if that is unstable, recomputed with A.Inverse().
+///Returns whether the O(N²) update was used
+template <size_t n, typename T>
+constexpr bool InverseUpdateRank1(Matrix<n, n, T>& a, Matrix<n, n, T>& aInv, const Matrix<n, 1, T>& u, const Matrix<n, 1, T>& v) noexcept {
+    a += MultiplyTransposed(u, v);
+    if (InverseUpdateRank1(aInv, u, v)) { return true; }
+    aInv = a.Inverse();
+    return false;
+}
+
+///Woodbury: turns aInv = A⁻¹ into (A + U * Vᵀ)⁻¹ in place for k columns in U and V,
+///O(N²k + k³) instead of O(N³). Returns false and leaves aInv unchanged when
+///the k x k capacitance matrix I + Vᵀ * A⁻¹ * U can't be inverted accurately
+template <size_t n, size_t k, typename T>
+constexpr bool InverseUpdateRankK(Matrix<n, n, T>& aInv, const Matrix<n, k, T>& u, const Matrix<n, k, T>& v) noexcept {
+    using real_t = typename RealType<T>::type;
+    const Matrix<n, k, T> z = aInv * u;
+    const Matrix<k, n, T> w = TransposedMultiply(v, aInv);
+    const Matrix<k, k, T> capacitance = Matrix<k, k, T>::Identity() + TransposedMultiply(v, z);
+    const Matrix<k, k, T> capacitanceInv = capacitance.Inverse();
+    // Residual of the small inverse, grows with its condition number
+    const Matrix<k, k, T> residual = capacitance * capacitanceInv - Matrix<k, k, T>::Identity();
+    real_t error = 0;
+    for (const T e : residual) {
+        error = std::max(error, real_t(e < 0 ? -e : e));
+    }
+    if (!(error <= matrix_detail::UpdateTolerance<real_t>())) {
+        return false;
+    }
+    aInv -= z * (capacitanceInv * w);
+    return true;
+}
+
+///Woodbury on both A and aInv = A⁻¹: A += U * Vᵀ, then aInv is updated
+///in O(N²k) or, if that is unstable, recomputed with A.Inverse().
+///Returns whether the O(N²k) update was used
+template <size_t n, size_t k, typename T>
+constexpr bool InverseUpdateRankK(Matrix<n, n, T>& a, Matrix<n, n, T>& aInv, const Matrix<n, k, T>& u, const Matrix<n, k, T>& v) noexcept {
+    a += MultiplyTransposed(u, v);
+    if (InverseUpdateRankK(aInv, u, v)) { return true; }
+    aInv = a.Inverse();
+    return false;
+}
+
+///Symmetric N x N matrix storing only the lower triangle, N * (N + 1) / 2 elements
+///packed row by row: (row, col) with col <= row is data[row * (row + 1) / 2 + col].
+///Covariance, inertia and Hessian matrices; Gram() and RankUpdate() compute
+///half of aᵀ * a, Solve() and Inverse() use an LDLᵀ factorization
+template <size_t N, typename T = float>
+class SymmetricMatrix {
+    using accum_t = typename MatrixAccumulator<T>::type;
+    using real_t = typename RealType<T>::type;
+    static_assert(N != 0, "Can't create matrix with 0 rows");
+public:
+    static constexpr size_t rows = N;
+    static constexpr size_t cols = N;
+    static constexpr size_t n = N * (N + 1) / 2;
+    using value_type = T;
+    std::array<T, n> data;
+
+    constexpr SymmetricMatrix() noexcept : data() {}
+    constexpr SymmetricMatrix(const std::array<T, n>& data) noexcept : data(data) {}
+    ///Reads the lower triangle, the upper one is assumed to mirror it
+    explicit constexpr SymmetricMatrix(const Matrix<N, N, T>& m) noexcept : data() {
+        for (size_t i = 0; i < N; i++) {
+            for (size_t j = 0; j <= i; j++) {
+                data[Index(i, j)] = m(i, j);
             }
+        }
+    }
 
-            // Skip the row if it's empty
-            if (cur_lead == size_t(m.cols)) { break; }
+    [[nodiscard]] static constexpr SymmetricMatrix Identity() noexcept {
+        SymmetricMatrix ret;
+        for (size_t i = 0; i < N; i++) {
+            ret.data[Index(i, i)] = 1;
+        }
+        return ret;
+    }
 
+    ///aᵀ * a, computing only the lower triangle
+    template <size_t rows2>
+    [[nodiscard]] static constexpr SymmetricMatrix Gram(const Matrix<rows2, N, T>& a) noexcept {
+        SymmetricMatrix ret;
+        ret.RankUpdate(a);
+        return ret;
+    }
 
-            // Divide current_row by lead for it to become 1
-            // Optimization: manually set lead to 1, ignore cells before lead
-            {
-                T lead_val = m(current_row, cur_lead);
-                if (lead_val != 1) {
-                    m(current_row, cur_lead) = 1;
-                    for (size_t j = cur_lead + 1; j < m.cols; j++) {
-                        m(current_row, j) /= lead_val;
-                    }
+    [[nodiscard]] static constexpr size_t Index(size_t row, size_t col) noexcept {
+        return row >= col ? row * (row + 1) / 2 + col : col * (col + 1) / 2 + row;
+    }
+
+    [[nodiscard]] constexpr T& operator()(size_t row, size_t col) noexcept { return data[Index(row, col)]; }
+    [[nodiscard]] constexpr T operator()(size_t row, size_t col) const noexcept { return data[Index(row, col)]; }
+
+    [[nodiscard]] constexpr Matrix<N, N, T> ToMatrix() const noexcept {
+        Matrix<N, N, T> ret;
+        for (size_t i = 0; i < N; i++) {
+            for (size_t j = 0; j <= i; j++) {
+                ret(i, j) = ret(j, i) = data[Index(i, j)];
+            }
+        }
+        return ret;
+    }
+
+    ///SYRK: this += alpha * aᵀ * a, half the flops of the full product.
+    ///Each row of `a` is one sample or Jacobian row
+    template <size_t rows2>
+    constexpr SymmetricMatrix& RankUpdate(const Matrix<rows2, N, T>& a, T alpha = 1) noexcept {
+        std::array<accum_t, n> sum {};
+        for (size_t k = 0; k < rows2; k++) {
+            // Unrolled rows have a constant length, so their loops vectorize at -O2
+            matrix_detail::For<N, (N <= 16)>([&](auto i) {
+                const accum_t aki = a(k, i);
+                const size_t row = i * (i + 1) / 2;
+                for (size_t j = 0; j <= i; j++) {
+                    sum[row + j] += aki * accum_t(a(k, j));
                 }
+            });
+        }
+        matrix_detail::For<n>([&](auto i) { data[i] += alpha * T(sum[i]); });
+        return *this;
+    }
+    ///this += alpha * x * xᵀ
+    constexpr SymmetricMatrix& RankUpdate(const Matrix<N, 1, T>& x, T alpha = 1) noexcept {
+        for (size_t i = 0, row = 0; i < N; row += ++i) {
+            const T axi = alpha * x[i];
+            for (size_t j = 0; j <= i; j++) {
+                data[row + j] += axi * x[j];
             }
+        }
+        return *this;
+    }
 
-            // Zero out current lead's column on all rows except current
-            // by subtracting `current_row * f` from it
-            for (size_t other_row = 0; other_row < m.rows; other_row++) {
-                if (other_row == current_row) { continue; }
-                // Skip if other lead is already zero
-                if (m(other_row, cur_lead) == 0) { continue; }
-                // Calculate f so that lead becomes zero
-                real_t f = 1.0 / m(current_row, cur_lead) * m(other_row, cur_lead);
-                // Subtract current_row from other_row
-                for (size_t j = 0; j < m.cols; j++) {
-                    m(other_row, j) -= m(current_row, j) * f;
+    constexpr SymmetricMatrix& operator+=(const SymmetricMatrix& other)& noexcept {
+        matrix_detail::For<n>([&](auto i) { data[i] += other.data[i]; });
+        return *this;
+    }
+    constexpr SymmetricMatrix& operator-=(const SymmetricMatrix& other)& noexcept {
+        matrix_detail::For<n>([&](auto i) { data[i] -= other.data[i]; });
+        return *this;
+    }
+    constexpr SymmetricMatrix& operator*=(const T other)& noexcept {
+        matrix_detail::For<n>([&](auto i) { data[i] *= other; });
+        return *this;
+    }
+    constexpr SymmetricMatrix& operator/=(const T other)& noexcept {
+        matrix_detail::For<n>([&](auto i) { data[i] /= other; });
+        return *this;
+    }
+    [[nodiscard]] constexpr SymmetricMatrix operator-() const noexcept {
+        SymmetricMatrix ret;
+        matrix_detail::For<n>([&](auto i) { ret.data[i] = -data[i]; });
+        return ret;
+    }
+    friend constexpr SymmetricMatrix operator+(SymmetricMatrix a, const SymmetricMatrix& b) noexcept { return a += b; }
+    friend constexpr SymmetricMatrix operator-(SymmetricMatrix a, const SymmetricMatrix& b) noexcept { return a -= b; }
+    friend constexpr SymmetricMatrix operator*(SymmetricMatrix a, const T& b) noexcept { return a *= b; }
+    friend constexpr SymmetricMatrix operator*(const T& b, SymmetricMatrix a) noexcept { return a *= b; }
+    friend constexpr SymmetricMatrix operator/(SymmetricMatrix a, const T& b) noexcept { return a /= b; }
+
+    ///this * b, reads every stored element once and applies it to both of its positions
+    template <size_t cols2, typename _T>
+    [[nodiscard]] constexpr Matrix<N, cols2, T> operator*(const Matrix<N, cols2, _T>& b) const noexcept {
+        Matrix<N, cols2, accum_t> sum;
+        for (size_t i = 0, row = 0; i < N; row += ++i) {
+            for (size_t j = 0; j < i; j++) {
+                const accum_t aij = data[row + j];
+                for (size_t c = 0; c < cols2; c++) {
+                    sum(i, c) += aij * accum_t(b(j, c));
+                    sum(j, c) += aij * accum_t(b(i, c));
                 }
             }
+            const accum_t aii = data[row + i];
+            for (size_t c = 0; c < cols2; c++) {
+                sum(i, c) += aii * accum_t(b(i, c));
+            }
+        }
+        return Matrix<N, cols2, T>(sum);
+    }
 
+    ///xᵀ * this * x, e.g. a squared Mahalanobis distance with an inverse covariance
+    [[nodiscard]] constexpr T QuadraticForm(const Matrix<N, 1, T>& x) const noexcept {
+        accum_t sum = 0;
+        for (size_t i = 0, row = 0; i < N; row += ++i) {
+            accum_t offDiagonal = 0;
+            for (size_t j = 0; j < i; j++) {
+                offDiagonal += accum_t(data[row + j]) * accum_t(x[j]);
+            }
+            sum += accum_t(x[i]) * (2 * offDiagonal + accum_t(data[row + i]) * accum_t(x[i]));
         }
+        return T(sum);
     }
 
-    friend std::ostream& operator<<(std::ostream& os, const Matrix<rows, cols, T>& m) {
-        static const auto len = [](const T a) {
-            std::stringstream ss;
-            ss << a;
-            return ss.str().size();
-        };
+    [[nodiscard]] constexpr real_t Trace() const noexcept {
+        real_t sum = 0;
+        matrix_detail::For<N>([&](auto i) { sum += data[Index(i, i)]; });
+        return sum;
+    }
 
-        if (rows * cols > 0) {
+    ///L * D * Lᵀ in place: unit lower triangular L below the diagonal, D on it.
+    ///N³/3 flops, no square roots. Works for positive definite and many indefinite
+    ///matrices; a zero pivot (singular leading minor) leaves inf or NaN
+    [[nodiscard]] constexpr SymmetricMatrix LDLT() const noexcept {
+        SymmetricMatrix f = *this;
+        std::array<accum_t, N> d {};
+        for (size_t j = 0, rowJ = 0; j < N; rowJ += ++j) {
+            accum_t dj = f.data[rowJ + j];
+            for (size_t k = 0; k < j; k++) {
+                dj -= accum_t(f.data[rowJ + k]) * accum_t(f.data[rowJ + k]) * d[k];
+            }
+            d[j] = dj;
+            f.data[rowJ + j] = T(dj);
+            for (size_t i = j + 1, rowI = rowJ + j + 1; i < N; rowI += ++i) {
+                accum_t v = f.data[rowI + j];
+                for (size_t k = 0; k < j; k++) {
+                    v -= accum_t(f.data[rowI + k]) * accum_t(f.data[rowJ + k]) * d[k];
+                }
+                f.data[rowI + j] = T(v / dj);
+            }
+        }
+        return f;
+    }
 
-            auto mlen = len(m.data[0]);
-            for (const auto& v : m.data) {
-                mlen = std::max(mlen, len(v));
+    ///x with this * x = b, through LDLᵀ: N³/3 + 2N² * cols2 flops instead of
+    ///Gauss-Jordan on [this | b]. See LDLT() for which matrices work
+    template <size_t cols2>
+    [[nodiscard]] constexpr Matrix<N, cols2, T> Solve(const Matrix<N, cols2, T>& b) const noexcept {
+        return SolveFactored(LDLT(), b);
+    }
+
+    [[nodiscard]] constexpr SymmetricMatrix Inverse() const noexcept {
+        return SymmetricMatrix(SolveFactored(LDLT(), Matrix<N, N, T>::Identity()));
+    }
+
+private:
+    template <size_t cols2>
+    [[nodiscard]] static constexpr Matrix<N, cols2, T> SolveFactored(const SymmetricMatrix& f, Matrix<N, cols2, T> x) noexcept {
+        // L * y = b
+        for (size_t i = 0; i < N; i++) {
+            for (size_t k = 0; k < i; k++) {
+                const T l = f.data[Index(i, k)];
+                for (size_t c = 0; c < cols2; c++) {
+                    x(i, c) -= l * x(k, c);
+                }
             }
-            for (size_t row = 0; row < rows; row++) {
-                os << '|';
-                for (size_t col = 0; col < cols - 1; col++) {
-                    os << std::setw(mlen) << m(row, col) << ' ';
+        }
+        // D * z = y
+        for (size_t i = 0; i < N; i++) {
+            const T d = f.data[Index(i, i)];
+            for (size_t c = 0; c < cols2; c++) {
+                x(i, c) /= d;
+            }
+        }
+        // Lᵀ * x = z
+        for (size_t i = N; i-- > 0;) {
+            for (size_t k = 0; k < i; k++) {
+                const T l = f.data[Index(i, k)];
+                for (size_t c = 0; c < cols2; c++) {
+                    x(k, c) -= l * x(i, c);
                 }
-                os << std::setw(mlen) << m(row, cols - 1) << '|' << std::endl;
             }
         }
-        return os;
+        return x;
     }
 };
+
+static_assert(std::is_trivially_copyable<SymmetricMatrix<4>>::value, "SymmetricMatrix must be trivially copyable");
+static_assert(sizeof(SymmetricMatrix<4>) == 10 * sizeof(float), "SymmetricMatrix must not have padding");
+
+///Contiguous matrices as a flat array of rows * cols elements each,
+///e.g. to upload std::vector<Matrix<4, 4>> into a GPU buffer without copying
+template <size_t rows, size_t cols, typename T>
+[[nodiscard]] inline T* ComponentData(Matrix<rows, cols, T>* m) noexcept { return m->data.data(); }
+template <size_t rows, size_t cols, typename T>
+[[nodiscard]] inline const T* ComponentData(const Matrix<rows, cols, T>* m) noexcept { return m->data.data(); }
+
+static_assert(std::is_trivially_copyable<Matrix<4, 4>>::value, "Matrix must be trivially copyable");
+static_assert(std::is_standard_layout<Matrix<4, 4>>::value, "Matrix must be standard layout");
+static_assert(sizeof(Matrix<3, 4>) == 12 * sizeof(float), "Matrix must not have padding");
+
+namespace matrix_chain {
+    // Classic O(n^3) matrix-chain dynamic programming,
+    // split[i][j] is the last multiplication of the product of matrices i..j
+    template <size_t count>
+    struct Plan {
+        std::array<std::array<size_t, count>, count> split {};
+        size_t cost = 0;
+    };
+
+    template <size_t count>
+    [[nodiscard]] constexpr Plan<count> Solve(const std::array<size_t, count + 1>& dims) noexcept {
+        Plan<count> plan;
+        std::array<std::array<size_t, count>, count> cost {};
+        for (size_t len = 2; len <= count; len++) {
+            for (size_t i = 0; i + len <= count; i++) {
+                const size_t j = i + len - 1;
+                cost[i][j] = std::numeric_limits<size_t>::max();
+                for (size_t k = i; k < j; k++) {
+                    const size_t c = cost[i][k] + cost[k + 1][j] + dims[i] * dims[k + 1] * dims[j + 1];
+                    if (c < cost[i][j]) {
+                        cost[i][j] = c;
+                        plan.split[i][j] = k;
+                    }
+                }
+            }
+        }
+        plan.cost = cost[0][count - 1];
+        return plan;
+    }
+
+    template <typename... Ms>
+    struct Chain {
+        static constexpr size_t count = sizeof...(Ms);
+        static constexpr std::array<size_t, count + 1> Dims() noexcept {
+            constexpr std::array<size_t, count> rows {std::decay_t<Ms>::rows...};
+            constexpr std::array<size_t, count> cols {std::decay_t<Ms>::cols...};
+            std::array<size_t, count + 1> dims {};
+            for (size_t i = 0; i < count; i++) {
+                dims[i] = rows[i];
+            }
+            dims[count] = cols[count - 1];
+            return dims;
+        }
+        static constexpr bool Compatible() noexcept {
+            constexpr std::array<size_t, count> rows {std::decay_t<Ms>::rows...};
+            constexpr std::array<size_t, count> cols {std::decay_t<Ms>::cols...};
+            for (size_t i = 0; i + 1 < count; i++) {
+                if (cols[i] != rows[i + 1]) { return false; }
+            }
+            return true;
+        }
+        static constexpr Plan<count> plan = Solve<count>(Dims());
+
+        template <size_t i, size_t j, typename Tuple>
+        [[nodiscard]] static constexpr decltype(auto) Eval(const Tuple& t) noexcept {
+            if constexpr (i == j) {
+                return std::get<i>(t);
+            } else {
+                constexpr size_t k = plan.split[i][j];
+                return Eval<i, k>(t) * Eval<k + 1, j>(t);
+            }
+        }
+    };
+}
+
+///Multiplies matrices in the cheapest order, chosen at compile time from the
+///static dimensions. `MultiplyChain(P, V, M, v)` with a 4x1 `v` does
+///P * (V * (M * v)): 3 matrix-vector products instead of 2 matrix-matrix ones.
+///Operands are taken by reference, only intermediate products are created.
+template <typename... Ms>
+[[nodiscard]] constexpr auto MultiplyChain(const Ms&... ms) noexcept {
+    static_assert(sizeof...(Ms) > 0, "MultiplyChain needs at least one matrix");
+    using chain = matrix_chain::Chain<Ms...>;
+    static_assert(chain::Compatible(), "Can't multiply matrices with incompatible dimensions");
+    return chain::template Eval<0, sizeof...(Ms) - 1>(std::forward_as_tuple(ms...));
+}
@@ -1,7 +1,19 @@
 #include "Matrix.h"
+#include <cmath>
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+namespace {
+    // Largest absolute difference between the elements of a and b
+    template <typename A, typename B>
+    double maxError(const A& a, const B& b) {
+        const auto diff = a - b;
+        double err = 0;
+        for (const auto e : diff) { err = std::max(err, std::abs(double(e))); }
+        return err;
+    }
+}
+
 TEST_CASE("[Matrix] ctors") {
     Matrix<2, 2> m ({
         1, 2,
@@ -19,6 +31,17 @@ TEST_CASE("[Matrix] ctors") {
     CHECK(m4.data == m.data);
 }
 
+TEST_CASE("[Matrix] trivially copyable") {
+    static_assert(std::is_trivially_copyable<Matrix<3, 5, double>>::value, "");
+    static_assert(std::is_standard_layout<Matrix<3, 5, double>>::value, "");
+    std::array<Matrix<2, 2>, 2> ms {Matrix<2, 2>({1, 2, 3, 4}), Matrix<2, 2>({5, 6, 7, 8})};
+    const float* f = ComponentData(ms.data());
+    CHECK(f[0] == 1);
+    CHECK(f[7] == 8);
+    ComponentData(ms.data())[4] = 10;
+    CHECK(ms[1](0, 0) == 10);
+}
+
 TEST_CASE("[Matrix] columns ctor") {
     Matrix<3, 1> a ({1, 2, 3});
     Matrix<3, 1> b ({4, 5, 6});
@@ -195,6 +218,17 @@ TEST_CASE("[Matrix] transpose") {
     });
     CHECK(m.Transposed().data == expected.data);
     CHECK(m.Transposed().Transposed().data == m.data);
+
+    const Matrix<2, 3> r ({
+        1, 2, 3,
+        4, 5, 6,
+    });
+    const Matrix<3, 2> rt ({
+        1, 4,
+        2, 5,
+        3, 6,
+    });
+    CHECK(r.Transposed().data == rt.data);
 }
 
 TEST_CASE("[Matrix] trace") {
@@ -284,6 +318,182 @@ TEST_CASE("[Matrix] inverse") {
     }
 }
 
+TEST_CASE("[Matrix] inverse updates") {
+    const Matrix<3, 3, double> a0 ({
+         7.0,  2.0,  1.0,
+         0.0,  4.0, -1.0,
+        -3.0,  4.0, -2.0,
+    });
+    const Matrix<3, 1, double> u ({1, -2, 0.5});
+    const Matrix<3, 1, double> v ({0.25, 1, 3});
+    {
+        Matrix<3, 3, double> aInv = a0.Inverse();
+        CHECK(InverseUpdateRank1(aInv, u, v));
+        CHECK(maxError(aInv, (a0 + MultiplyTransposed(u, v)).Inverse()) < 1e-12);
+    }
+    {
+        Matrix<3, 3, double> a = a0;
+        Matrix<3, 3, double> aInv = a0.Inverse();
+        CHECK(InverseUpdateRank1(a, aInv, u, v));
+        CHECK(maxError(a, a0 + MultiplyTransposed(u, v)) == 0);
+        CHECK(maxError(aInv, a.Inverse()) < 1e-12);
+    }
+    {
+        // Zeroes the first row and column of the identity: singular
+        const auto id = Matrix<3, 3, double>::Identity();
+        const Matrix<3, 1, double> e ({1, 0, 0});
+        Matrix<3, 3, double> aInv = id;
+        CHECK_FALSE(InverseUpdateRank1(aInv, -e, e));
+        CHECK(aInv.data == id.data);
+        Matrix<3, 3, double> a = id;
+        Matrix<3, 3, double> aInv2 = id;
+        CHECK_FALSE(InverseUpdateRank1(a, aInv2, -e, e));
+        CHECK(a(0, 0) == 0);
+    }
+    {
+        const Matrix<3, 2, double> uk ({
+            1,   0,
+            -2,  1,
+            0.5, 3,
+        });
+        const Matrix<3, 2, double> vk ({
+            0.25, -1,
+            1,     0,
+            3,     2,
+        });
+        Matrix<3, 3, double> a = a0;
+        Matrix<3, 3, double> aInv = a0.Inverse();
+        CHECK(InverseUpdateRankK(a, aInv, uk, vk));
+        CHECK(maxError(aInv, (a0 + MultiplyTransposed(uk, vk)).Inverse()) < 1e-12);
+
+        const auto id = Matrix<3, 3, double>::Identity();
+        const Matrix<3, 2, double> ek ({
+            1, 0,
+            0, 1,
+            0, 0,
+        });
+        Matrix<3, 3, double> aInv2 = id;
+        CHECK_FALSE(InverseUpdateRankK(aInv2, -ek, ek));
+        CHECK(aInv2.data == id.data);
+        Matrix<3, 3, double> b = id;
+        CHECK_FALSE(InverseUpdateRankK(b, aInv2, -ek, ek));
+    }
+}
+
+TEST_CASE("[Matrix] kernels above the unroll limit") {
+    Matrix<9, 8, int> a;
+    for (size_t i = 0; i < a.n; i++) { a[i] = int(i); }
+    const auto id = Matrix<8, 8, int>::Identity();
+    CHECK((a * id).data == a.data);
+    CHECK(a.Transposed()(7, 8) == a(8, 7));
+    CHECK(a.Transposed().Transposed().data == a.data);
+    CHECK((a + a).data == (a * 2).data);
+    CHECK((-a + a).data == Matrix<9, 8, int>().data);
+    CHECK(Matrix<9, 8>(a)[71] == 71.0f);
+    CHECK(Matrix<9, 9, int>::Identity().Trace() == 9);
+}
+
+TEST_CASE("[Matrix] symmetric") {
+    const Matrix<4, 3, double> a ({
+         1,  2, 0,
+        -1,  0, 3,
+         2,  1, 1,
+         0, -2, 4,
+    });
+    const auto ata = TransposedMultiply(a, a);
+    const auto s = SymmetricMatrix<3, double>::Gram(a);
+    CHECK(s.data.size() == 6);
+    CHECK(s.ToMatrix().data == ata.data);
+    CHECK(SymmetricMatrix<3, double>(ata).data == s.data);
+    CHECK(s(0, 2) == s(2, 0));
+    CHECK(s.Trace() == ata.Trace());
+
+    // Column overload and the row overload agree
+    SymmetricMatrix<3, double> cov;
+    for (size_t k = 0; k < 4; k++) {
+        cov.RankUpdate(a.Row(k).Transposed(), 0.5);
+    }
+    CHECK(maxError(cov.ToMatrix(), ata * 0.5) < 1e-12);
+    cov = SymmetricMatrix<3, double>::Identity();
+    cov.RankUpdate(a, -1);
+    CHECK(maxError(cov.ToMatrix(), Matrix<3, 3, double>::Identity() - ata) < 1e-12);
+
+    CHECK(maxError((s + s - s * 2.0 + -s / 2.0).ToMatrix(), (ata / -2.0)) < 1e-12);
+
+    const Matrix<3, 2, double> b ({
+        1,  0,
+        2, -1,
+        0,  3,
+    });
+    CHECK(maxError(s * b, ata * b) < 1e-12);
+    const Matrix<3, 1, double> x ({1, -2, 0.5});
+    CHECK(std::abs(s.QuadraticForm(x) - (x.Transposed() * ata * x)[0]) < 1e-12);
+
+    CHECK(maxError(s * s.Solve(b), b) < 1e-12);
+    CHECK(maxError(s.Inverse().ToMatrix(), ata.Inverse()) < 1e-12);
+    // Indefinite but with nonzero leading minors
+    const SymmetricMatrix<2, double> h ({1, 3, 2});
+    CHECK(maxError(h * h.Solve(x.Submatrix<2, 1>()), x.Submatrix<2, 1>()) < 1e-12);
+}
+
+TEST_CASE("[Matrix] power") {
+    const Matrix<3, 3, int> m ({
+        1,  2,  0,
+        0,  1, -1,
+        3,  0,  1,
+    });
+    Matrix<3, 3, int> expected = Matrix<3, 3, int>::Identity();
+    for (unsigned n = 0; n <= 10; n++) {
+        CHECK(m.Pow(n).data == expected.data);
+        expected = expected * m;
+    }
+    CHECK(m.Pow<0>().data == Matrix<3, 3, int>::Identity().data);
+    CHECK(m.Pow<1>().data == m.data);
+    CHECK(m.Pow<7>().data == m.Pow(7).data);
+    CHECK(m.Pow<10>().data == m.Pow(10).data);
+    static_assert(Matrix<2, 2, int>({1, 1, 1, 0}).Pow<10>()[1] == 55, "Fibonacci");
+}
+
+TEST_CASE("[Matrix] exponential") {
+    CHECK(Matrix<3, 3, double>().Exp().data == Matrix<3, 3, double>::Identity().data);
+    {
+        // Nilpotent, the series is exact
+        const Matrix<2, 2, double> m ({
+            0, 1,
+            0, 0,
+        });
+        CHECK(maxError(m.Exp(), Matrix<2, 2, double>({1, 1, 0, 1})) < 1e-15);
+    }
+    {
+        const Matrix<3, 3, double> m ({
+            1,  0,  0,
+            0, -2,  0,
+            0,  0,  5,
+        });
+        const Matrix<3, 3, double> expected ({
+            std::exp(1.0), 0,              0,
+            0,             std::exp(-2.0), 0,
+            0,             0,              std::exp(5.0),
+        });
+        CHECK(maxError(m.Exp(), expected) < 1e-12);
+    }
+    {
+        // Rotation generator, large enough to need squaring
+        const double t = 10;
+        const Matrix<2, 2, double> m ({
+            0, -t,
+            t,  0,
+        });
+        const Matrix<2, 2, double> expected ({
+            std::cos(t), -std::sin(t),
+            std::sin(t),  std::cos(t),
+        });
+        CHECK(maxError(m.Exp(), expected) < 1e-12);
+        const Matrix<2, 2> mf (m);
+        CHECK(maxError(mf.Exp(), Matrix<2, 2>(expected)) < 1e-4);
+    }
+}
+
 TEST_CASE("[Matrix] static zero") {
     const auto m = Matrix<5, 6>::Zero();
     const auto isZero = [](auto e){ return e == 0; };
@@ -302,3 +512,142 @@ TEST_CASE("[Matrix] identity") {
     m[0] = 1;
     CHECK(m.data == expected.data);
 }
+
+TEST_CASE("[Matrix] multiply chain") {
+    const Matrix<3, 2> a ({
+        1, 2,
+        3, 4,
+        5, 6,
+    });
+    const Matrix<2, 5> b ({
+        10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19,
+    });
+    const Matrix<5, 1> c ({1, 0, 2, 0, 1});
+    CHECK( MultiplyChain(a).data == a.data );
+    CHECK( MultiplyChain(a, b).data == (a * b).data );
+    CHECK( MultiplyChain(a, b, c).data == ((a * b) * c).data );
+
+    // (a * b) * c costs 3*2*5 + 3*5*1 = 45, a * (b * c) costs 2*5*1 + 3*2*1 = 16
+    using chain = matrix_chain::Chain<Matrix<3, 2>, Matrix<2, 5>, Matrix<5, 1>>;
+    static_assert(chain::plan.split[0][2] == 0, "Expected a * (b * c)");
+    static_assert(chain::plan.cost == 16, "Expected 16 multiplications");
+
+    // 100x4 * 4x100 * 100x1: right to left is 40 times cheaper
+    using chain2 = matrix_chain::Chain<Matrix<100, 4>, Matrix<4, 100>, Matrix<100, 1>>;
+    static_assert(chain2::plan.cost == 4 * 100 + 100 * 4, "Expected right to left order");
+
+    constexpr Matrix<2, 2> p ({1, 2, 3, 4});
+    constexpr auto r = MultiplyChain(p, p, p);
+    static_assert(r[0] == 37 && r[3] == 118, "MultiplyChain must be constexpr");
+}
+
+TEST_CASE("[Matrix] views") {
+    Matrix<3, 4> m ({
+        1,  2,  3,  4,
+        5,  6,  7,  8,
+        9,  10, 11, 12,
+    });
+    const Matrix<3, 4>& c = m;
+    CHECK(c.TransposedView().ToMatrix().data == m.Transposed().data);
+    CHECK(c.TransposedView().TransposedView().ToMatrix().data == m.data);
+    CHECK(c.RowView(1).ToMatrix().data == m.Row(1).data);
+    CHECK(c.ColumnView(2).ToMatrix().data == m.Column(2).data);
+    CHECK((c.SubmatrixView<2, 2>(1, 2).ToMatrix().data == std::array<float, 4>({7, 8, 11, 12})));
+    CHECK(c.SubmatrixView<3, 4>().ToMatrix().data == m.data);
+
+    m.ColumnView(0) *= 2;
+    CHECK(m(2, 0) == 18);
+    m.RowView(0) += Matrix<1, 4>({1, 1, 1, 1});
+    CHECK(m(0, 3) == 5);
+    m.SubmatrixView<1, 2>(2, 2) -= Matrix<1, 2>({11, 12});
+    CHECK(m(2, 2) == 0);
+    CHECK(m(2, 3) == 0);
+    m.RowView(1) /= 5;
+    CHECK(m(1, 0) == 2);
+
+    Matrix<2, 2> acc;
+    acc += c.SubmatrixView<2, 2>();
+    acc -= c.SubmatrixView<2, 2>();
+    CHECK(acc.data == Matrix<2, 2>::Zero().data);
+
+    // Views of the matrix being updated
+    const Matrix<3, 3> s ({
+        1, 2, 3,
+        4, 5, 6,
+        7, 8, 9,
+    });
+    Matrix<3, 3> sym = s;
+    sym += sym.TransposedView();
+    CHECK(sym.data == (s + s.Transposed()).data);
+    sym -= sym.TransposedView();
+    CHECK(sym.data == Matrix<3, 3>::Zero().data);
+    Matrix<3, 3> viewed = s;
+    viewed.TransposedView() += viewed;
+    CHECK(viewed.data == (s + s.Transposed()).data);
+    viewed.TransposedView() -= viewed;
+    CHECK(viewed.data == Matrix<3, 3>::Zero().data);
+}
+
+TEST_CASE("[Matrix] view multiplication") {
+    const Matrix<3, 2> a ({
+        1, 2,
+        3, 4,
+        5, 6,
+    });
+    const Matrix<3, 5> b ({
+        10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19,
+        20, 21, 22, 23, 24,
+    });
+    const auto atb = a.Transposed() * b;
+    CHECK( (a.TransposedView() * b).data == atb.data );
+    CHECK( (a.TransposedView() * b.SubmatrixView<3, 5>()).data == atb.data );
+    CHECK( (a.Transposed() * b.SubmatrixView<3, 5>()).data == atb.data );
+    CHECK( TransposedMultiply(a, b).data == atb.data );
+
+    const Matrix<4, 2> d ({
+        1, 0,
+        0, 1,
+        1, 1,
+        2, 3,
+    });
+    const auto adt = a * d.Transposed();
+    CHECK( MultiplyTransposed(a, d).data == adt.data );
+    CHECK( (a * d.TransposedView()).data == adt.data );
+}
+
+TEST_CASE("[Matrix] mixed precision multiplication") {
+    // Sums in double, truncating b to float first would cancel to 0
+    const Matrix<1, 2, float> a ({1, -1});
+    const Matrix<2, 1, double> b ({1 + 1e-9, 1});
+    const auto near = [](float x) { return std::abs(x - 1e-9f) < 1e-15f; };
+    CHECK( near((a * b)[0]) );
+    CHECK( near((a * b.SubmatrixView<2, 1>())[0]) );
+    CHECK( near(TransposedMultiply(a.Transposed(), b)[0]) );
+}
+
+TEST_CASE("[Matrix] view solvers") {
+    const auto abs_cmp = [](auto a, auto b) {
+        return std::abs(a) < std::abs(b);
+    };
+    Matrix<4, 4> m ({
+         7.0,  2.0,  1.0, 99.0,
+         0.0,  4.0, -1.0, 99.0,
+        -3.0,  4.0, -2.0, 99.0,
+        99.0, 99.0, 99.0, 99.0,
+    });
+    const Matrix<3, 3> expected ({
+         0.4, -0.8,  0.6,
+        -0.3,  1.1, -0.7,
+        -1.2,  3.4, -2.8,
+    });
+    const auto res = m.SubmatrixView<3, 3>().Inverse() - expected;
+    CHECK( *std::max_element(res.begin(), res.end(), abs_cmp) < 0.000001f );
+
+    m.SubmatrixView<3, 3>().Gauss();
+    const auto id = m.Submatrix<3, 3>() - Matrix<3, 3>::Identity();
+    CHECK( *std::max_element(id.begin(), id.end(), abs_cmp) < 0.000001f );
+    CHECK( m(0, 3) == 99 );
+    CHECK( m(3, 0) == 99 );
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+    namespace detail {
+        // Threads started once, on first use, and kept until exit.
+        // Threads waiting for their own job run queued chunks of any job
+        // meanwhile, so ParallelFor() may be nested without deadlocks
+        class Pool {
+        public:
+            static Pool& Instance() {
+                static Pool pool;
+                return pool;
+            }
+
+            Pool(const Pool&) = delete;
+            Pool& operator=(const Pool&) = delete;
+
+            ~Pool() {
+                {
+                    const std::lock_guard<std::mutex> lock (mutex);
+                    stop = true;
+                }
+                wake.notify_all();
+                for (auto& t : workers) {
+                    t.join();
+                }
+            }
+
+            // Calls task(i) for every i in [0, count) and returns when all calls are done.
+            // The calling thread runs chunks too
+            template <typename F>
+            void Run(size_t count, F& task) {
+                Job job {[](void* context, size_t i) { (*static_cast<F*>(context))(i); }, &task, count};
+                std::unique_lock<std::mutex> lock (mutex);
+                jobs.push_back(&job);
+                wake.notify_all();
+                while (job.done != job.count) {
+                    if (!RunQueued(lock)) {
+                        wake.wait(lock);
+                    }
+                }
+            }
+
+        private:
+            struct Job {
+                void (*call)(void*, size_t);
+                void* context;
+                size_t count;
+                // Guarded by the mutex. A job leaves the queue once every index
+                // is claimed and must not be touched after its last index is done
+                size_t next = 0;
+                size_t done = 0;
+            };
+
+            Pool() {
+                const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+                workers.reserve(threads - 1);
+                for (size_t i = 1; i < threads; i++) {
+                    workers.emplace_back([this] { Work(); });
+                }
+            }
+
+            // Runs one chunk of the oldest job with the lock released, false if there are none
+            bool RunQueued(std::unique_lock<std::mutex>& lock) {
+                if (jobs.empty()) { return false; }
+                Job& job = *jobs.front();
+                const size_t i = job.next++;
+                if (job.next == job.count) {
+                    jobs.pop_front();
+                }
+                lock.unlock();
+                job.call(job.context, i);
+                lock.lock();
+                if (++job.done == job.count) {
+                    wake.notify_all();
+                }
+                return true;
+            }
+
+            void Work() {
+                std::unique_lock<std::mutex> lock (mutex);
+                while (!stop) {
+                    if (!RunQueued(lock)) {
+                        wake.wait(lock);
+                    }
+                }
+            }
+
+            std::mutex mutex;
+            // New jobs and finished jobs
+            std::condition_variable wake;
+            std::deque<Job*> jobs;
+            std::vector<std::thread> workers;
+            bool stop = false;
+        };
+    }
+}
+
+///Splits [0, count) into contiguous chunks of at least `minChunk` items
+///and calls `f(begin, end)` for each chunk, in parallel.
+///The calling thread processes chunks itself, the others run on a pool of
+///std::thread::hardware_concurrency() - 1 threads started on first use.
+///`threads == 0` uses up to std::thread::hardware_concurrency() chunks.
+template <typename F>
+void ParallelFor(size_t count, size_t minChunk, F&& f, size_t threads = 0) {
+    if (count == 0) { return; }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    minChunk = std::max<size_t>(minChunk, 1);
+    const size_t chunks = std::min(threads, (count + minChunk - 1) / minChunk);
+    if (chunks <= 1) {
+        f(size_t(0), count);
+        return;
+    }
+    const size_t perChunk = (count + chunks - 1) / chunks;
+    auto task = [&f, count, perChunk](size_t i) {
+        f(i * perChunk, std::min(count, (i + 1) * perChunk));
+    };
+    parallel::detail::Pool::Instance().Run((count + perChunk - 1) / perChunk, task);
+}
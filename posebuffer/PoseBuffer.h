@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+///Hands an array of poses from one writer thread to one reader thread without locks.
+///Triple buffer: the writer fills its back slot and swaps it with the shared
+///middle slot, the reader swaps its front slot with the middle one when that is newer.
+///Only entries changed since a slot was last published are copied into it.
+///T must be trivially copyable: Matrix<4, 4>, Vector3, Quaternion or a struct of them.
+template <typename T>
+class PoseBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "PoseBuffer elements must be trivially copyable");
+
+public:
+    PoseBuffer(size_t count, const T& initial)
+        : current(count, initial), dirty(Words(count)) {
+        for (size_t s = 0; s < 3; s++) {
+            slots[s].data.assign(count, initial);
+            stale[s].assign(Words(count), 0);
+        }
+    }
+
+    // Slots are referenced by index, moving would break the reader
+    PoseBuffer(const PoseBuffer&) = delete;
+    PoseBuffer& operator=(const PoseBuffer&) = delete;
+
+    [[nodiscard]] size_t Size() const { return current.size(); }
+
+    ///Writer thread: changes entry `i` of the next snapshot
+    void Set(size_t i, const T& value) {
+        current[i] = value;
+        dirty[i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    ///Writer thread: entry `i` of the next snapshot to modify in place
+    [[nodiscard]] T& Edit(size_t i) {
+        dirty[i / 64] |= uint64_t(1) << (i % 64);
+        return current[i];
+    }
+
+    ///Writer thread: latest value of entry `i`, published or not
+    [[nodiscard]] const T& Get(size_t i) const { return current[i]; }
+
+    ///Writer thread: makes everything Set() so far visible to the reader.
+    ///Wait-free, copies only the entries the back slot is missing
+    void Publish() {
+        // Every slot misses what changed since the last Publish()
+        for (size_t w = 0; w < dirty.size(); w++) {
+            if (const uint64_t bits = dirty[w]) {
+                stale[0][w] |= bits;
+                stale[1][w] |= bits;
+                stale[2][w] |= bits;
+                dirty[w] = 0;
+            }
+        }
+        Slot& slot = slots[back];
+        std::vector<uint64_t>& missing = stale[back];
+        for (size_t w = 0; w < missing.size(); w++) {
+            uint64_t bits = missing[w];
+            if (bits == 0) { continue; }
+            missing[w] = 0;
+            const size_t base = w * 64;
+            if (bits == ~uint64_t(0)) {
+                std::copy(current.begin() + base, current.begin() + base + 64, slot.data.begin() + base);
+                continue;
+            }
+            for (; bits != 0; bits &= bits - 1) {
+                const size_t i = base + std::countr_zero(bits);
+                slot.data[i] = current[i];
+            }
+        }
+        slot.version = ++published;
+        back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index;
+    }
+
+    ///Reader thread: switches to the latest published snapshot.
+    ///Lock-free, returns false if nothing was published since the last call
+    bool Acquire() {
+        if ((middle.load(std::memory_order_relaxed) & fresh) == 0) { return false; }
+        front = middle.exchange(front, std::memory_order_acq_rel) & index;
+        return true;
+    }
+
+    ///Reader thread: the acquired snapshot, valid until the next Acquire()
+    [[nodiscard]] std::span<const T> Snapshot() const { return slots[front].data; }
+
+    ///Reader thread: number of Publish() calls the acquired snapshot includes
+    [[nodiscard]] uint64_t Version() const { return slots[front].version; }
+
+private:
+    static constexpr uint8_t index = 3;
+    static constexpr uint8_t fresh = 4;
+
+    static constexpr size_t Words(size_t count) { return (count + 63) / 64; }
+
+    struct Slot {
+        std::vector<T> data;
+        uint64_t version = 0;
+    };
+
+    // Writer only
+    std::vector<T> current;
+    std::vector<uint64_t> dirty;
+    std::array<std::vector<uint64_t>, 3> stale;
+    uint64_t published = 0;
+    uint8_t back = 0;
+
+    std::array<Slot, 3> slots;
+
+    // Shared, kept off the cache lines of either side
+    alignas(64) std::atomic<uint8_t> middle {1};
+
+    // Reader only
+    alignas(64) uint8_t front = 2;
+};
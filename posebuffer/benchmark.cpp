@@ -0,0 +1,119 @@
+// Simulation-to-render hand-off of Matrix<4, 4> poses: PoseBuffer against
+// copying the whole array under a mutex. One writer and one reader thread
+// run for a fixed time; the writer changes a fraction of the poses per tick,
+// the reader sums one element of every pose of each new snapshot.
+// Worst is the longest writer tick: with the mutex it includes waiting for the reader.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Matrix.h"
+#include "PoseBuffer.h"
+
+namespace {
+    constexpr size_t count = 10000;
+    constexpr auto duration = std::chrono::milliseconds(500);
+
+    struct Result {
+        double ticks;   // writer, per second
+        double frames;  // reader, new snapshots per second
+        double worst;   // writer, longest tick in microseconds
+    };
+
+    // Writer ticks touch `changed` poses starting at a random offset
+    std::vector<size_t> MakeOffsets(size_t changed) {
+        std::mt19937 rng {42};
+        std::uniform_int_distribution<size_t> dist {0, count - changed};
+        std::vector<size_t> offsets (1024);
+        for (size_t& o : offsets) {
+            o = dist(rng);
+        }
+        return offsets;
+    }
+
+    template <typename Write, typename Read>
+    Result Run(Write&& write, Read&& read) {
+        std::atomic<bool> stop {false};
+        size_t ticks = 0, frames = 0;
+        double worst = 0;
+        float sink = 0;
+        std::thread reader ([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                frames += read(sink);
+            }
+        });
+        const auto start = std::chrono::steady_clock::now();
+        for (auto now = start; now - start < duration; ticks++) {
+            write(ticks);
+            const auto end = std::chrono::steady_clock::now();
+            worst = std::max(worst, std::chrono::duration<double, std::micro>(end - now).count());
+            now = end;
+        }
+        stop = true;
+        reader.join();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sink == 1234.5f) { std::printf(" "); }
+        return {ticks / seconds, frames / seconds, worst};
+    }
+
+    Result Mutex(size_t changed) {
+        const std::vector<size_t> offsets = MakeOffsets(changed);
+        std::vector<Matrix<4, 4>> simulation (count, Matrix<4, 4>::Identity());
+        std::vector<Matrix<4, 4>> shared = simulation, render = simulation;
+        std::mutex mutex;
+        size_t sharedTick = 0, renderTick = 0;
+        return Run([&](size_t tick) {
+            const size_t offset = offsets[tick % offsets.size()];
+            for (size_t i = offset; i < offset + changed; i++) {
+                simulation[i][3] = float(tick);
+            }
+            const std::lock_guard<std::mutex> lock (mutex);
+            shared = simulation;
+            sharedTick = tick + 1;
+        }, [&](float& sink) {
+            {
+                const std::lock_guard<std::mutex> lock (mutex);
+                if (sharedTick == renderTick) { return false; }
+                render = shared;
+                renderTick = sharedTick;
+            }
+            for (const Matrix<4, 4>& m : render) {
+                sink += m[3];
+            }
+            return true;
+        });
+    }
+
+    Result Triple(size_t changed) {
+        const std::vector<size_t> offsets = MakeOffsets(changed);
+        PoseBuffer<Matrix<4, 4>> buffer (count, Matrix<4, 4>::Identity());
+        return Run([&](size_t tick) {
+            const size_t offset = offsets[tick % offsets.size()];
+            for (size_t i = offset; i < offset + changed; i++) {
+                buffer.Edit(i)[3] = float(tick);
+            }
+            buffer.Publish();
+        }, [&](float& sink) {
+            if (!buffer.Acquire()) { return false; }
+            for (const Matrix<4, 4>& m : buffer.Snapshot()) {
+                sink += m[3];
+            }
+            return true;
+        });
+    }
+}
+
+int main() {
+    std::printf("%zu poses of Matrix<4, 4>, %u hardware threads\n", count, std::thread::hardware_concurrency());
+    std::printf("changed    mutex ticks/s  frames/s  worst us    PoseBuffer ticks/s  frames/s  worst us\n");
+    for (const size_t changed : {size_t(10), size_t(100), size_t(1000), count}) {
+        const Result m = Mutex(changed);
+        const Result t = Triple(changed);
+        std::printf("%7zu %16.0f %9.0f %9.0f %21.0f %9.0f %9.0f\n", changed,
+                    m.ticks, m.frames, m.worst, t.ticks, t.frames, t.worst);
+    }
+}
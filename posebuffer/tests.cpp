@@ -0,0 +1,173 @@
+#include "PoseBuffer.h"
+#include "Matrix.h"
+#include <random>
+#include <thread>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    // Entry value and the tick that wrote it
+    struct Pose {
+        int value;
+        int tick;
+
+        bool operator==(const Pose&) const = default;
+    };
+
+    // Writer side of a PoseBuffer with a copy of every published state,
+    // which Snapshot() must equal for the acquired Version()
+    struct Model {
+        PoseBuffer<Pose> buffer;
+        std::vector<Pose> current;
+        std::vector<std::vector<Pose>> published;
+        int tick = 0;
+
+        explicit Model(size_t count) : buffer(count, Pose {-1, -1}), current(count, Pose {-1, -1}), published {current} {}
+
+        void Set(size_t i, int value) {
+            if (i % 2 == 0) {
+                buffer.Set(i, Pose {value, tick});
+            } else {
+                buffer.Edit(i) = Pose {value, tick};
+            }
+            current[i] = Pose {value, tick};
+            CHECK(buffer.Get(i) == current[i]);
+        }
+
+        void Publish() {
+            buffer.Publish();
+            published.push_back(current);
+            tick++;
+        }
+
+        // Acquires and checks the snapshot, returns whether there was a new one
+        bool Acquire() {
+            const uint64_t previous = buffer.Version();
+            const bool acquired = buffer.Acquire();
+            // Always the latest, however many publishes were skipped
+            CHECK(buffer.Version() == published.size() - 1);
+            CHECK(acquired == (buffer.Version() != previous));
+            const std::span<const Pose> snapshot = buffer.Snapshot();
+            REQUIRE(snapshot.size() == current.size());
+            CHECK(std::equal(snapshot.begin(), snapshot.end(), published[buffer.Version()].begin()));
+            return acquired;
+        }
+    };
+}
+
+TEST_CASE("[PoseBuffer] interleaved Set, Publish and Acquire") {
+    for (const size_t count : {size_t(1), size_t(63), size_t(150), size_t(192)}) {
+        Model m (count);
+        // Nothing published yet: the initial values, version 0
+        CHECK(!m.buffer.Acquire());
+        CHECK(m.buffer.Version() == 0);
+        CHECK(m.buffer.Snapshot()[count - 1] == (Pose {-1, -1}));
+
+        std::mt19937 rng {uint32_t(count)};
+        std::uniform_int_distribution<size_t> entry (0, count - 1);
+        for (int step = 0; step < 2000; step++) {
+            const uint32_t action = rng() % 8;
+            if (action < 4) {
+                for (uint32_t k = rng() % 5; k-- > 0;) {
+                    m.Set(entry(rng), int(rng() % 1000));
+                }
+            } else if (action == 4) {
+                // A whole word, so its dirty bits are exactly full
+                const size_t word = entry(rng) / 64;
+                for (size_t i = word * 64; i < std::min(count, word * 64 + 64); i++) {
+                    m.Set(i, int(i) + m.tick);
+                }
+            } else if (action < 7) {
+                m.Publish();
+            } else {
+                m.Acquire();
+            }
+        }
+        m.Publish();
+        CHECK(m.Acquire());
+        CHECK(!m.Acquire());
+    }
+}
+
+TEST_CASE("[PoseBuffer] skipped publishes") {
+    Model m (130);
+    for (size_t i = 0; i < 130; i++) {
+        m.Set(i, int(i));
+    }
+    m.Publish();
+    CHECK(m.Acquire());
+    CHECK(m.buffer.Version() == 1);
+    CHECK(!m.Acquire());
+    CHECK(m.buffer.Version() == 1);
+
+    // Changes spread over several publishes the reader never saw,
+    // all in the slot it gets next
+    m.Set(0, 100);
+    m.Publish();
+    m.Set(129, 200);
+    m.Publish();
+    m.Publish();
+    m.Set(64, 300);
+    m.Set(0, 101);
+    m.Publish();
+    CHECK(m.Acquire());
+    CHECK(m.buffer.Version() == 5);
+    CHECK(m.buffer.Snapshot()[0].value == 101);
+    CHECK(m.buffer.Snapshot()[64].value == 300);
+    CHECK(m.buffer.Snapshot()[129].value == 200);
+    CHECK(m.buffer.Snapshot()[1].value == 1);
+
+    // Every entry, the two full words and the partial third one
+    for (size_t i = 0; i < 130; i++) {
+        m.Set(i, -int(i));
+    }
+    m.Publish();
+    m.Publish();
+    CHECK(m.Acquire());
+    CHECK(m.buffer.Version() == 7);
+}
+
+TEST_CASE("[PoseBuffer] writer and reader threads") {
+    // Tick t writes entry j with j % 7 == t % 7, so the acquired snapshot
+    // tells which publishes it contains
+    const size_t count = 200;
+    const int ticks = 20000;
+    PoseBuffer<Matrix<4, 4>> buffer (count, Matrix<4, 4>::Zero());
+    bool ordered = true, consistent = true;
+    std::thread reader ([&] {
+        uint64_t last = 0;
+        while (last < uint64_t(ticks)) {
+            if (!buffer.Acquire()) {
+                std::this_thread::yield();
+                continue;
+            }
+            const uint64_t version = buffer.Version();
+            ordered = ordered && version > last;
+            last = version;
+            const std::span<const Matrix<4, 4>> snapshot = buffer.Snapshot();
+            for (size_t j = 0; j < count; j++) {
+                // Latest tick below `version` that wrote j, 0 if none did
+                float expected = 0;
+                for (uint64_t t = version; t-- > 0 && t + 7 >= version;) {
+                    if (t % 7 == j % 7) {
+                        expected = float(t + 1);
+                        break;
+                    }
+                }
+                consistent = consistent && snapshot[j](0, 0) == expected && snapshot[j](3, 3) == expected;
+            }
+        }
+    });
+    for (int t = 0; t < ticks; t++) {
+        for (size_t j = size_t(t) % 7; j < count; j += 7) {
+            Matrix<4, 4>& m = buffer.Edit(j);
+            m(0, 0) = float(t + 1);
+            m(3, 3) = float(t + 1);
+        }
+        buffer.Publish();
+    }
+    reader.join();
+    CHECK(ordered);
+    CHECK(consistent);
+}
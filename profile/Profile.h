@@ -0,0 +1,290 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Operation counters for Matrix.h, Vector.h and Quaternion.h.
+// Compiled in only when MATRIX_PROFILE is defined before including them,
+// otherwise the hooks expand to nothing.
+//
+// Each thread counts into its own table of relaxed atomics, so counting
+// never contends. A thread's table is folded into a shared one when the
+// thread exits, so Snapshot() still includes its counts and memory doesn't
+// grow with the number of threads ever started.
+
+namespace matrix_profile {
+    enum Op : uint8_t {
+        Multiply,      // Matrix * Matrix and products of views
+        Inverse,       // Matrix::Inverse(), includes its Gauss call
+        Gauss,         // Gauss-Jordan elimination
+        Rotate,        // QuaternionT::Rotate, Vector3T::Rotate
+        OpCount,
+    };
+
+    [[nodiscard]] inline const char* OpName(Op op) {
+        switch (op) {
+            case Multiply: return "Multiply";
+            case Inverse:  return "Inverse";
+            case Gauss:    return "Gauss";
+            case Rotate:   return "Rotate";
+            case OpCount:  break;
+        }
+        return "other";
+    }
+
+    struct Entry {
+        Op op;
+        uint32_t rows;
+        uint32_t cols;
+        uint64_t calls;
+        uint64_t flops;
+        uint64_t samples;  // Calls that were timed
+        uint64_t cycles;   // Sum over timed calls
+    };
+
+    namespace detail {
+        constexpr size_t tableSize = 256;
+
+        struct Slot {
+            // 0 = empty, written once by the owning thread
+            std::atomic<uint64_t> key {0};
+            std::atomic<uint64_t> calls {0};
+            std::atomic<uint64_t> flops {0};
+            std::atomic<uint64_t> samples {0};
+            std::atomic<uint64_t> cycles {0};
+        };
+
+        [[nodiscard]] inline uint64_t MakeKey(Op op, size_t rows, size_t cols) {
+            return (uint64_t(op) << 48 | uint64_t(rows & 0xFFFFFF) << 24 | uint64_t(cols & 0xFFFFFF)) + 1;
+        }
+
+        struct Table {
+            std::array<Slot, tableSize> slots;
+            // Operations and sizes that didn't fit in the table, reported as "other"
+            Slot overflow;
+
+            Table() { overflow.key.store(MakeKey(OpCount, 0, 0), std::memory_order_relaxed); }
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            // Tables of running threads
+            std::vector<Table*> tables;
+            // Counts of threads that exited, only touched under the mutex
+            Table retired;
+            std::atomic<uint32_t> sampleInterval {0};
+        };
+
+        inline Registry& GetRegistry() {
+            static Registry registry;
+            return registry;
+        }
+
+        [[nodiscard]] inline Slot& Find(Table& t, uint64_t key) {
+            size_t h = size_t(key * 0x9E3779B97F4A7C15ull >> 56) % tableSize;
+            for (size_t i = 0; i < tableSize; i++, h = (h + 1) % tableSize) {
+                Slot& s = t.slots[h];
+                const uint64_t k = s.key.load(std::memory_order_relaxed);
+                if (k == key) { return s; }
+                if (k == 0) {
+                    // Only the owning thread inserts, readers see the key after the zeroed counters
+                    s.key.store(key, std::memory_order_release);
+                    return s;
+                }
+            }
+            return t.overflow;
+        }
+
+        inline void Clear(Slot& s) {
+            s.calls.store(0, std::memory_order_relaxed);
+            s.flops.store(0, std::memory_order_relaxed);
+            s.samples.store(0, std::memory_order_relaxed);
+            s.cycles.store(0, std::memory_order_relaxed);
+        }
+
+        inline void Add(Slot& to, const Slot& from) {
+            to.calls.fetch_add(from.calls.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            to.flops.fetch_add(from.flops.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            to.samples.fetch_add(from.samples.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            to.cycles.fetch_add(from.cycles.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        // Registers the thread's table on first use, folds it into
+        // Registry::retired when the thread exits
+        class LocalTableOwner {
+        public:
+            LocalTableOwner() : table(std::make_unique<Table>()) {
+                Registry& r = GetRegistry();
+                std::lock_guard<std::mutex> lock (r.mutex);
+                r.tables.push_back(table.get());
+            }
+
+            LocalTableOwner(const LocalTableOwner&) = delete;
+            LocalTableOwner& operator=(const LocalTableOwner&) = delete;
+
+            ~LocalTableOwner() {
+                Registry& r = GetRegistry();
+                std::lock_guard<std::mutex> lock (r.mutex);
+                for (const Slot& s : table->slots) {
+                    const uint64_t key = s.key.load(std::memory_order_relaxed);
+                    if (key != 0) {
+                        Add(Find(r.retired, key), s);
+                    }
+                }
+                Add(r.retired.overflow, table->overflow);
+                r.tables.erase(std::find(r.tables.begin(), r.tables.end(), table.get()));
+            }
+
+            Table& Get() { return *table; }
+
+        private:
+            std::unique_ptr<Table> table;
+        };
+
+        inline Table& LocalTable() {
+            thread_local LocalTableOwner owner;
+            return owner.Get();
+        }
+
+        [[nodiscard]] inline uint64_t Cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        inline uint64_t BeginRuntime() {
+            const uint32_t interval = GetRegistry().sampleInterval.load(std::memory_order_relaxed);
+            if (interval == 0) { return 0; }
+            thread_local uint32_t tick = 0;
+            if (++tick < interval) { return 0; }
+            tick = 0;
+            return Cycles();
+        }
+
+        inline void EndRuntime(Op op, size_t rows, size_t cols, uint64_t flops, uint64_t start) {
+            Slot& s = Find(LocalTable(), MakeKey(op, rows, cols));
+            s.calls.fetch_add(1, std::memory_order_relaxed);
+            s.flops.fetch_add(flops, std::memory_order_relaxed);
+            if (start != 0) {
+                s.samples.fetch_add(1, std::memory_order_relaxed);
+                s.cycles.fetch_add(Cycles() - start, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    ///Time every `interval`-th call per thread with the cycle counter
+    ///(rdtsc on x86, steady_clock ticks elsewhere). 0 disables timing.
+    inline void SetSampleInterval(uint32_t interval) {
+        detail::GetRegistry().sampleInterval.store(interval, std::memory_order_relaxed);
+    }
+
+    // Hooks, skipped during constant evaluation so the library stays constexpr
+
+    [[nodiscard]] constexpr uint64_t Begin() {
+        if (__builtin_is_constant_evaluated()) { return 0; }
+        return detail::BeginRuntime();
+    }
+
+    constexpr void End(Op op, size_t rows, size_t cols, uint64_t flops, uint64_t start) {
+        if (__builtin_is_constant_evaluated()) { return; }
+        detail::EndRuntime(op, rows, cols, flops, start);
+    }
+
+    ///Counters of all threads summed per operation and size, sorted by flops
+    [[nodiscard]] inline std::vector<Entry> Snapshot() {
+        detail::Registry& r = detail::GetRegistry();
+        std::vector<Entry> ret;
+        const auto add = [&ret](const detail::Slot& s) {
+            const uint64_t key = s.key.load(std::memory_order_acquire);
+            if (key == 0) { return; }
+            const Op op = Op((key - 1) >> 48);
+            const uint32_t rows = uint32_t((key - 1) >> 24 & 0xFFFFFF);
+            const uint32_t cols = uint32_t((key - 1) & 0xFFFFFF);
+            auto it = std::find_if(ret.begin(), ret.end(), [&](const Entry& e) {
+                return e.op == op && e.rows == rows && e.cols == cols;
+            });
+            if (it == ret.end()) {
+                ret.push_back(Entry {op, rows, cols, 0, 0, 0, 0});
+                it = ret.end() - 1;
+            }
+            it->calls   += s.calls.load(std::memory_order_relaxed);
+            it->flops   += s.flops.load(std::memory_order_relaxed);
+            it->samples += s.samples.load(std::memory_order_relaxed);
+            it->cycles  += s.cycles.load(std::memory_order_relaxed);
+        };
+        const auto addTable = [&add](const detail::Table& t) {
+            for (const auto& s : t.slots) {
+                add(s);
+            }
+            add(t.overflow);
+        };
+        std::lock_guard<std::mutex> lock (r.mutex);
+        for (const detail::Table* t : r.tables) {
+            addTable(*t);
+        }
+        addTable(r.retired);
+        ret.erase(std::remove_if(ret.begin(), ret.end(), [](const Entry& e) { return e.calls == 0; }), ret.end());
+        std::sort(ret.begin(), ret.end(), [](const Entry& a, const Entry& b) { return a.flops > b.flops; });
+        return ret;
+    }
+
+    ///Zeroes all counters, counts racing with the reset may be lost
+    inline void Reset() {
+        detail::Registry& r = detail::GetRegistry();
+        const auto clearTable = [](detail::Table& t) {
+            for (auto& s : t.slots) {
+                detail::Clear(s);
+            }
+            detail::Clear(t.overflow);
+        };
+        std::lock_guard<std::mutex> lock (r.mutex);
+        for (detail::Table* t : r.tables) {
+            clearTable(*t);
+        }
+        clearTable(r.retired);
+    }
+
+    inline void Report(std::ostream& os, const std::vector<Entry>& entries) {
+        os << std::left << std::setw(10) << "op" << std::right
+           << std::setw(12) << "size"
+           << std::setw(14) << "calls"
+           << std::setw(16) << "flops"
+           << std::setw(16) << "cycles/call" << '\n';
+        for (const auto& e : entries) {
+            const std::string size = std::to_string(e.rows) + "x" + std::to_string(e.cols);
+            os << std::left << std::setw(10) << OpName(e.op) << std::right
+               << std::setw(12) << size
+               << std::setw(14) << e.calls
+               << std::setw(16) << e.flops
+               << std::setw(16);
+            if (e.samples) {
+                os << e.cycles / e.samples;
+            } else {
+                os << '-';
+            }
+            os << '\n';
+        }
+    }
+
+    inline void Report(std::ostream& os) {
+        Report(os, Snapshot());
+    }
+}
+
+// Not const: a const integer initializer would be constant-evaluated,
+// making Begin() take its compile time branch
+#define MATRIX_PROFILE_BEGIN(start) uint64_t start = matrix_profile::Begin()
+#define MATRIX_PROFILE_END(op, rows, cols, flops, start) matrix_profile::End(matrix_profile::op, rows, cols, flops, start)
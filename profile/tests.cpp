@@ -0,0 +1,121 @@
+#include "Matrix.h"
+#include "Vector.h"
+#include "Quaternion.h"
+#include <thread>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#ifdef MATRIX_PROFILE
+
+namespace {
+    using matrix_profile::Entry;
+
+    Entry Find(const std::vector<Entry>& entries, matrix_profile::Op op, uint32_t rows, uint32_t cols) {
+        for (const Entry& e : entries) {
+            if (e.op == op && e.rows == rows && e.cols == cols) { return e; }
+        }
+        return Entry {op, rows, cols, 0, 0, 0, 0};
+    }
+
+    void Multiply4x4(int times) {
+        Matrix<4, 4> m = Matrix<4, 4>::Identity();
+        for (int i = 0; i < times; i++) {
+            m = m * Matrix<4, 4>::Identity();
+        }
+        CHECK(m.data == Matrix<4, 4>::Identity().data);
+    }
+
+    size_t LiveTables() {
+        matrix_profile::detail::Registry& r = matrix_profile::detail::GetRegistry();
+        std::lock_guard<std::mutex> lock (r.mutex);
+        return r.tables.size();
+    }
+}
+
+TEST_CASE("[Profile] counts per operation and size") {
+    matrix_profile::Reset();
+    Multiply4x4(3);
+    const Matrix<3, 3> a ({2, 0, 0, 0, 3, 0, 0, 0, 4});
+    const Matrix<3, 3> b = a * a;
+    const Matrix<3, 3> inv = b.Inverse();
+    CHECK(inv(0, 0) == 0.25f);
+    const Vector3 v = Vector3::Rotate(Vector3(1, 0, 0), Vector3(0, 0, 1), 1.5707964f);
+    const Vector3 w = Quaternion::Rotation(1.5707964f, Vector3(0, 0, 1)).Rotate(Vector3(1, 0, 0));
+    CHECK(std::abs(v.y - w.y) < 1e-6f);
+
+    const std::vector<Entry> entries = matrix_profile::Snapshot();
+    CHECK(Find(entries, matrix_profile::Multiply, 4, 4).calls == 3);
+    CHECK(Find(entries, matrix_profile::Multiply, 4, 4).flops == 3 * 128);
+    CHECK(Find(entries, matrix_profile::Multiply, 3, 3).calls == 1);
+    CHECK(Find(entries, matrix_profile::Multiply, 3, 3).flops == 54);
+    CHECK(Find(entries, matrix_profile::Inverse, 3, 3).calls == 1);
+    // Inverse runs Gauss on [A | I]
+    CHECK(Find(entries, matrix_profile::Gauss, 3, 6).calls == 1);
+    CHECK(Find(entries, matrix_profile::Rotate, 3, 1).calls == 1);
+    CHECK(Find(entries, matrix_profile::Rotate, 4, 1).calls == 1);
+    // Sorted by flops
+    for (size_t i = 1; i < entries.size(); i++) {
+        CHECK(entries[i - 1].flops >= entries[i].flops);
+    }
+}
+
+TEST_CASE("[Profile] reset") {
+    Multiply4x4(2);
+    CHECK(!matrix_profile::Snapshot().empty());
+    matrix_profile::Reset();
+    CHECK(matrix_profile::Snapshot().empty());
+}
+
+TEST_CASE("[Profile] threads that exited are still counted") {
+    matrix_profile::Reset();
+    Multiply4x4(1);
+    const size_t tables = LiveTables();
+    for (int i = 0; i < 4; i++) {
+        std::thread([] { Multiply4x4(10); }).join();
+    }
+    std::thread t1 ([] { Multiply4x4(5); });
+    std::thread t2 ([] { Multiply4x4(5); });
+    t1.join();
+    t2.join();
+    CHECK(Find(matrix_profile::Snapshot(), matrix_profile::Multiply, 4, 4).calls == 1 + 40 + 10);
+    // Their tables are folded into one instead of piling up
+    CHECK(LiveTables() == tables);
+
+    matrix_profile::Reset();
+    CHECK(matrix_profile::Snapshot().empty());
+}
+
+TEST_CASE("[Profile] sampling") {
+    matrix_profile::Reset();
+    matrix_profile::SetSampleInterval(1);
+    Multiply4x4(5);
+    matrix_profile::SetSampleInterval(0);
+    Multiply4x4(5);
+    const Entry e = Find(matrix_profile::Snapshot(), matrix_profile::Multiply, 4, 4);
+    CHECK(e.calls == 10);
+    CHECK(e.samples == 5);
+    CHECK(e.cycles > 0);
+}
+
+TEST_CASE("[Profile] constant evaluation isn't counted") {
+    matrix_profile::Reset();
+    constexpr Matrix<2, 2> m = Matrix<2, 2>({1, 2, 3, 4}) * Matrix<2, 2>::Identity();
+    static_assert(m(1, 0) == 3, "");
+    CHECK(matrix_profile::Snapshot().empty());
+}
+
+#else
+
+#define PROFILE_STRING(...) PROFILE_STRING_IMPL(__VA_ARGS__)
+#define PROFILE_STRING_IMPL(...) #__VA_ARGS__
+
+TEST_CASE("[Profile] disabled hooks expand to nothing") {
+    static_assert(sizeof(PROFILE_STRING(MATRIX_PROFILE_BEGIN(start))) == 1, "");
+    static_assert(sizeof(PROFILE_STRING(MATRIX_PROFILE_END(Multiply, 4, 4, 128, start))) == 1, "");
+    constexpr Matrix<2, 2> m = Matrix<2, 2>({1, 2, 3, 4}) * Matrix<2, 2>::Identity();
+    static_assert(m(1, 0) == 3, "");
+    CHECK(Vector3::Rotate(Vector3(1, 0, 0), Vector3(0, 0, 1), 0) == Vector3(1, 0, 0));
+}
+
+#endif /* MATRIX_PROFILE */
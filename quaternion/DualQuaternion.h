@@ -0,0 +1,90 @@
+#pragma once
+#include <cmath>
+#include <ostream>
+#include "Quaternion.h"
+
+///Rigid transform (rotation + translation) as real + ε·dual quaternion pair
+template <typename T>
+class DualQuaternionT {
+public:
+    QuaternionT<T> r;
+    QuaternionT<T> d;
+
+    constexpr DualQuaternionT (QuaternionT<T> real, QuaternionT<T> dual) : r(std::move(real)), d(std::move(dual)) { }
+
+    static constexpr DualQuaternionT<T> Identity () {
+        return DualQuaternionT<T> (QuaternionT<T>::Identity(), QuaternionT<T>(0, {0, 0, 0}));
+    }
+
+    ///Rotation is applied first, then translation
+    static constexpr DualQuaternionT<T> RotationTranslation (const QuaternionT<T>& rotation, const Vector3T<T>& translation) {
+        const QuaternionT<T> t (0, translation * T(0.5));
+        return DualQuaternionT<T> (rotation, t * rotation);
+    }
+
+    static constexpr DualQuaternionT<T> Translation (const Vector3T<T>& translation) {
+        return RotationTranslation(QuaternionT<T>::Identity(), translation);
+    }
+
+    ///Applies b first, then a
+    friend constexpr DualQuaternionT<T> operator*(const DualQuaternionT<T>& a, const DualQuaternionT<T>& b) {
+        const QuaternionT<T> d1 = a.r * b.d;
+        const QuaternionT<T> d2 = a.d * b.r;
+        return DualQuaternionT<T> (a.r * b.r, QuaternionT<T>(d1.s + d2.s, d1.v + d2.v));
+    }
+
+    ///Inverse of a unit dual quaternion
+    constexpr DualQuaternionT<T> Inverse() const {
+        return DualQuaternionT<T> (r.Inverse(), d.Inverse());
+    }
+
+    constexpr QuaternionT<T> Rotation() const {
+        return r;
+    }
+
+    constexpr Vector3T<T> Translation() const {
+        // 2 * d * conj(r)
+        return (d * r.Inverse()).v * T(2);
+    }
+
+    ///Dual quaternion must be unit
+    constexpr Vector3T<T> TransformPoint(const Vector3T<T>& p) const {
+        // p + 2 r.v × (r.v × p + r.s p) + 2 (r.s d.v − d.s r.v + r.v × d.v)
+        const Vector3T<T> inner = Vector3T<T>::Cross(r.v, p) + p * r.s;
+        const Vector3T<T> trans = d.v * r.s - r.v * d.s + Vector3T<T>::Cross(r.v, d.v);
+        return p + (Vector3T<T>::Cross(r.v, inner) + trans) * T(2);
+    }
+
+    ///Dual quaternion must be unit
+    constexpr Vector3T<T> TransformVector(const Vector3T<T>& v) const {
+        const Vector3T<T> inner = Vector3T<T>::Cross(r.v, v) + v * r.s;
+        return v + Vector3T<T>::Cross(r.v, inner) * T(2);
+    }
+
+    ///Divides by the magnitude of the real part, so that a blended
+    ///dual quaternion becomes a rigid transform again.
+    ///Remember to check if magnitude is zero
+    constexpr DualQuaternionT<T> Normalized() const {
+        const T inv = T(1) / std::sqrt(r.s*r.s + Vector3T<T>::Dot(r.v, r.v));
+        return DualQuaternionT<T> (QuaternionT<T>(r.s * inv, r.v * inv), QuaternionT<T>(d.s * inv, d.v * inv));
+    }
+
+#ifndef NO_MATRIX_DEP
+    constexpr Matrix<4, 4, T> TransformMatrix() const {
+        const Vector3T<T> t = Translation();
+        Matrix<4, 4, T> m = r.RotationMatrix();
+        m(0, 3) = t.x;
+        m(1, 3) = t.y;
+        m(2, 3) = t.z;
+        return m;
+    }
+#endif /* NO_MATRIX_DEP */
+
+    friend std::ostream& operator<<(std::ostream& o, const DualQuaternionT<T> &q) {
+        return o << q.r << ' ' << q.d;
+    }
+};
+
+typedef DualQuaternionT<float> DualQuaternion;
+
+static_assert(std::is_trivially_copyable<DualQuaternion>::value, "DualQuaternionT must be trivially copyable");
@@ -1,6 +1,7 @@
 #pragma once
 #include <cmath>
 #include <ostream>
+#include <type_traits>
 #include "Vector.h"
 
 template <typename T>
@@ -15,8 +16,10 @@ public:
         return Euler(pitch_yaw_roll.x, pitch_yaw_roll.y, pitch_yaw_roll.z);
     }
     static constexpr QuaternionT<T> Euler (T pitch, T yaw, T roll) {
-        const Vector3T<T> c (std::cos(pitch/2), std::cos(yaw/2), std::cos(roll/2));
-        const Vector3T<T> s (std::sin(pitch/2), std::sin(yaw/2), std::sin(roll/2));
+        // Allow non-std overloads of sin() and cos() for T
+        using std::sin, std::cos;
+        const Vector3T<T> c (cos(pitch/2), cos(yaw/2), cos(roll/2));
+        const Vector3T<T> s (sin(pitch/2), sin(yaw/2), sin(roll/2));
         return QuaternionT<T> (
             c.x*c.y*c.z + s.x*s.y*s.z,
             Vector3T<T> (
@@ -36,8 +39,9 @@ public:
     }
 
     static constexpr QuaternionT<T> RotationN (T angle, Vector3T<T> normalizedAxis) {
+        using std::sin, std::cos;
         const T halfAng = angle/2;
-        return QuaternionT<T> (std::cos(halfAng), std::sin(halfAng) * normalizedAxis);
+        return QuaternionT<T> (cos(halfAng), sin(halfAng) * normalizedAxis);
     }
 
     // // Alternative multiplication implementation, seems to be slower on CPU
@@ -62,10 +66,52 @@ public:
         return QuaternionT<T> (s, -v);
     }
 
+    [[nodiscard]] static constexpr T Dot(const QuaternionT<T>& a, const QuaternionT<T>& b) {
+        return a.s*b.s + a.v.x*b.v.x + a.v.y*b.v.y + a.v.z*b.v.z;
+    }
+
+    [[nodiscard]] constexpr T Magnitude() const {
+        using std::sqrt;
+        return sqrt(Dot(*this, *this));
+    }
+
+    ///Remember to check if magnitude is zero
+    [[nodiscard]] constexpr QuaternionT<T> Normalized() const {
+        const T inv = T(1) / Magnitude();
+        return QuaternionT<T> (s * inv, v * inv);
+    }
+
+    ///Normalized linear interpolation along the shortest arc.
+    ///Cheaper than Slerp(), but the angular speed is not constant
+    [[nodiscard]] static constexpr QuaternionT<T> Nlerp(const QuaternionT<T>& from, const QuaternionT<T>& to, T t) {
+        const T w0 = 1 - t;
+        // q and -q are the same rotation, take the closer one
+        const T w1 = Dot(from, to) < 0 ? -t : t;
+        return QuaternionT<T> (from.s*w0 + to.s*w1, from.v*w0 + to.v*w1).Normalized();
+    }
+
+    ///Spherical linear interpolation along the shortest arc, constant angular speed.
+    ///Both quaternions must be unit
+    [[nodiscard]] static constexpr QuaternionT<T> Slerp(const QuaternionT<T>& from, const QuaternionT<T>& to, T t) {
+        using std::acos, std::sin;
+        const T dot = Dot(from, to);
+        const T cosTheta = dot < 0 ? -dot : dot;
+        // sin(theta) is too small to divide by, and nlerp is exact enough here
+        if (cosTheta > T(0.9995)) { return Nlerp(from, to, t); }
+        const T theta = acos(cosTheta);
+        const T invSin = T(1) / sin(theta);
+        const T w0 = sin((1 - t) * theta) * invSin;
+        const T w1 = sin(t * theta) * invSin;
+        return QuaternionT<T> (from.s*w0 + to.s*(dot < 0 ? -w1 : w1), from.v*w0 + to.v*(dot < 0 ? -w1 : w1));
+    }
+
     constexpr Vector3T<T> Rotate(Vector3T<T> point) const {
+        MATRIX_PROFILE_BEGIN(profile_start);
         const QuaternionT<T> q2 (this->s, -this->v);
         const QuaternionT<T> p (0, std::move(point));
-        return QuaternionT<T>(*this * p * q2).v;
+        const Vector3T<T> ret = QuaternionT<T>(*this * p * q2).v;
+        MATRIX_PROFILE_END(Rotate, 4, 1, 56, profile_start);
+        return ret;
     }
 
 #ifndef NO_MATRIX_DEP
@@ -85,3 +131,7 @@ public:
 };
 
 typedef QuaternionT<float> Quaternion;
+
+static_assert(std::is_trivially_copyable<Quaternion>::value, "QuaternionT must be trivially copyable");
+static_assert(std::is_standard_layout<Quaternion>::value, "QuaternionT must be standard layout");
+static_assert(sizeof(Quaternion) == 4 * sizeof(float), "QuaternionT must not have padding");
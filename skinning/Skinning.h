@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include "DualQuaternion.h"
+#include "Parallel.h"
+
+///Input vertex stream: positions in SoA form, `influences` bone indices
+///and weights per vertex stored contiguously (vertex i uses
+///bones[i * influences .. i * influences + influences - 1]).
+///Unused influence slots must have zero weight.
+template <typename T, size_t influences>
+struct SkinStreamT {
+    static_assert(influences == 4 || influences == 8, "Only 4 or 8 influences per vertex are supported");
+    const T* x; const T* y; const T* z;
+    const uint16_t* bones;
+    const T* weights;
+    size_t count;
+};
+
+template <typename T>
+struct PositionStreamT {
+    T* x; T* y; T* z;
+};
+
+namespace skinning {
+    // Vertices per inner block, the block loops are written so that
+    // compilers vectorize them across vertices
+    constexpr size_t lanes = 8;
+    // Smallest amount of vertices worth a thread
+    constexpr size_t chunk = 4096;
+
+    template <typename T, size_t influences>
+    void LinearRange(const Matrix<4, 4, T>* palette, const SkinStreamT<T, influences>& in,
+                     const PositionStreamT<T>& out, size_t begin, size_t end) {
+        for (size_t base = begin; base < end; base += lanes) {
+            const size_t n = std::min(lanes, end - base);
+            // Blended 3x4 matrix per lane
+            std::array<std::array<T, lanes>, 12> m {};
+            for (size_t w = 0; w < influences; w++) {
+                for (size_t k = 0; k < n; k++) {
+                    const size_t i = (base + k) * influences + w;
+                    const T wt = in.weights[i];
+                    const auto& bone = palette[in.bones[i]];
+                    for (size_t j = 0; j < 12; j++) {
+                        m[j][k] += wt * bone[j];
+                    }
+                }
+            }
+            for (size_t k = 0; k < n; k++) {
+                const size_t i = base + k;
+                const T x = in.x[i], y = in.y[i], z = in.z[i];
+                out.x[i] = m[0][k] * x + m[1][k] * y + m[2][k]  * z + m[3][k];
+                out.y[i] = m[4][k] * x + m[5][k] * y + m[6][k]  * z + m[7][k];
+                out.z[i] = m[8][k] * x + m[9][k] * y + m[10][k] * z + m[11][k];
+            }
+        }
+    }
+
+    template <typename T, size_t influences>
+    void DualQuaternionRange(const DualQuaternionT<T>* palette, const SkinStreamT<T, influences>& in,
+                             const PositionStreamT<T>& out, size_t begin, size_t end) {
+        for (size_t base = begin; base < end; base += lanes) {
+            const size_t n = std::min(lanes, end - base);
+            // Blended real (0..3) and dual (4..7) parts per lane
+            std::array<std::array<T, lanes>, 8> q {};
+            for (size_t w = 0; w < influences; w++) {
+                for (size_t k = 0; k < n; k++) {
+                    const size_t v = (base + k) * influences;
+                    const auto& first = palette[in.bones[v]].r;
+                    const auto& dq = palette[in.bones[v + w]];
+                    // Blend along the shortest path, q and -q are the same rotation
+                    const T dot = first.s * dq.r.s + Vector3T<T>::Dot(first.v, dq.r.v);
+                    const T wt = dot < 0 ? -in.weights[v + w] : in.weights[v + w];
+                    q[0][k] += wt * dq.r.s;
+                    q[1][k] += wt * dq.r.v.x;
+                    q[2][k] += wt * dq.r.v.y;
+                    q[3][k] += wt * dq.r.v.z;
+                    q[4][k] += wt * dq.d.s;
+                    q[5][k] += wt * dq.d.v.x;
+                    q[6][k] += wt * dq.d.v.y;
+                    q[7][k] += wt * dq.d.v.z;
+                }
+            }
+            for (size_t k = 0; k < n; k++) {
+                const size_t i = base + k;
+                const DualQuaternionT<T> dq = DualQuaternionT<T> (
+                    QuaternionT<T>(q[0][k], {q[1][k], q[2][k], q[3][k]}),
+                    QuaternionT<T>(q[4][k], {q[5][k], q[6][k], q[7][k]})
+                ).Normalized();
+                const Vector3T<T> p = dq.TransformPoint({in.x[i], in.y[i], in.z[i]});
+                out.x[i] = p.x;
+                out.y[i] = p.y;
+                out.z[i] = p.z;
+            }
+        }
+    }
+}
+
+///Linear blend skinning, `palette` holds affine bone matrices.
+///Runs on up to `threads` threads (0 = all cores).
+template <typename T, size_t influences>
+void SkinLinear(const Matrix<4, 4, T>* palette, const SkinStreamT<T, influences>& in,
+                const PositionStreamT<T>& out, size_t threads = 0) {
+    ParallelFor(in.count, skinning::chunk, [&](size_t begin, size_t end) {
+        skinning::LinearRange(palette, in, out, begin, end);
+    }, threads);
+}
+
+///Dual quaternion skinning, `palette` holds unit dual quaternions.
+///Preserves volume at twisting joints, unlike linear blending.
+///Runs on up to `threads` threads (0 = all cores).
+template <typename T, size_t influences>
+void SkinDualQuaternion(const DualQuaternionT<T>* palette, const SkinStreamT<T, influences>& in,
+                        const PositionStreamT<T>& out, size_t threads = 0) {
+    ParallelFor(in.count, skinning::chunk, [&](size_t begin, size_t end) {
+        skinning::DualQuaternionRange(palette, in, out, begin, end);
+    }, threads);
+}
+
+typedef SkinStreamT<float, 4> SkinStream4;
+typedef SkinStreamT<float, 8> SkinStream8;
+typedef PositionStreamT<float> PositionStream;
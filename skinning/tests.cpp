@@ -0,0 +1,173 @@
+#include "Skinning.h"
+#include <cmath>
+#include <random>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    bool Near(const Vector3& a, const Vector3& b, float eps = 1e-4f) {
+        return std::abs(a.x - b.x) <= eps && std::abs(a.y - b.y) <= eps && std::abs(a.z - b.z) <= eps;
+    }
+
+    Vector3 TransformPoint(const Matrix<4, 4>& m, const Vector3& p) {
+        const VectorS<4> r = m * p.Homogeneous(1);
+        return Vector3(r[0], r[1], r[2]);
+    }
+
+    DualQuaternion Negated(const DualQuaternion& q) {
+        return DualQuaternion(Quaternion(-q.r.s, -q.r.v), Quaternion(-q.d.s, -q.d.v));
+    }
+
+    template <size_t influences>
+    struct Mesh {
+        std::vector<float> x, y, z, weights;
+        std::vector<uint16_t> bones;
+
+        Mesh(size_t count, size_t paletteSize, std::mt19937& rng) {
+            std::uniform_real_distribution<float> u (-2, 2), w (0, 1);
+            for (size_t i = 0; i < count; i++) {
+                x.push_back(u(rng));
+                y.push_back(u(rng));
+                z.push_back(u(rng));
+                float sum = 0;
+                for (size_t k = 0; k < influences; k++) {
+                    bones.push_back(uint16_t(rng() % paletteSize));
+                    // Some slots unused, as the stream allows
+                    weights.push_back(k == influences - 1 ? 0 : w(rng));
+                    sum += weights.back();
+                }
+                for (size_t k = 0; k < influences; k++) {
+                    weights[i * influences + k] /= sum;
+                }
+            }
+        }
+
+        SkinStreamT<float, influences> Stream() const {
+            return {x.data(), y.data(), z.data(), bones.data(), weights.data(), x.size()};
+        }
+    };
+
+    std::vector<DualQuaternion> RandomPalette(size_t count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> u (-3, 3);
+        std::vector<DualQuaternion> palette;
+        for (size_t i = 0; i < count; i++) {
+            palette.push_back(DualQuaternion::RotationTranslation(
+                Quaternion::Euler(u(rng), u(rng), u(rng)), Vector3(u(rng), u(rng), u(rng))));
+        }
+        return palette;
+    }
+
+    // Per-vertex formulas the batch kernels must reproduce
+
+    template <size_t influences>
+    Vector3 LinearScalar(const std::vector<Matrix<4, 4>>& palette, const Mesh<influences>& mesh, size_t i) {
+        Matrix<4, 4> blended = Matrix<4, 4>::Zero();
+        for (size_t k = 0; k < influences; k++) {
+            blended = blended + palette[mesh.bones[i * influences + k]] * mesh.weights[i * influences + k];
+        }
+        return TransformPoint(blended, Vector3(mesh.x[i], mesh.y[i], mesh.z[i]));
+    }
+
+    template <size_t influences>
+    Vector3 DualQuaternionScalar(const std::vector<DualQuaternion>& palette, const Mesh<influences>& mesh, size_t i) {
+        const Quaternion& first = palette[mesh.bones[i * influences]].r;
+        Quaternion r (0, {0, 0, 0}), d (0, {0, 0, 0});
+        for (size_t k = 0; k < influences; k++) {
+            const DualQuaternion& q = palette[mesh.bones[i * influences + k]];
+            const float sign = Quaternion::Dot(first, q.r) < 0 ? -1.0f : 1.0f;
+            const float w = sign * mesh.weights[i * influences + k];
+            r = Quaternion(r.s + w * q.r.s, r.v + q.r.v * w);
+            d = Quaternion(d.s + w * q.d.s, d.v + q.d.v * w);
+        }
+        return DualQuaternion(r, d).Normalized().TransformPoint(Vector3(mesh.x[i], mesh.y[i], mesh.z[i]));
+    }
+}
+
+TEST_CASE("[DualQuaternion] rigid transforms") {
+    std::mt19937 rng {1};
+    const std::vector<DualQuaternion> palette = RandomPalette(2, rng);
+    const DualQuaternion& a = palette[0];
+    const DualQuaternion& b = palette[1];
+    const Vector3 p (0.5f, -1, 2);
+
+    CHECK(Near(a.TransformPoint(p), TransformPoint(a.TransformMatrix(), p)));
+    CHECK(Near((a * b).TransformPoint(p), a.TransformPoint(b.TransformPoint(p))));
+    CHECK(Near(a.Inverse().TransformPoint(a.TransformPoint(p)), p));
+    CHECK(Near(DualQuaternion::Translation(Vector3(1, 2, 3)).TransformPoint(p), p + Vector3(1, 2, 3)));
+    CHECK(Near(a.TransformVector(Vector3(1, 0, 0)), a.r.Rotate(Vector3(1, 0, 0))));
+    CHECK(Near(DualQuaternion::RotationTranslation(a.r, Vector3(4, 5, 6)).Translation(), Vector3(4, 5, 6)));
+    // q and -q are the same transform
+    CHECK(Near(Negated(a).TransformPoint(p), a.TransformPoint(p)));
+}
+
+TEST_CASE("[Skinning] linear blend matches per-vertex formula") {
+    std::mt19937 rng {2};
+    const std::vector<DualQuaternion> dq = RandomPalette(12, rng);
+    std::vector<Matrix<4, 4>> palette;
+    for (const DualQuaternion& q : dq) {
+        palette.push_back(q.TransformMatrix());
+    }
+    // Not a multiple of the 8 lanes, the last block is ragged
+    const size_t count = 8 * 5 + 3;
+    const Mesh<4> mesh4 (count, palette.size(), rng);
+    const Mesh<8> mesh8 (count, palette.size(), rng);
+    std::vector<float> ox (count), oy (count), oz (count);
+    const PositionStream out {ox.data(), oy.data(), oz.data()};
+
+    skinning::LinearRange(palette.data(), mesh4.Stream(), out, 0, count);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(Near(Vector3(ox[i], oy[i], oz[i]), LinearScalar(palette, mesh4, i)));
+    }
+    SkinLinear(palette.data(), mesh8.Stream(), out, 3);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(Near(Vector3(ox[i], oy[i], oz[i]), LinearScalar(palette, mesh8, i)));
+    }
+
+    // A sub-range leaves the rest alone
+    std::fill(ox.begin(), ox.end(), 42.0f);
+    skinning::LinearRange(palette.data(), mesh4.Stream(), out, 5, 13);
+    CHECK(ox[4] == 42.0f);
+    CHECK(ox[13] == 42.0f);
+    CHECK(std::abs(ox[12] - LinearScalar(palette, mesh4, 12).x) <= 1e-4f);
+}
+
+TEST_CASE("[Skinning] dual quaternion blend matches per-vertex formula") {
+    std::mt19937 rng {3};
+    std::vector<DualQuaternion> palette = RandomPalette(12, rng);
+    const size_t count = 8 * 5 + 3;
+    Mesh<4> mesh4 (count, palette.size(), rng);
+    const Mesh<8> mesh8 (count, palette.size(), rng);
+    std::vector<float> ox (count), oy (count), oz (count);
+    const PositionStream out {ox.data(), oy.data(), oz.data()};
+
+    skinning::DualQuaternionRange(palette.data(), mesh4.Stream(), out, 0, count);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(Near(Vector3(ox[i], oy[i], oz[i]), DualQuaternionScalar(palette, mesh4, i)));
+    }
+    SkinDualQuaternion(palette.data(), mesh8.Stream(), out, 3);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(Near(Vector3(ox[i], oy[i], oz[i]), DualQuaternionScalar(palette, mesh8, i)));
+    }
+}
+
+TEST_CASE("[Skinning] antipodal bones blend along the shortest path") {
+    std::mt19937 rng {4};
+    std::vector<DualQuaternion> palette = RandomPalette(1, rng);
+    // Same transform with the opposite sign, a naive blend would cancel out to zero
+    palette.push_back(Negated(palette[0]));
+    const size_t count = 8 + 1;
+    Mesh<4> mesh (count, 1, rng);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t k = 0; k < 4; k++) {
+            mesh.bones[i * 4 + k] = uint16_t((i + k) % 2);
+            mesh.weights[i * 4 + k] = 0.25f;
+        }
+    }
+    std::vector<float> ox (count), oy (count), oz (count);
+    SkinDualQuaternion(palette.data(), mesh.Stream(), PositionStream {ox.data(), oy.data(), oz.data()});
+    for (size_t i = 0; i < count; i++) {
+        const Vector3 p (mesh.x[i], mesh.y[i], mesh.z[i]);
+        CHECK(Near(Vector3(ox[i], oy[i], oz[i]), palette[0].TransformPoint(p)));
+    }
+}
@@ -0,0 +1,473 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "Vector.h"
+#include "Parallel.h"
+
+///One entry of a sparse matrix under assembly, duplicates are summed
+template <typename T>
+struct TripletT {
+    uint32_t row;
+    uint32_t col;
+    T value;
+};
+
+namespace sparse {
+    // Smallest amount of rows or vector elements worth a thread
+    constexpr size_t chunk = 4096;
+
+    ///Sum of f(begin, end) over blocks of `chunk` elements. Blocks run in parallel
+    ///and are added in a fixed order, so the result doesn't depend on the thread count
+    template <typename T, typename F>
+    [[nodiscard]] T Reduce(size_t count, F&& f, size_t threads = 0) {
+        const size_t blocks = (count + chunk - 1) / chunk;
+        std::vector<T> partial (blocks);
+        ParallelFor(blocks, 1, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; b++) {
+                partial[b] = f(b * chunk, std::min(count, (b + 1) * chunk));
+            }
+        }, threads);
+        T sum = 0;
+        for (const T p : partial) {
+            sum += p;
+        }
+        return sum;
+    }
+
+    template <typename T>
+    [[nodiscard]] T Dot(const std::vector<T>& a, const std::vector<T>& b, size_t threads = 0) {
+        return Reduce<T>(a.size(), [&](size_t begin, size_t end) {
+            T sum = 0;
+            for (size_t i = begin; i < end; i++) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }, threads);
+    }
+
+    ///N consecutive elements of a heap vector starting at node * N,
+    ///e.g. the position of particle `node` in a cloth state vector
+    template <size_t N, typename T>
+    [[nodiscard]] VectorS<N, T> GetBlock(const std::vector<T>& v, size_t node) {
+        VectorS<N, T> ret;
+        for (size_t i = 0; i < N; i++) {
+            ret[i] = v[node * N + i];
+        }
+        return ret;
+    }
+
+    template <size_t N, typename T>
+    void SetBlock(std::vector<T>& v, size_t node, const Matrix<N, 1, T>& block) {
+        for (size_t i = 0; i < N; i++) {
+            v[node * N + i] = block[i];
+        }
+    }
+
+    ///Appends a dense element matrix, block(i, j) goes to (rowDofs[i], colDofs[j])
+    template <size_t rows, size_t cols, typename T>
+    void AppendBlock(std::vector<TripletT<T>>& triplets, const Matrix<rows, cols, T>& block,
+                     const std::array<uint32_t, rows>& rowDofs, const std::array<uint32_t, cols>& colDofs) {
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                triplets.push_back({rowDofs[i], colDofs[j], block(i, j)});
+            }
+        }
+    }
+
+    ///Appends an N x N block coupling node `rowNode` to node `colNode`,
+    ///with N unknowns per node (e.g. 3x3 blocks for 3D particles)
+    template <size_t N, typename T>
+    void AppendBlock(std::vector<TripletT<T>>& triplets, const Matrix<N, N, T>& block, uint32_t rowNode, uint32_t colNode) {
+        for (size_t i = 0; i < N; i++) {
+            for (size_t j = 0; j < N; j++) {
+                triplets.push_back({uint32_t(rowNode * N + i), uint32_t(colNode * N + j), block(i, j)});
+            }
+        }
+    }
+}
+
+///Compressed sparse row matrix: the entries of row i are
+///values[rowStart[i] .. rowStart[i + 1]), sorted by column
+template <typename T>
+class CsrMatrixT {
+public:
+    size_t rows = 0;
+    size_t cols = 0;
+    std::vector<size_t> rowStart;
+    std::vector<uint32_t> colIndex;
+    std::vector<T> values;
+
+    CsrMatrixT() = default;
+    CsrMatrixT(size_t rows, size_t cols) : rows(rows), cols(cols), rowStart(rows + 1) {}
+
+    ///Sums duplicate entries, so overlapping element blocks can be appended as they are.
+    ///Throws std::out_of_range if a triplet is outside rows x cols
+    [[nodiscard]] static CsrMatrixT FromTriplets(size_t rows, size_t cols, const std::vector<TripletT<T>>& triplets) {
+        CsrMatrixT m (rows, cols);
+        // Counting sort by row, then sort and merge each row by column
+        std::vector<size_t> start (rows + 1);
+        for (const auto& t : triplets) {
+            if (t.row >= rows || t.col >= cols) {
+                throw std::out_of_range("Triplet (" + std::to_string(t.row) + ", " + std::to_string(t.col) +
+                                        ") is outside a " + std::to_string(rows) + "x" + std::to_string(cols) + " matrix");
+            }
+            start[t.row + 1]++;
+        }
+        for (size_t i = 0; i < rows; i++) {
+            start[i + 1] += start[i];
+        }
+        std::vector<std::pair<uint32_t, T>> entries (triplets.size());
+        std::vector<size_t> next (start.begin(), start.end() - 1);
+        for (const auto& t : triplets) {
+            entries[next[t.row]++] = {t.col, t.value};
+        }
+        m.colIndex.reserve(triplets.size());
+        m.values.reserve(triplets.size());
+        for (size_t i = 0; i < rows; i++) {
+            const auto first = entries.begin() + start[i];
+            const auto last = entries.begin() + start[i + 1];
+            std::sort(first, last, [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (auto e = first; e != last; ++e) {
+                if (m.colIndex.size() > m.rowStart[i] && m.colIndex.back() == e->first) {
+                    m.values.back() += e->second;
+                } else {
+                    m.colIndex.push_back(e->first);
+                    m.values.push_back(e->second);
+                }
+            }
+            m.rowStart[i + 1] = m.colIndex.size();
+        }
+        return m;
+    }
+
+    [[nodiscard]] size_t NonZeros() const { return values.size(); }
+
+    ///Entry (row, col), 0 if it isn't stored. O(log(entries in the row))
+    [[nodiscard]] T operator()(size_t row, size_t col) const {
+        const auto first = colIndex.begin() + rowStart[row];
+        const auto last = colIndex.begin() + rowStart[row + 1];
+        const auto it = std::lower_bound(first, last, uint32_t(col));
+        return it != last && *it == col ? values[it - colIndex.begin()] : T(0);
+    }
+
+    [[nodiscard]] std::vector<T> Diagonal() const {
+        std::vector<T> d (std::min(rows, cols));
+        for (size_t i = 0; i < d.size(); i++) {
+            d[i] = (*this)(i, i);
+        }
+        return d;
+    }
+
+    ///y = this * x, rows are split between up to `threads` threads (0 = all cores).
+    ///x must have cols elements, y rows elements
+    void Multiply(const T* x, T* y, size_t threads = 0) const {
+        // Raw pointers, so that stores to y can't alias the vectors' members
+        const size_t* start = rowStart.data();
+        const uint32_t* col = colIndex.data();
+        const T* value = values.data();
+        ParallelFor(rows, sparse::chunk, [=](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                T sum = 0;
+                for (size_t k = start[i]; k < start[i + 1]; k++) {
+                    sum += value[k] * x[col[k]];
+                }
+                y[i] = sum;
+            }
+        }, threads);
+    }
+
+    [[nodiscard]] std::vector<T> operator*(const std::vector<T>& x) const {
+        std::vector<T> y (rows);
+        Multiply(x.data(), y.data());
+        return y;
+    }
+};
+
+///Leaves the residual as it is, for comparison or well-conditioned systems
+struct IdentityPreconditioner {
+    template <typename T>
+    void Apply(const std::vector<T>& r, std::vector<T>& z, size_t = 0) const { z = r; }
+};
+
+///z = r / diag(A). Cheap, helps when the diagonal varies a lot
+template <typename T>
+class JacobiPreconditionerT {
+public:
+    std::vector<T> inverseDiagonal;
+
+    explicit JacobiPreconditionerT(const CsrMatrixT<T>& a) : inverseDiagonal(a.Diagonal()) {
+        for (T& d : inverseDiagonal) {
+            d = d != 0 ? T(1) / d : T(1);
+        }
+    }
+
+    void Apply(const std::vector<T>& r, std::vector<T>& z, size_t threads = 0) const {
+        ParallelFor(r.size(), sparse::chunk, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                z[i] = r[i] * inverseDiagonal[i];
+            }
+        }, threads);
+    }
+};
+
+///Zero fill-in incomplete Cholesky, A ≈ L * Lᵀ with L on the lower triangle
+///pattern of A. For symmetric positive definite A only.
+///If a pivot breaks down, A + shift * diag(A) is factored instead, with a growing shift.
+///Apply() is two sequential triangular solves
+template <typename T>
+class IncompleteCholeskyT {
+public:
+    CsrMatrixT<T> lower;
+    ///Relative diagonal shift the factorization needed, 0 if A factored as it is
+    T shift = 0;
+
+    explicit IncompleteCholeskyT(const CsrMatrixT<T>& a) {
+        for (size_t attempt = 0; attempt < 16; attempt++) {
+            if (Factor(a)) { return; }
+            shift = std::max(shift * 2, T(1e-3));
+        }
+        // Not positive definite even when shifted, degrade to Jacobi-like scaling
+        Diagonal(a);
+    }
+
+    void Apply(const std::vector<T>& r, std::vector<T>& z, size_t = 0) const {
+        const auto& l = lower;
+        // L * y = r, the diagonal is the last entry of each row
+        for (size_t i = 0; i < l.rows; i++) {
+            T sum = r[i];
+            const size_t diag = l.rowStart[i + 1] - 1;
+            for (size_t k = l.rowStart[i]; k < diag; k++) {
+                sum -= l.values[k] * z[l.colIndex[k]];
+            }
+            z[i] = sum / l.values[diag];
+        }
+        // Lᵀ * z = y, column by column
+        for (size_t i = l.rows; i-- > 0;) {
+            const size_t diag = l.rowStart[i + 1] - 1;
+            z[i] /= l.values[diag];
+            const T zi = z[i];
+            for (size_t k = l.rowStart[i]; k < diag; k++) {
+                z[l.colIndex[k]] -= l.values[k] * zi;
+            }
+        }
+    }
+
+private:
+    bool Factor(const CsrMatrixT<T>& a) {
+        using std::sqrt;
+        lower = CsrMatrixT<T>(a.rows, a.cols);
+        auto& l = lower;
+        for (size_t i = 0; i < a.rows; i++) {
+            T diag = 0;
+            for (size_t k = a.rowStart[i]; k < a.rowStart[i + 1]; k++) {
+                const uint32_t j = a.colIndex[k];
+                if (j < i) {
+                    l.colIndex.push_back(j);
+                    l.values.push_back(a.values[k]);
+                } else if (j == i) {
+                    diag = a.values[k] * (1 + shift);
+                }
+            }
+            const size_t rowBegin = l.rowStart[i];
+            const size_t rowEnd = l.colIndex.size();
+            for (size_t k = rowBegin; k < rowEnd; k++) {
+                const uint32_t j = l.colIndex[k];
+                // l(i, j) -= sum of l(i, m) * l(j, m) for m < j, both rows are sorted
+                T sum = 0;
+                size_t p = rowBegin;
+                size_t q = l.rowStart[j];
+                const size_t qDiag = l.rowStart[j + 1] - 1;
+                while (p < k && q < qDiag) {
+                    if (l.colIndex[p] < l.colIndex[q]) {
+                        p++;
+                    } else if (l.colIndex[p] > l.colIndex[q]) {
+                        q++;
+                    } else {
+                        sum += l.values[p++] * l.values[q++];
+                    }
+                }
+                l.values[k] = (l.values[k] - sum) / l.values[qDiag];
+                diag -= l.values[k] * l.values[k];
+            }
+            // Negated so that NaN fails too
+            if (!(diag > 0)) { return false; }
+            l.colIndex.push_back(uint32_t(i));
+            l.values.push_back(sqrt(diag));
+            l.rowStart[i + 1] = l.colIndex.size();
+        }
+        return true;
+    }
+
+    void Diagonal(const CsrMatrixT<T>& a) {
+        using std::sqrt, std::abs;
+        lower = CsrMatrixT<T>(a.rows, a.cols);
+        const std::vector<T> d = a.Diagonal();
+        for (size_t i = 0; i < a.rows; i++) {
+            lower.colIndex.push_back(uint32_t(i));
+            lower.values.push_back(d[i] != 0 ? sqrt(abs(d[i])) : T(1));
+            lower.rowStart[i + 1] = i + 1;
+        }
+    }
+};
+
+struct SolveResult {
+    size_t iterations = 0;
+    ///|b - A * x| / |b| at the end
+    double relativeResidual = 0;
+    bool converged = false;
+};
+
+///Preconditioned conjugate gradient for symmetric positive definite A.
+///x is the initial guess (resized with zeros if it doesn't fit) and the solution.
+///Stops when |b - A * x| <= tolerance * |b|
+template <typename T, typename Preconditioner = IdentityPreconditioner>
+SolveResult ConjugateGradient(const CsrMatrixT<T>& a, const std::vector<T>& b, std::vector<T>& x,
+                              const Preconditioner& preconditioner = {},
+                              T tolerance = T(1e-6), size_t maxIterations = 1000, size_t threads = 0) {
+    using std::sqrt;
+    using sparse::Dot;
+    const size_t n = a.rows;
+    x.resize(n);
+    SolveResult result;
+    const T bNorm = sqrt(Dot(b, b, threads));
+    if (bNorm == 0) {
+        std::fill(x.begin(), x.end(), T(0));
+        result.converged = true;
+        return result;
+    }
+    std::vector<T> r (n), z (n), p (n), ap (n);
+    a.Multiply(x.data(), ap.data(), threads);
+    for (size_t i = 0; i < n; i++) {
+        r[i] = b[i] - ap[i];
+    }
+    T rNorm = sqrt(Dot(r, r, threads));
+    preconditioner.Apply(r, z, threads);
+    p = z;
+    T rz = Dot(r, z, threads);
+    while (result.iterations < maxIterations && rNorm > tolerance * bNorm) {
+        a.Multiply(p.data(), ap.data(), threads);
+        const T alpha = rz / Dot(p, ap, threads);
+        const T rr = sparse::Reduce<T>(n, [&](size_t begin, size_t end) {
+            T sum = 0;
+            for (size_t i = begin; i < end; i++) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * ap[i];
+                sum += r[i] * r[i];
+            }
+            return sum;
+        }, threads);
+        rNorm = sqrt(rr);
+        result.iterations++;
+        preconditioner.Apply(r, z, threads);
+        const T rzNext = Dot(r, z, threads);
+        const T beta = rzNext / rz;
+        rz = rzNext;
+        ParallelFor(n, sparse::chunk, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                p[i] = z[i] + beta * p[i];
+            }
+        }, threads);
+    }
+    result.relativeResidual = double(rNorm / bNorm);
+    result.converged = rNorm <= tolerance * bNorm;
+    return result;
+}
+
+///Preconditioned BiCGSTAB (van der Vorst) for general square A.
+///Same arguments and stopping rule as ConjugateGradient()
+template <typename T, typename Preconditioner = IdentityPreconditioner>
+SolveResult BiCGSTAB(const CsrMatrixT<T>& a, const std::vector<T>& b, std::vector<T>& x,
+                     const Preconditioner& preconditioner = {},
+                     T tolerance = T(1e-6), size_t maxIterations = 1000, size_t threads = 0) {
+    using std::sqrt, std::abs;
+    using sparse::Dot;
+    const size_t n = a.rows;
+    x.resize(n);
+    SolveResult result;
+    const T bNorm = sqrt(Dot(b, b, threads));
+    if (bNorm == 0) {
+        std::fill(x.begin(), x.end(), T(0));
+        result.converged = true;
+        return result;
+    }
+    std::vector<T> r (n), rHat (n), p (n), v (n), s (n), t (n), pHat (n), sHat (n);
+    T rNorm = 0, rHatNorm = 0;
+    T rho = 1, alpha = 1, omega = 1;
+    // Starts over from the true residual, also when rHat became orthogonal
+    // to the residual or omega vanished, instead of dividing by ~0
+    const auto restart = [&] {
+        a.Multiply(x.data(), v.data(), threads);
+        for (size_t i = 0; i < n; i++) {
+            r[i] = b[i] - v[i];
+        }
+        rHat = r;
+        std::fill(p.begin(), p.end(), T(0));
+        std::fill(v.begin(), v.end(), T(0));
+        rho = alpha = omega = 1;
+        rNorm = rHatNorm = sqrt(Dot(r, r, threads));
+    };
+    restart();
+    const T epsilon = std::numeric_limits<T>::epsilon();
+    while (result.iterations < maxIterations && rNorm > tolerance * bNorm) {
+        T rhoNext = Dot(rHat, r, threads);
+        // Negated so that NaN restarts too
+        if (!(abs(rhoNext) > epsilon * rHatNorm * rNorm && abs(omega) > epsilon)) {
+            restart();
+            rhoNext = rNorm * rNorm;
+            if (rNorm <= tolerance * bNorm) { break; }
+        }
+        const T beta = (rhoNext / rho) * (alpha / omega);
+        rho = rhoNext;
+        ParallelFor(n, sparse::chunk, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                p[i] = r[i] + beta * (p[i] - omega * v[i]);
+            }
+        }, threads);
+        preconditioner.Apply(p, pHat, threads);
+        a.Multiply(pHat.data(), v.data(), threads);
+        alpha = rho / Dot(rHat, v, threads);
+        const T ss = sparse::Reduce<T>(n, [&](size_t begin, size_t end) {
+            T sum = 0;
+            for (size_t i = begin; i < end; i++) {
+                s[i] = r[i] - alpha * v[i];
+                sum += s[i] * s[i];
+            }
+            return sum;
+        }, threads);
+        result.iterations++;
+        if (sqrt(ss) <= tolerance * bNorm) {
+            for (size_t i = 0; i < n; i++) {
+                x[i] += alpha * pHat[i];
+            }
+            rNorm = sqrt(ss);
+            break;
+        }
+        preconditioner.Apply(s, sHat, threads);
+        a.Multiply(sHat.data(), t.data(), threads);
+        omega = Dot(t, s, threads) / Dot(t, t, threads);
+        const T rr = sparse::Reduce<T>(n, [&](size_t begin, size_t end) {
+            T sum = 0;
+            for (size_t i = begin; i < end; i++) {
+                x[i] += alpha * pHat[i] + omega * sHat[i];
+                r[i] = s[i] - omega * t[i];
+                sum += r[i] * r[i];
+            }
+            return sum;
+        }, threads);
+        rNorm = sqrt(rr);
+    }
+    result.relativeResidual = double(rNorm / bNorm);
+    result.converged = rNorm <= tolerance * bNorm;
+    return result;
+}
+
+typedef TripletT<float> Triplet;
+typedef CsrMatrixT<float> CsrMatrix;
+typedef JacobiPreconditionerT<float> JacobiPreconditioner;
+typedef IncompleteCholeskyT<float> IncompleteCholesky;
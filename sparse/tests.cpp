@@ -0,0 +1,252 @@
+#include "Sparse.h"
+#include <array>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    constexpr size_t side = 5, n = side * side;
+
+    // 5-point Laplacian on a side x side grid, plus convection along x
+    // if `convection` isn't 0, which makes it non-symmetric
+    std::vector<TripletT<double>> GridTriplets(double convection) {
+        std::vector<TripletT<double>> triplets;
+        for (uint32_t y = 0; y < side; y++) {
+            for (uint32_t x = 0; x < side; x++) {
+                const uint32_t i = y * side + x;
+                triplets.push_back({i, i, 4});
+                if (x > 0) { triplets.push_back({i, i - 1, -1 - convection}); }
+                if (x + 1 < side) { triplets.push_back({i, i + 1, -1 + convection}); }
+                if (y > 0) { triplets.push_back({i, i - uint32_t(side), -1}); }
+                if (y + 1 < side) { triplets.push_back({i, i + uint32_t(side), -1}); }
+            }
+        }
+        return triplets;
+    }
+
+    template <size_t rows, size_t cols>
+    Matrix<rows, cols, double> Dense(const CsrMatrixT<double>& a) {
+        Matrix<rows, cols, double> m;
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++) {
+                m(i, j) = a(i, j);
+            }
+        }
+        return m;
+    }
+
+    // Solution of the dense system [A | b] by Gauss-Jordan elimination
+    std::vector<double> DenseSolve(const CsrMatrixT<double>& a, const std::vector<double>& b) {
+        Matrix<n, n + 1, double> m;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                m(i, j) = a(i, j);
+            }
+            m(i, n) = b[i];
+        }
+        m.Gauss();
+        std::vector<double> x (n);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = m(i, n);
+        }
+        return x;
+    }
+
+    double MaxDifference(const std::vector<double>& a, const std::vector<double>& b) {
+        REQUIRE(a.size() == b.size());
+        double max = 0;
+        for (size_t i = 0; i < a.size(); i++) {
+            max = std::max(max, std::abs(a[i] - b[i]));
+        }
+        return max;
+    }
+
+    std::vector<double> RandomVector(size_t size, std::mt19937& rng) {
+        std::uniform_real_distribution<double> u (-1, 1);
+        std::vector<double> v (size);
+        for (double& e : v) {
+            e = u(rng);
+        }
+        return v;
+    }
+
+    enum Solver { CG, BiCG };
+
+    template <typename Preconditioner>
+    void CheckSolve(Solver solver, const CsrMatrixT<double>& a, const Preconditioner& preconditioner,
+                    const std::vector<double>& b, const std::vector<double>& expected) {
+        std::vector<double> x;
+        const SolveResult r = solver == CG ? ConjugateGradient(a, b, x, preconditioner, 1e-10, 200)
+                                           : BiCGSTAB(a, b, x, preconditioner, 1e-10, 200);
+        CHECK(r.converged);
+        CHECK(r.relativeResidual <= 1e-10);
+        CHECK(r.iterations > 0);
+        CHECK(MaxDifference(x, expected) <= 1e-8);
+    }
+}
+
+TEST_CASE("[Sparse] duplicate triplets are summed") {
+    const std::vector<TripletT<double>> triplets {
+        {1, 2, 1.5}, {0, 0, 1}, {1, 0, 2}, {1, 2, 2.5}, {0, 0, -3}, {2, 1, 7}, {1, 2, 1},
+    };
+    const auto a = CsrMatrixT<double>::FromTriplets(3, 3, triplets);
+    CHECK(a.NonZeros() == 4);
+    CHECK(a.rowStart == std::vector<size_t> {0, 1, 3, 4});
+    // Sorted by column within each row
+    CHECK(a.colIndex == std::vector<uint32_t> {0, 0, 2, 1});
+    CHECK(a(0, 0) == -2);
+    CHECK(a(1, 0) == 2);
+    CHECK(a(1, 2) == 5);
+    CHECK(a(2, 1) == 7);
+    CHECK(a(2, 2) == 0);
+    CHECK(a.Diagonal() == std::vector<double> {-2, 0, 0});
+
+    // Overlapping blocks, as from two elements sharing a node
+    std::vector<TripletT<double>> blocks;
+    const Matrix<2, 2, double> k ({2, -1, -1, 2});
+    sparse::AppendBlock(blocks, k, std::array<uint32_t, 2> {0, 1}, std::array<uint32_t, 2> {0, 1});
+    sparse::AppendBlock(blocks, k, std::array<uint32_t, 2> {1, 2}, std::array<uint32_t, 2> {1, 2});
+    const auto b = CsrMatrixT<double>::FromTriplets(3, 3, blocks);
+    CHECK(b.NonZeros() == 7);
+    CHECK(b(0, 0) == 2);
+    CHECK(b(1, 1) == 4);
+    CHECK(b(2, 1) == -1);
+    CHECK(b(0, 2) == 0);
+
+    const auto empty = CsrMatrixT<double>::FromTriplets(2, 3, {});
+    CHECK(empty.NonZeros() == 0);
+    CHECK(empty * std::vector<double> {1, 2, 3} == std::vector<double> {0, 0});
+}
+
+TEST_CASE("[Sparse] out of range triplets are rejected") {
+    CHECK_THROWS_AS((void)CsrMatrixT<double>::FromTriplets(3, 4, {{0, 0, 1}, {3, 0, 1}}), std::out_of_range);
+    CHECK_THROWS_AS((void)CsrMatrixT<double>::FromTriplets(3, 4, {{2, 4, 1}}), std::out_of_range);
+    CHECK_THROWS_AS((void)CsrMatrixT<double>::FromTriplets(0, 0, {{0, 0, 1}}), std::out_of_range);
+    CHECK_NOTHROW((void)CsrMatrixT<double>::FromTriplets(3, 4, {{2, 3, 1}}));
+}
+
+TEST_CASE("[Sparse] matrix-vector product matches the dense product") {
+    std::mt19937 rng {1};
+    std::uniform_int_distribution<uint32_t> row (0, 6), col (0, 4);
+    std::uniform_real_distribution<double> u (-1, 1);
+    std::vector<TripletT<double>> triplets;
+    for (int i = 0; i < 30; i++) {
+        triplets.push_back({row(rng), col(rng), u(rng)});
+    }
+    const auto a = CsrMatrixT<double>::FromTriplets(7, 5, triplets);
+    const Matrix<7, 5, double> dense = Dense<7, 5>(a);
+    const std::vector<double> x = RandomVector(5, rng);
+    Matrix<5, 1, double> column;
+    for (size_t i = 0; i < 5; i++) {
+        column[i] = x[i];
+    }
+    const Matrix<7, 1, double> expected = dense * column;
+    for (const size_t threads : {size_t(0), size_t(1), size_t(3)}) {
+        std::vector<double> y (7);
+        a.Multiply(x.data(), y.data(), threads);
+        for (size_t i = 0; i < 7; i++) {
+            CHECK(std::abs(y[i] - expected[i]) <= 1e-12);
+        }
+    }
+
+    // Larger than one chunk of rows, so it is split between threads
+    const size_t big = 3 * sparse::chunk + 17;
+    std::vector<TripletT<double>> band;
+    for (uint32_t i = 0; i < big; i++) {
+        band.push_back({i, i, double(i % 7)});
+        band.push_back({i, (i + 5) % uint32_t(big), 0.5});
+    }
+    const auto b = CsrMatrixT<double>::FromTriplets(big, big, band);
+    const std::vector<double> bx = RandomVector(big, rng);
+    std::vector<double> y1 (big), y4 (big);
+    b.Multiply(bx.data(), y1.data(), 1);
+    b.Multiply(bx.data(), y4.data(), 4);
+    CHECK(y1 == y4);
+    for (size_t i = 0; i < big; i += 997) {
+        CHECK(std::abs(y1[i] - (double(i % 7) * bx[i] + 0.5 * bx[(i + 5) % big])) <= 1e-12);
+    }
+}
+
+TEST_CASE("[Sparse] solvers match Gauss on a symmetric positive definite system") {
+    std::mt19937 rng {2};
+    const auto a = CsrMatrixT<double>::FromTriplets(n, n, GridTriplets(0));
+    const std::vector<double> b = RandomVector(n, rng);
+    const std::vector<double> expected = DenseSolve(a, b);
+    const JacobiPreconditionerT<double> jacobi (a);
+    const IncompleteCholeskyT<double> ic (a);
+    CHECK(ic.shift == 0);
+    CheckSolve(CG, a, IdentityPreconditioner {}, b, expected);
+    CheckSolve(CG, a, jacobi, b, expected);
+    CheckSolve(CG, a, ic, b, expected);
+    CheckSolve(BiCG, a, IdentityPreconditioner {}, b, expected);
+    CheckSolve(BiCG, a, jacobi, b, expected);
+    CheckSolve(BiCG, a, ic, b, expected);
+
+    // An initial guess of the wrong size is resized, b = 0 gives x = 0
+    std::vector<double> x (3, 1.0);
+    CHECK(ConjugateGradient(a, std::vector<double>(n), x).converged);
+    CHECK(x == std::vector<double>(n));
+    // Starting at the solution takes no iterations
+    x = expected;
+    CHECK(ConjugateGradient(a, b, x, ic, 1e-6).iterations == 0);
+}
+
+TEST_CASE("[Sparse] BiCGSTAB matches Gauss on a non-symmetric system") {
+    std::mt19937 rng {3};
+    const auto a = CsrMatrixT<double>::FromTriplets(n, n, GridTriplets(0.8));
+    REQUIRE(a(1, 0) != a(0, 1));
+    const std::vector<double> b = RandomVector(n, rng);
+    const std::vector<double> expected = DenseSolve(a, b);
+    CheckSolve(BiCG, a, IdentityPreconditioner {}, b, expected);
+    CheckSolve(BiCG, a, JacobiPreconditionerT<double>(a), b, expected);
+    // Built from the lower triangle only, still a useful preconditioner here
+    CheckSolve(BiCG, a, IncompleteCholeskyT<double>(a), b, expected);
+}
+
+TEST_CASE("[Sparse] BiCGSTAB restarts when omega vanishes") {
+    // In the first iteration t = A * s is orthogonal to s for the rotation-like
+    // block, so omega = 0 and the next beta would divide by it
+    const auto a = CsrMatrixT<double>::FromTriplets(4, 4, {{0, 0, 1}, {0, 1, 1}, {1, 0, -1}, {2, 2, 2}, {3, 3, 3}});
+    const std::vector<double> b {1, 0, 1, 1};
+    std::vector<double> x;
+    const SolveResult r = BiCGSTAB(a, b, x, IdentityPreconditioner {}, 1e-10, 100);
+    CHECK(r.converged);
+    CHECK(r.relativeResidual <= 1e-10);
+    const std::vector<double> expected {0, 1, 0.5, 1.0 / 3};
+    CHECK(MaxDifference(x, expected) <= 1e-9);
+}
+
+TEST_CASE("[Sparse] incomplete Cholesky shifts the diagonal when a pivot breaks down") {
+    // Kershaw's matrix: symmetric positive definite, but zero fill-in
+    // incomplete Cholesky hits a negative pivot
+    std::vector<TripletT<double>> kershaw;
+    const double values[4][4] = {{3, -2, 0, 2}, {-2, 3, -2, 0}, {0, -2, 3, -2}, {2, 0, -2, 3}};
+    for (uint32_t i = 0; i < 4; i++) {
+        for (uint32_t j = 0; j < 4; j++) {
+            if (values[i][j] != 0) { kershaw.push_back({i, j, values[i][j]}); }
+        }
+    }
+    const auto a = CsrMatrixT<double>::FromTriplets(4, 4, kershaw);
+    const IncompleteCholeskyT<double> ic (a);
+    CHECK(ic.shift > 0);
+    CHECK(ic.lower.NonZeros() == 8);
+    std::vector<double> x;
+    const std::vector<double> b {1, 2, 3, 4};
+    CHECK(ConjugateGradient(a, b, x, ic, 1e-12).converged);
+    // Exact solution of A * x = b
+    const std::vector<double> expected {-1, 14, 21, 16};
+    CHECK(MaxDifference(x, expected) <= 1e-9);
+
+    // A negative diagonal stays negative when shifted, so it falls back to sqrt(|diag(A)|)
+    const auto negative = CsrMatrixT<double>::FromTriplets(3, 3, {{0, 0, -4}, {1, 1, -9}, {1, 0, 1}, {0, 1, 1}, {2, 2, 0}});
+    const IncompleteCholeskyT<double> fallback (negative);
+    CHECK(fallback.shift > 1);
+    CHECK(fallback.lower.NonZeros() == 3);
+    CHECK(fallback.lower.values == std::vector<double> {2, 3, 1});
+    std::vector<double> z (3);
+    fallback.Apply({4, 9, 5}, z);
+    CHECK(z == std::vector<double> {1, 1, 5});
+}
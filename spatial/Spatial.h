@@ -0,0 +1,374 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include "Vector.h"
+#include "Parallel.h"
+
+///Number of coordinates and their type for point types usable with KdTreeT
+template <typename P>
+struct PointTraits;
+
+template <typename T>
+struct PointTraits<Vector3T<T>> {
+    using value_type = T;
+    static constexpr size_t dims = 3;
+};
+
+template <typename T>
+struct PointTraits<Vector2T<T>> {
+    using value_type = T;
+    static constexpr size_t dims = 2;
+};
+
+#ifndef NO_MATRIX_DEP
+template <size_t N, typename T>
+struct PointTraits<VectorS<N, T>> {
+    using value_type = T;
+    static constexpr size_t dims = N;
+};
+#endif /* NO_MATRIX_DEP */
+
+
+namespace spatial {
+    constexpr size_t lanes = 8;
+
+    ///k nearest found so far, sorted by distance, in caller-provided arrays
+    template <typename T>
+    struct Neighbors {
+        uint32_t* index;
+        T* distSqr;
+        size_t k;
+        size_t size = 0;
+
+        [[nodiscard]] constexpr T Worst() const {
+            return size < k ? std::numeric_limits<T>::max() : distSqr[size - 1];
+        }
+
+        constexpr void Insert(uint32_t i, T d) {
+            size_t pos = size < k ? size++ : k - 1;
+            for (; pos > 0 && distSqr[pos - 1] > d; pos--) {
+                index[pos] = index[pos - 1];
+                distSqr[pos] = distSqr[pos - 1];
+            }
+            index[pos] = i;
+            distSqr[pos] = d;
+        }
+    };
+
+    template <typename P>
+    [[nodiscard]] constexpr typename PointTraits<P>::value_type DistanceSqr(const P& a, const P& b) {
+        typename PointTraits<P>::value_type sum = 0;
+        for (size_t d = 0; d < PointTraits<P>::dims; d++) {
+            const auto t = a[int(d)] - b[int(d)];
+            sum += t * t;
+        }
+        return sum;
+    }
+
+    ///Calls f(i, squared distance) for every point. Distances of full blocks
+    ///of 8 are computed before the (branchy) callbacks. Points with fewer than
+    ///8 coordinates are transposed to one array per dimension first, so that
+    ///the block vectorizes across points; longer points are scanned one by one,
+    ///the transposition would cost more than it saves
+    template <typename P, typename F>
+    void ForEachDistanceSqr(const P* points, size_t count, const P& query, F&& f) {
+        using T = typename PointTraits<P>::value_type;
+        constexpr size_t dims = PointTraits<P>::dims;
+        std::array<T, dims> q;
+        for (size_t dim = 0; dim < dims; dim++) {
+            q[dim] = query[int(dim)];
+        }
+        const size_t full = count / lanes * lanes;
+        for (size_t base = 0; base < full; base += lanes) {
+            T d[lanes] = {};
+            if constexpr (dims < lanes) {
+                T c[dims][lanes];
+                for (size_t j = 0; j < lanes; j++) {
+                    for (size_t dim = 0; dim < dims; dim++) {
+                        c[dim][j] = points[base + j][int(dim)];
+                    }
+                }
+                for (size_t dim = 0; dim < dims; dim++) {
+                    for (size_t j = 0; j < lanes; j++) {
+                        const T t = c[dim][j] - q[dim];
+                        d[j] += t * t;
+                    }
+                }
+            } else {
+                for (size_t j = 0; j < lanes; j++) {
+                    d[j] = DistanceSqr(points[base + j], query);
+                }
+            }
+            for (size_t j = 0; j < lanes; j++) {
+                f(base + j, d[j]);
+            }
+        }
+        for (size_t i = full; i < count; i++) {
+            f(i, DistanceSqr(points[i], query));
+        }
+    }
+
+    ///k nearest of `count` points to `query`, nearest first. Writes up to k indices
+    ///and squared distances, returns how many.
+    ///Faster than KdTreeT for tiny sets and high dimensions, see README.md
+    template <typename P>
+    size_t KNearestBruteForce(const P* points, size_t count, const P& query, size_t k,
+                              uint32_t* indices, typename PointTraits<P>::value_type* distSqr) {
+        using T = typename PointTraits<P>::value_type;
+        if (k == 0) { return 0; }
+        Neighbors<T> best {indices, distSqr, k};
+        ForEachDistanceSqr(points, count, query, [&best](size_t i, T d) {
+            if (d < best.Worst()) { best.Insert(uint32_t(i), d); }
+        });
+        return best.size;
+    }
+
+    ///Appends indices of points within `radius` (inclusive) of `query`
+    template <typename P>
+    void RadiusBruteForce(const P* points, size_t count, const P& query,
+                          typename PointTraits<P>::value_type radius, std::vector<uint32_t>& out) {
+        using T = typename PointTraits<P>::value_type;
+        const T r2 = radius * radius;
+        ForEachDistanceSqr(points, count, query, [&out, r2](size_t i, T d) {
+            if (d <= r2) { out.push_back(uint32_t(i)); }
+        });
+    }
+}
+
+
+///Static k-d tree over a contiguous point array (Vector3T, Vector2T, VectorS<N>).
+///Nodes are flattened in depth-first order (left child follows its parent),
+///leaves hold buckets of up to `leafSize` points whose coordinates are copied
+///in leaf order, one array per dimension, so leaf scans are linear and vectorize.
+///The top levels are built in parallel. The tree doesn't reference the
+///input after construction, results are indices into it.
+template <typename P>
+class KdTreeT {
+public:
+    using value_type = typename PointTraits<P>::value_type;
+    static constexpr size_t dims = PointTraits<P>::dims;
+
+    struct Node {
+        value_type split;
+        uint32_t axis;   // dims for leaves
+        uint32_t first;  // Inner nodes: right child. Leaves: first point
+        uint32_t last;   // Leaves: one past the last point
+    };
+
+    KdTreeT() = default;
+
+    ///`threads == 0` uses std::thread::hardware_concurrency()
+    KdTreeT(const P* points, size_t count, size_t leafSize = 16, size_t threads = 0)
+        : count(count), leafSize(std::max<size_t>(leafSize, 1)) {
+        if (count == 0) { return; }
+        // Points move with their indices, so that every pass of the build
+        // reads them in order instead of gathering through ids
+        std::vector<Entry> entries (count);
+        for (size_t i = 0; i < count; i++) {
+            entries[i] = Entry {points[i], uint32_t(i)};
+        }
+        nodes.resize(NodeCount(count));
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_t parallelDepth = 0;
+        while ((size_t(1) << parallelDepth) < threads) { parallelDepth++; }
+        Build(entries.data(), 0, 0, count, parallelDepth);
+
+        ids.resize(count);
+        coords.resize(dims * count);
+        ParallelFor(count, 1 << 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                ids[i] = entries[i].id;
+                for (size_t d = 0; d < dims; d++) {
+                    coords[d * count + i] = entries[i].point[int(d)];
+                }
+            }
+        }, threads);
+    }
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] const std::vector<Node>& Nodes() const { return nodes; }
+
+    ///k nearest points, nearest first. Writes up to k indices and squared
+    ///distances, returns how many
+    size_t KNearest(const P& query, size_t k, uint32_t* indices, value_type* distSqr) const {
+        spatial::Neighbors<value_type> best {indices, distSqr, k};
+        if (count == 0 || k == 0) { return 0; }
+        std::array<std::pair<uint32_t, value_type>, 64> stack;
+        size_t top = 0;
+        stack[top++] = {0, value_type(0)};
+        while (top > 0) {
+            const auto [start, planeSqr] = stack[--top];
+            if (planeSqr > best.Worst()) { continue; }
+            uint32_t n = Descend(query, start, best.Worst(), stack, top);
+            ScanLeaf(nodes[n], query, best);
+        }
+        return best.size;
+    }
+
+    ///Index of the nearest point, size() if the tree is empty
+    [[nodiscard]] uint32_t Nearest(const P& query) const {
+        uint32_t index = uint32_t(count);
+        value_type d {};
+        KNearest(query, 1, &index, &d);
+        return index;
+    }
+
+    ///Appends indices of points within `radius` (inclusive) of `query`, in no particular order
+    void Radius(const P& query, value_type radius, std::vector<uint32_t>& out) const {
+        if (count == 0) { return; }
+        const value_type r2 = radius * radius;
+        std::array<std::pair<uint32_t, value_type>, 64> stack;
+        size_t top = 0;
+        stack[top++] = {0, value_type(0)};
+        while (top > 0) {
+            const uint32_t n = Descend(query, stack[--top].first, r2, stack, top);
+            const Node& leaf = nodes[n];
+            std::array<value_type, spatial::lanes> d {};
+            for (uint32_t base = leaf.first; base < leaf.last; base += spatial::lanes) {
+                const size_t m = std::min<size_t>(spatial::lanes, leaf.last - base);
+                LeafDistances(base, m, query, d);
+                for (size_t j = 0; j < m; j++) {
+                    if (d[j] <= r2) { out.push_back(ids[base + j]); }
+                }
+            }
+        }
+    }
+
+    ///Appends indices of points inside the box [min, max] (inclusive), in no particular order
+    void Box(const P& min, const P& max, std::vector<uint32_t>& out) const {
+        if (count == 0) { return; }
+        std::array<uint32_t, 64> stack;
+        size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (node.axis != dims) {
+                const int a = int(node.axis);
+                const uint32_t self = uint32_t(&node - nodes.data());
+                if (max[a] >= node.split) { stack[top++] = node.first; }
+                if (min[a] <= node.split) { stack[top++] = self + 1; }
+                continue;
+            }
+            for (uint32_t i = node.first; i < node.last; i++) {
+                bool inside = true;
+                for (size_t d = 0; d < dims; d++) {
+                    const value_type c = coords[d * count + i];
+                    inside &= (c >= min[int(d)]) & (c <= max[int(d)]);
+                }
+                if (inside) { out.push_back(ids[i]); }
+            }
+        }
+    }
+
+private:
+    size_t count = 0;
+    size_t leafSize = 16;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> ids;          // Original index of each point, in leaf order
+    std::vector<value_type> coords;     // coords[d * count + i], in leaf order
+
+    struct Entry {
+        P point;
+        uint32_t id;
+    };
+
+    [[nodiscard]] size_t NodeCount(size_t n) const {
+        if (n <= leafSize) { return 1; }
+        return 1 + NodeCount(n / 2) + NodeCount(n - n / 2);
+    }
+
+    // Median split along the widest axis of the node's points
+    void Build(Entry* entries, uint32_t node, size_t begin, size_t end, size_t parallelDepth) {
+        Node& n = nodes[node];
+        if (end - begin <= leafSize) {
+            n = Node {value_type(0), uint32_t(dims), uint32_t(begin), uint32_t(end)};
+            return;
+        }
+        std::array<value_type, dims> lo, hi;
+        for (size_t d = 0; d < dims; d++) {
+            lo[d] = hi[d] = entries[begin].point[int(d)];
+        }
+        for (size_t i = begin + 1; i < end; i++) {
+            const P& p = entries[i].point;
+            for (size_t d = 0; d < dims; d++) {
+                lo[d] = std::min(lo[d], p[int(d)]);
+                hi[d] = std::max(hi[d], p[int(d)]);
+            }
+        }
+        size_t axis = 0;
+        for (size_t d = 1; d < dims; d++) {
+            if (hi[d] - lo[d] > hi[axis] - lo[axis]) { axis = d; }
+        }
+        const size_t mid = begin + (end - begin) / 2;
+        std::nth_element(entries + begin, entries + mid, entries + end, [axis](const Entry& a, const Entry& b) {
+            return a.point[int(axis)] < b.point[int(axis)];
+        });
+        const uint32_t right = uint32_t(node + 1 + NodeCount(mid - begin));
+        n = Node {entries[mid].point[int(axis)], uint32_t(axis), right, 0};
+
+        // Subtrees own disjoint ranges of ids and nodes
+        const size_t childDepth = parallelDepth > 0 ? parallelDepth - 1 : 0;
+        const auto child = [&](size_t i) {
+            if (i == 0) {
+                Build(entries, node + 1, begin, mid, childDepth);
+            } else {
+                Build(entries, right, mid, end, childDepth);
+            }
+        };
+        if (parallelDepth > 0 && end - begin >= (1 << 15)) {
+            ParallelFor(2, 1, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; i++) { child(i); }
+            }, 2);
+        } else {
+            child(0);
+            child(1);
+        }
+    }
+
+    // Walks from `n` to a leaf on the query's side, pushing far children
+    // that are within `limitSqr` of the query
+    template <typename Stack>
+    uint32_t Descend(const P& query, uint32_t n, value_type limitSqr, Stack& stack, size_t& top) const {
+        while (nodes[n].axis != dims) {
+            const Node& node = nodes[n];
+            const value_type diff = query[int(node.axis)] - node.split;
+            const uint32_t left = n + 1;
+            const uint32_t nearChild = diff < 0 ? left : node.first;
+            const uint32_t farChild = diff < 0 ? node.first : left;
+            const value_type planeSqr = diff * diff;
+            if (planeSqr <= limitSqr) { stack[top++] = {farChild, planeSqr}; }
+            n = nearChild;
+        }
+        return n;
+    }
+
+    void LeafDistances(size_t base, size_t m, const P& query, std::array<value_type, spatial::lanes>& d) const {
+        for (size_t j = 0; j < spatial::lanes; j++) { d[j] = 0; }
+        for (size_t dim = 0; dim < dims; dim++) {
+            const value_type q = query[int(dim)];
+            const value_type* c = &coords[dim * count + base];
+            for (size_t j = 0; j < m; j++) {
+                const value_type t = c[j] - q;
+                d[j] += t * t;
+            }
+        }
+    }
+
+    void ScanLeaf(const Node& leaf, const P& query, spatial::Neighbors<value_type>& best) const {
+        std::array<value_type, spatial::lanes> d {};
+        for (uint32_t base = leaf.first; base < leaf.last; base += spatial::lanes) {
+            const size_t m = std::min<size_t>(spatial::lanes, leaf.last - base);
+            LeafDistances(base, m, query, d);
+            for (size_t j = 0; j < m; j++) {
+                if (d[j] < best.Worst()) { best.Insert(ids[base + j], d[j]); }
+            }
+        }
+    }
+};
+
+typedef KdTreeT<Vector3> KdTree;
@@ -0,0 +1,83 @@
+// Nanoseconds per k-nearest query with KdTreeT and with the brute-force scan,
+// on uniformly distributed points. Generates the crossover table in README.md.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+#include "Spatial.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    template <typename P>
+    std::vector<P> RandomPoints(size_t count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> u (-1, 1);
+        std::vector<P> points (count);
+        for (P& p : points) {
+            for (size_t d = 0; d < PointTraits<P>::dims; d++) {
+                p[int(d)] = u(rng);
+            }
+        }
+        return points;
+    }
+
+    // Nanoseconds per call of query(i), best of a few runs
+    double Measure(size_t queries, const std::function<void(size_t)>& query) {
+        double best = 1e30;
+        for (int run = 0; run < 3; run++) {
+            const auto start = Clock::now();
+            for (size_t i = 0; i < queries; i++) {
+                query(i);
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            best = std::min(best, seconds / double(queries) * 1e9);
+        }
+        return best;
+    }
+
+    // Brute force and tree, in this order
+    template <typename P>
+    std::array<double, 2> Run(size_t count, size_t k) {
+        std::mt19937 rng {42};
+        const std::vector<P> points = RandomPoints<P>(count, rng);
+        const std::vector<P> queries = RandomPoints<P>(1024, rng);
+        const KdTreeT<P> tree (points.data(), points.size(), 16, 1);
+        // Roughly the same work per cell, at least 64 queries
+        const size_t n = std::max<size_t>(64, (size_t(1) << 22) / (count * PointTraits<P>::dims));
+        std::vector<uint32_t> index (k);
+        std::vector<float> distSqr (k);
+        uint64_t sink = 0;
+        const double brute = Measure(n, [&](size_t i) {
+            sink += spatial::KNearestBruteForce(points.data(), count, queries[i % queries.size()], k, index.data(), distSqr.data());
+            sink += index[0];
+        });
+        const double kd = Measure(n, [&](size_t i) {
+            sink += tree.KNearest(queries[i % queries.size()], k, index.data(), distSqr.data());
+            sink += index[0];
+        });
+        if (sink == 0) { std::printf(" "); }
+        return {brute, kd};
+    }
+}
+
+int main() {
+    std::printf("| points | 3D k=1 brute | 3D k=1 tree | 3D k=8 brute | 3D k=8 tree | 16D k=1 brute | 16D k=1 tree |\n");
+    std::printf("|-------:|-------:|------:|-------:|------:|-------:|--------:|\n");
+    for (const size_t count : {16, 64, 256, 1024, 4096, 65536}) {
+        const auto a = Run<Vector3>(count, 1);
+        const auto b = Run<Vector3>(count, 8);
+        const auto c = Run<VectorS<16>>(count, 1);
+        std::printf("| %6zu | %6.0f | %5.0f | %6.0f | %5.0f | %6.0f | %7.0f |\n",
+                    count, a[0], a[1], b[0], b[1], c[0], c[1]);
+    }
+
+    std::mt19937 rng {1};
+    const std::vector<Vector3> points = RandomPoints<Vector3>(size_t(1) << 21, rng);
+    const auto start = Clock::now();
+    const KdTree tree (points.data(), points.size(), 16, 1);
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("\nBuilding %zu 3D points on one thread: %.2f s\n", tree.size(), seconds);
+}
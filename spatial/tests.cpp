@@ -0,0 +1,151 @@
+#include "Spatial.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+namespace {
+    template <typename P>
+    std::vector<P> RandomPoints(size_t count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> u (-10, 10);
+        std::vector<P> points (count);
+        for (P& p : points) {
+            for (size_t d = 0; d < PointTraits<P>::dims; d++) {
+                p[int(d)] = u(rng);
+            }
+        }
+        return points;
+    }
+
+    template <typename P>
+    bool InBox(const P& p, const P& min, const P& max) {
+        for (size_t d = 0; d < PointTraits<P>::dims; d++) {
+            if (p[int(d)] < min[int(d)] || p[int(d)] > max[int(d)]) { return false; }
+        }
+        return true;
+    }
+
+    std::vector<uint32_t> Sorted(std::vector<uint32_t> v) {
+        std::sort(v.begin(), v.end());
+        return v;
+    }
+
+    // Tree and brute force may order equal distances differently, and
+    // sum the coordinates in a different order
+    template <typename P>
+    void CheckKNearest(const std::vector<P>& points, const KdTreeT<P>& tree, const P& query, size_t k) {
+        std::vector<uint32_t> treeIndex (k), bruteIndex (k);
+        std::vector<float> treeDist (k), bruteDist (k);
+        const size_t found = tree.KNearest(query, k, treeIndex.data(), treeDist.data());
+        REQUIRE(found == spatial::KNearestBruteForce(points.data(), points.size(), query, k, bruteIndex.data(), bruteDist.data()));
+        CHECK(found == std::min(k, points.size()));
+        for (size_t i = 0; i < found; i++) {
+            const float expected = spatial::DistanceSqr(points[bruteIndex[i]], query);
+            CHECK(std::abs(treeDist[i] - bruteDist[i]) <= 1e-5f * (1 + expected));
+            CHECK(std::abs(spatial::DistanceSqr(points[treeIndex[i]], query) - treeDist[i]) <= 1e-5f * (1 + expected));
+            if (i > 0) { CHECK(treeDist[i - 1] <= treeDist[i]); }
+        }
+        // No index twice
+        treeIndex.resize(found);
+        const std::vector<uint32_t> unique = Sorted(treeIndex);
+        CHECK(std::adjacent_find(unique.begin(), unique.end()) == unique.end());
+    }
+
+    template <typename P>
+    void CheckQueries(const std::vector<P>& points, size_t leafSize, std::mt19937& rng) {
+        const KdTreeT<P> tree (points.data(), points.size(), leafSize);
+        CHECK(tree.size() == points.size());
+        const std::vector<P> queries = RandomPoints<P>(40, rng);
+        std::uniform_real_distribution<float> radius (0.5f, 8), half (0, 6);
+        for (const P& query : queries) {
+            for (const size_t k : {size_t(1), size_t(8), size_t(37), points.size() + 5}) {
+                CheckKNearest(points, tree, query, k);
+            }
+            const float r = radius(rng);
+            std::vector<uint32_t> fromTree, fromBrute;
+            tree.Radius(query, r, fromTree);
+            spatial::RadiusBruteForce(points.data(), points.size(), query, r, fromBrute);
+            CHECK(Sorted(fromTree) == Sorted(fromBrute));
+
+            P min = query, max = query;
+            for (size_t d = 0; d < PointTraits<P>::dims; d++) {
+                min[int(d)] -= half(rng);
+                max[int(d)] += half(rng);
+            }
+            std::vector<uint32_t> inBox, expected;
+            tree.Box(min, max, inBox);
+            for (size_t i = 0; i < points.size(); i++) {
+                if (InBox(points[i], min, max)) { expected.push_back(uint32_t(i)); }
+            }
+            CHECK(Sorted(inBox) == expected);
+        }
+    }
+}
+
+TEST_CASE("[Spatial] 3D queries match brute force") {
+    std::mt19937 rng {1};
+    for (const size_t count : {size_t(1), size_t(7), size_t(100), size_t(5000)}) {
+        const std::vector<Vector3> points = RandomPoints<Vector3>(count, rng);
+        CheckQueries(points, 16, rng);
+        CheckQueries(points, 1, rng);
+    }
+}
+
+TEST_CASE("[Spatial] 16D queries match brute force") {
+    std::mt19937 rng {2};
+    const std::vector<VectorS<16>> points = RandomPoints<VectorS<16>>(2000, rng);
+    CheckQueries(points, 16, rng);
+}
+
+TEST_CASE("[Spatial] 2D queries match brute force") {
+    std::mt19937 rng {3};
+    const std::vector<Vector2> points = RandomPoints<Vector2>(3000, rng);
+    CheckQueries(points, 8, rng);
+}
+
+TEST_CASE("[Spatial] duplicate points") {
+    std::mt19937 rng {4};
+    // Few distinct positions, many copies, so splits fall between equal coordinates
+    const std::vector<Vector3> distinct = RandomPoints<Vector3>(5, rng);
+    std::vector<Vector3> points;
+    for (size_t i = 0; i < 600; i++) {
+        points.push_back(distinct[rng() % distinct.size()]);
+    }
+    points.push_back(Vector3(0));
+    points.push_back(Vector3(0));
+    CheckQueries(points, 4, rng);
+
+    const KdTree tree (points.data(), points.size(), 4);
+    uint32_t index[2];
+    float distSqr[2];
+    CHECK(tree.KNearest(Vector3(0), 2, index, distSqr) == 2);
+    CHECK((distSqr[0] == 0 && distSqr[1] == 0));
+    CHECK(index[0] != index[1]);
+    // A box around one position returns every copy
+    std::vector<uint32_t> inBox;
+    tree.Box(distinct[0], distinct[0], inBox);
+    CHECK(inBox.size() == size_t(std::count(points.begin(), points.end(), distinct[0])));
+}
+
+TEST_CASE("[Spatial] empty tree and k == 0") {
+    const KdTree empty;
+    uint32_t index = 7;
+    float distSqr = 0;
+    CHECK(empty.KNearest(Vector3(0), 3, &index, &distSqr) == 0);
+    CHECK(empty.Nearest(Vector3(0)) == 0);
+    std::vector<uint32_t> out;
+    empty.Radius(Vector3(0), 100, out);
+    empty.Box(Vector3(-100), Vector3(100), out);
+    CHECK(out.empty());
+
+    const std::vector<Vector3> points {Vector3(1), Vector3(2)};
+    const KdTree tree (points.data(), points.size());
+    CHECK(tree.KNearest(Vector3(0), 0, &index, &distSqr) == 0);
+    CHECK(spatial::KNearestBruteForce(points.data(), points.size(), Vector3(0), 0, &index, &distSqr) == 0);
+    CHECK(tree.Nearest(Vector3(1.9f)) == 1);
+    // Radius is inclusive
+    tree.Radius(Vector3(1, 1, 0), 1, out);
+    CHECK(out == std::vector<uint32_t> {0});
+}
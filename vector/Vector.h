@@ -1,16 +1,50 @@
 #pragma once
 #include <cmath>
+#include <array>
+#include <ostream>
+#include <algorithm>
+#include <type_traits>
 
 #ifndef NO_MATRIX_DEP
 #include "Matrix.h"
 #endif /* NO_MATRIX_DEP */
 
+// Operation counters, see Profile.h
+#ifndef MATRIX_PROFILE_BEGIN
+#ifdef MATRIX_PROFILE
+#include "Profile.h"
+#else
+#define MATRIX_PROFILE_BEGIN(start)
+#define MATRIX_PROFILE_END(op, rows, cols, flops, start)
+#endif /* MATRIX_PROFILE */
+#endif /* MATRIX_PROFILE_BEGIN */
+
+#ifndef MATRIX_REAL_TYPE
+#define MATRIX_REAL_TYPE
+///Type of non-integer results (magnitudes, angles, factors) for elements of type T.
+///Integers and 16 bit floats use float. Specialize it for custom number types.
+template <typename T>
+struct RealType {
+    using type = typename std::conditional<
+        std::is_floating_point<T>::value && (sizeof(T) >= sizeof(float)),
+        T, float>::type;
+};
+#endif /* MATRIX_REAL_TYPE */
+
+#ifndef MATRIX_ACCUMULATOR
+#define MATRIX_ACCUMULATOR
+///Type used for intermediate sums in products and dot products.
+///Specialize it for element types that should widen while accumulating,
+///e.g. 16 bit floats accumulate in float.
+template <typename T>
+struct MatrixAccumulator { using type = T; };
+#endif /* MATRIX_ACCUMULATOR */
+
 #ifndef NO_MATRIX_DEP
 template <size_t N = 3, typename T = float>
 class VectorS : public Matrix<N, 1, T> {
-    using real_t = typename std::conditional<
-        std::is_floating_point<T>::value && (sizeof(T) >= sizeof(float)),
-        T, float>::type;
+    using real_t = typename RealType<T>::type;
+    using accum_t = typename MatrixAccumulator<T>::type;
 public:
     constexpr VectorS() : Matrix<N, 1, T>() {}
     constexpr VectorS(const std::array<T, N>& data) : Matrix<N, 1, T>(data) {}
@@ -21,10 +55,10 @@ public:
         }
         this->data[i] = last;
     }
-    constexpr VectorS(const VectorS<N, T>& other) : Matrix<N, 1, T>(other) {}
+    constexpr VectorS(const VectorS<N, T>& other) = default;
     template <typename _T>
     constexpr VectorS(const VectorS<N, _T>& other) : Matrix<N, 1, T>(other) {}
-    constexpr VectorS(VectorS<N, T>&& other) : Matrix<N, 1, T>(std::move(other)) {}
+    constexpr VectorS(VectorS<N, T>&& other) = default;
 
     constexpr VectorS(const Matrix<N, 1, T>& other) : Matrix<N, 1, T>(other) {}
     template <typename _T>
@@ -32,8 +66,8 @@ public:
     constexpr VectorS(Matrix<N, 1, T>&& other) : Matrix<N, 1, T>(std::move(other)) {}
 
 
-    VectorS<N, T>& operator=(const VectorS<N, T>& other)& { this->data = other.data; return *this; }
-    VectorS<N, T>& operator=(VectorS<N, T>&& other)& { this->data = std::move(other.data); return *this; }
+    VectorS<N, T>& operator=(const VectorS<N, T>& other)& = default;
+    VectorS<N, T>& operator=(VectorS<N, T>&& other)& = default;
 
     [[nodiscard]] explicit constexpr operator bool() const {
         for (const auto& e : *this) {
@@ -53,15 +87,17 @@ public:
     }
 
     [[nodiscard]] constexpr real_t Magnitude() const {
-        return std::sqrt(MagnitudeSqr());
+        // Allow non-std overloads of sqrt() for T
+        using std::sqrt;
+        return sqrt(MagnitudeSqr());
     }
 
     [[nodiscard]] constexpr T MagnitudeSqr() const {
-        T sum = 0;
+        accum_t sum = 0;
         for (const auto& e : *this) {
-            sum += e*e;
+            sum += accum_t(e) * accum_t(e);
         }
-        return sum;
+        return T(sum);
     }
 
     ///Remember to check if magnitude is zero
@@ -103,7 +139,8 @@ public:
 
     ///Remember to check if magnitude is zero
     [[nodiscard]] constexpr static real_t AngleBetween(const VectorS<N, T>& v1, const VectorS<N, T>& v2) {
-        return std::acos(AngleBetweenCos(v1, v2));
+        using std::acos;
+        return acos(AngleBetweenCos(v1, v2));
     }
 
     ///Remember to check if magnitude is zero
@@ -131,11 +168,11 @@ public:
     }
 
     [[nodiscard]] constexpr static T Dot(const VectorS<N, T>& v1, const VectorS<N, T>& v2) {
-        T sum = 0;
+        accum_t sum = 0;
         for (size_t i = 0; i < N; i++) {
-            sum += v1[i] * v2[i];
+            sum += accum_t(v1[i]) * accum_t(v2[i]);
         }
-        return sum;
+        return T(sum);
     }
 
     [[nodiscard]] constexpr static VectorS<N, T> Lerp(VectorS<N, T> from, const VectorS<N, T>& to, float t) {
@@ -161,20 +198,14 @@ public:
 
 template <typename T>
 struct Vector3T {
-    using real_t = typename std::conditional<
-        std::is_floating_point<T>::value && (sizeof(T) >= sizeof(float)),
-        T, float>::type;
+    using real_t = typename RealType<T>::type;
+    using accum_t = typename MatrixAccumulator<T>::type;
     Vector3T() = default;
     constexpr Vector3T(T x, T y, T z) : x(x), y(y), z(z) { }
     explicit constexpr Vector3T(T v) : x(v), y(v), z(v) { }
     explicit constexpr Vector3T(const std::array<T, 3>& v) : x(v[0]), y(v[1]), z(v[2]) { }
-    constexpr Vector3T(const Vector3T<T>& v) : x(v.x), y(v.y), z(v.z) { }
-    Vector3T<T>& operator=(const Vector3T<T>& v) {
-        x = v.x;
-        y = v.y;
-        z = v.z;
-        return *this;
-    }
+    constexpr Vector3T(const Vector3T<T>& v) = default;
+    Vector3T<T>& operator=(const Vector3T<T>& v) = default;
     [[nodiscard]] explicit constexpr operator bool() const {
         return x || y || z;
     }
@@ -233,21 +264,27 @@ struct Vector3T {
         return Vector3T {-x, -y, -z};
     }
     [[nodiscard]] constexpr real_t Magnitude() const {
-        return std::hypot(x, y, z);
+        // Allow non-std overloads of hypot() for T
+        using std::hypot;
+        return hypot(x, y, z);
     }
     [[nodiscard]] constexpr T MagnitudeSqr() const {
-        return (x * x + y * y + z * z);
+        return T(accum_t(x) * accum_t(x) + accum_t(y) * accum_t(y) + accum_t(z) * accum_t(z));
     }
     [[nodiscard]] static constexpr Vector3T<T> Rotate(const Vector3T<T>& vPoint, Vector3T<T> vAxis, real_t angle) {
+        MATRIX_PROFILE_BEGIN(profile_start);
         vAxis.Normalize();
         const real_t half_ang = angle / 2;
-        const real_t sin_half_ang = std::sin(half_ang);
-        const real_t s1 = std::cos(half_ang);
+        using std::sin, std::cos;
+        const real_t sin_half_ang = sin(half_ang);
+        const real_t s1 = cos(half_ang);
         const Vector3T<T> v1 {sin_half_ang * vAxis.x, sin_half_ang * vAxis.y, sin_half_ang * vAxis.z};
         const Vector3T<T> v3 = -v1;
         const real_t s12 = -Vector3T<T>::Dot(v1, vPoint);
         const Vector3T<T> v12 = vPoint * s1 + Vector3T<T>::Cross(v1, vPoint);
-        return v3 * s12 + v12 * s1 + Vector3T<T>::Cross(v12, v3);
+        const Vector3T<T> ret = v3 * s12 + v12 * s1 + Vector3T<T>::Cross(v12, v3);
+        MATRIX_PROFILE_END(Rotate, 3, 1, 48, profile_start);
+        return ret;
     }
     ///Remember to check if magnitude is zero
     [[nodiscard]] constexpr Vector3T<T> Normalized() const {
@@ -266,7 +303,8 @@ struct Vector3T {
         if (Magnitude() > mag) { *this *= mag / Magnitude(); }
     }
     [[nodiscard]] constexpr T Max() const {
-        return std::max({std::abs(x), std::abs(y), std::abs(z)});
+        using std::abs;
+        return std::max({abs(x), abs(y), abs(z)});
     }
     ///Remember to check if magnitude is zero
     [[nodiscard]] constexpr Vector3T<T> WithMax(T max) const {
@@ -278,11 +316,13 @@ struct Vector3T {
     }
     ///Remember to check if magnitude is zero
     [[nodiscard]] static constexpr real_t AngleBetween(const Vector3T<T>& v1, const Vector3T<T>& v2) {
-        return std::acos(AngleBetweenCos(v1, v2));
+        using std::acos;
+        return acos(AngleBetweenCos(v1, v2));
     }
     ///Remember to check if magnitude is zero
     [[nodiscard]] static constexpr real_t AngleBetweenCos(const Vector3T<T>& v1, const Vector3T<T>& v2) {
-        const real_t lenlen = std::sqrt(v1.MagnitudeSqr() * v2.MagnitudeSqr());
+        using std::sqrt;
+        const real_t lenlen = sqrt(v1.MagnitudeSqr() * v2.MagnitudeSqr());
         return Dot(v1, v2) / lenlen;
     }
     ///Can be negative
@@ -299,7 +339,7 @@ struct Vector3T {
         return v - planeNormal * (Dot(planeNormal, v) / magsqr);
     }
     [[nodiscard]] static constexpr T Dot(const Vector3T<T>& v1, const Vector3T<T>& v2) {
-        return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+        return T(accum_t(v1.x) * accum_t(v2.x) + accum_t(v1.y) * accum_t(v2.y) + accum_t(v1.z) * accum_t(v2.z));
     }
     [[nodiscard]] static constexpr Vector3T<T> Cross(const Vector3T<T>& v1, const Vector3T<T>& v2) {
         return Vector3T<T> {v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z, v1.x * v2.y - v1.y * v2.x};
@@ -339,19 +379,14 @@ struct Vector3T {
 
 template <typename T>
 struct Vector2T {
-    using real_t = typename std::conditional<
-        std::is_floating_point<T>::value && (sizeof(T) >= sizeof(float)),
-        T, float>::type;
+    using real_t = typename RealType<T>::type;
+    using accum_t = typename MatrixAccumulator<T>::type;
     Vector2T() = default;
     constexpr Vector2T(T x, T y) : x(x), y(y) { }
     explicit constexpr Vector2T(T v) : x(v), y(v) { }
     explicit constexpr Vector2T(const std::array<T, 2>& v) : x(v[0]), y(v[1]) { }
-    constexpr Vector2T(const Vector2T<T>& v) : x(v.x), y(v.y) { }
-    Vector2T<T>& operator=(const Vector2T<T>& v) {
-        x = v.x;
-        y = v.y;
-        return *this;
-    }
+    constexpr Vector2T(const Vector2T<T>& v) = default;
+    Vector2T<T>& operator=(const Vector2T<T>& v) = default;
     [[nodiscard]] explicit constexpr operator bool() const {
         return x || y;
     }
@@ -406,14 +441,17 @@ struct Vector2T {
         return Vector2T {-x, -y};
     }
     [[nodiscard]] constexpr real_t Magnitude() const {
-        return std::hypot(x, y);
+        // Allow non-std overloads of hypot() for T
+        using std::hypot;
+        return hypot(x, y);
     }
     [[nodiscard]] constexpr T MagnitudeSqr() const {
-        return (x * x + y * y);
+        return T(accum_t(x) * accum_t(x) + accum_t(y) * accum_t(y));
     }
     [[nodiscard]] static constexpr Vector2T<T> Rotate(const Vector2T<T>& vPoint, real_t angle) {
-        real_t c = std::cos(angle);
-        real_t s = std::sin(angle);
+        using std::sin, std::cos;
+        real_t c = cos(angle);
+        real_t s = sin(angle);
         return Vector2T<T> {vPoint.x * c - vPoint.y * s, vPoint.x * s + vPoint.y * c};
     }
     ///Remember to check if magnitude is zero
@@ -433,7 +471,8 @@ struct Vector2T {
         if (Magnitude() > mag) { *this *= mag / Magnitude(); }
     }
     [[nodiscard]] constexpr T Max() const {
-        return std::max(std::abs(x), std::abs(y));
+        using std::abs;
+        return std::max(abs(x), abs(y));
     }
     ///Remember to check if magnitude is zero
     [[nodiscard]] constexpr Vector2T<T> WithMax(T max) const {
@@ -445,11 +484,13 @@ struct Vector2T {
     }
     ///Remember to check if magnitude is zero
     [[nodiscard]] static constexpr real_t AngleBetween(const Vector2T<T>& v1, const Vector2T<T>& v2) {
-        return std::acos(AngleBetweenCos(v1, v2));
+        using std::acos;
+        return acos(AngleBetweenCos(v1, v2));
     }
     ///Remember to check if magnitude is zero
     [[nodiscard]] static constexpr real_t AngleBetweenCos(const Vector2T<T>& v1, const Vector2T<T>& v2) {
-        const real_t lenlen = std::sqrt(v1.MagnitudeSqr() * v2.MagnitudeSqr());
+        using std::sqrt;
+        const real_t lenlen = sqrt(v1.MagnitudeSqr() * v2.MagnitudeSqr());
         return Dot(v1, v2) / lenlen;
     }
     ///Can be negative
@@ -461,7 +502,7 @@ struct Vector2T {
         return vProjectOn * (Dot(v, vProjectOn) / magsqr);
     }
     [[nodiscard]] static constexpr T Dot(const Vector2T<T>& v1, const Vector2T<T>& v2) {
-        return v1.x * v2.x + v1.y * v2.y;
+        return T(accum_t(v1.x) * accum_t(v2.x) + accum_t(v1.y) * accum_t(v2.y));
     }
     [[nodiscard]] static constexpr Vector2T<T> Lerp(const Vector2T<T>& from, const Vector2T<T>& to, real_t t) {
         return Vector2T<T> {from.x + (to.x - from.x)* t, from.y + (to.y - from.y)* t};
@@ -495,3 +536,25 @@ struct Vector2T {
 
 typedef Vector3T<float> Vector3;
 typedef Vector2T<float> Vector2;
+
+///Contiguous vectors as a flat array of 3 (or 2) components each,
+///e.g. to upload std::vector<Vector3> into a GPU buffer without copying
+template <typename T>
+[[nodiscard]] inline T* ComponentData(Vector3T<T>* v) noexcept { return reinterpret_cast<T*>(v); }
+template <typename T>
+[[nodiscard]] inline const T* ComponentData(const Vector3T<T>* v) noexcept { return reinterpret_cast<const T*>(v); }
+template <typename T>
+[[nodiscard]] inline T* ComponentData(Vector2T<T>* v) noexcept { return reinterpret_cast<T*>(v); }
+template <typename T>
+[[nodiscard]] inline const T* ComponentData(const Vector2T<T>* v) noexcept { return reinterpret_cast<const T*>(v); }
+
+static_assert(std::is_trivially_copyable<Vector3>::value, "Vector3T must be trivially copyable");
+static_assert(std::is_trivially_copyable<Vector2>::value, "Vector2T must be trivially copyable");
+static_assert(std::is_standard_layout<Vector3>::value, "Vector3T must be standard layout");
+static_assert(std::is_standard_layout<Vector2>::value, "Vector2T must be standard layout");
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3T must not have padding");
+static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2T must not have padding");
+#ifndef NO_MATRIX_DEP
+static_assert(std::is_trivially_copyable<VectorS<4>>::value, "VectorS must be trivially copyable");
+static_assert(std::is_standard_layout<VectorS<4>>::value, "VectorS must be standard layout");
+#endif /* NO_MATRIX_DEP */